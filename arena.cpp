@@ -0,0 +1,35 @@
+#include "arena.h"
+#include <cstdlib>
+#include <new>
+
+Arena::Arena(size_t chunkSize) : chunkSize(chunkSize) {}
+
+Arena::~Arena() {
+    for (auto& c : chunks) free(c.data);
+}
+
+// 当前块放不下：依次尝试后面已有的块（reset 之后留下的），都不够大时新申请一块插在当前块之后。
+// 超过块大小的请求单独占一块。
+void* Arena::grow(size_t bytes, size_t align) {
+    size_t next = chunks.empty() ? 0 : current + 1;
+    while (next < chunks.size() && chunks[next].size < bytes + align) next++;
+    if (next == chunks.size() || chunks[next].size < bytes + align) {
+        size_t size = bytes + align > chunkSize ? bytes + align : chunkSize;
+        char* data = static_cast<char*>(malloc(size));
+        if (!data) throw bad_alloc();
+        chunkAllocations++;
+        next = chunks.empty() ? 0 : current + 1;
+        chunks.insert(chunks.begin() + next, Chunk{ data, size });
+    }
+    current = next;
+    size_t base = reinterpret_cast<size_t>(chunks[current].data);
+    size_t offset = ((base + align - 1) & ~(align - 1)) - base;
+    used = offset + bytes;
+    return chunks[current].data + offset;
+}
+
+size_t Arena::reservedBytes() const {
+    size_t total = 0;
+    for (const auto& c : chunks) total += c.size;
+    return total;
+}
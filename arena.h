@@ -0,0 +1,76 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// === 区域（bump）分配器 ===
+// 从大块内存中顺序切出小块，不逐个释放：
+//   - mark() 记下当前位置，reset(mark) 把之后分配的内容整体作废，块留着给后面的分配复用；
+//   - 析构时才把所有块还给系统。
+// 只用于平凡类型（int、指针、位集的字、纯数据结构体），不调用构造和析构函数。
+// LR(1) 分析表构造用两个区域：临时区按状态整体重置，存放转移核心、闭包和中间位集；
+// 持久区只存放最终保留的项目集。
+class Arena {
+public:
+    struct Mark {
+        size_t chunk;
+        size_t used;
+    };
+
+private:
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+    vector<Chunk> chunks;
+    size_t current = 0;         // 当前块的下标
+    size_t used = 0;            // 当前块已用的字节数
+    size_t chunkSize;
+
+    long long chunkAllocations = 0; // 向系统申请块的次数
+    long long requests = 0;         // allocate 调用次数
+    long long requestedBytes = 0;
+    long long resets = 0;
+
+    void* grow(size_t bytes, size_t align);
+
+public:
+    explicit Arena(size_t chunkSize = 64 * 1024);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(max_align_t)) {
+        requests++;
+        requestedBytes += (long long)bytes;
+        if (current < chunks.size()) {
+            size_t offset = (used + align - 1) & ~(align - 1);
+            if (offset + bytes <= chunks[current].size) {
+                used = offset + bytes;
+                return chunks[current].data + offset;
+            }
+        }
+        return grow(bytes, align);
+    }
+    // n 个未初始化的 T
+    template <typename T>
+    T* allocArray(size_t n) { return static_cast<T*>(allocate(n * sizeof(T), alignof(T))); }
+
+    Mark mark() const { return Mark{ current, used }; }
+    void reset(const Mark& m) {
+        resets++;
+        current = m.chunk;
+        used = m.used;
+    }
+
+    long long getChunkAllocations() const { return chunkAllocations; }
+    long long getRequests() const { return requests; }
+    long long getRequestedBytes() const { return requestedBytes; }
+    long long getResets() const { return resets; }
+    size_t reservedBytes() const;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,761 @@
+#include "asmbackend.h"
+#include "tacutil.h"
+#include "vm.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include <sstream>
+#include <set>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// 可分配的寄存器，调用者保存的排在前面（用到被调用者保存的才需要压栈）
+const char* const gpr32[] = { "%esi", "%edi", "%r8d", "%r9d", "%r10d", "%r11d",
+                              "%ebx", "%r12d", "%r13d", "%r14d", "%r15d" };
+const char* const gpr64[] = { "%rsi", "%rdi", "%r8", "%r9", "%r10", "%r11",
+                              "%rbx", "%r12", "%r13", "%r14", "%r15" };
+const int numGPR = 11;
+const int firstCalleeSaved = 6;
+const int numXMM = 14;          // xmm2..xmm15；xmm0/xmm1 与 eax/ecx/edx 留作临时寄存器
+
+// 关系运算 < <= > >= == != 的条件码：int 用有符号比较，float 的 ucomiss 按无符号标志位
+// （float 值在这里总是有限的，不会出现 NaN，不需要检查 PF）
+const char* const intCC[6] = { "l", "le", "g", "ge", "e", "ne" };
+const char* const floatCC[6] = { "b", "be", "a", "ae", "e", "ne" };
+const int negatedRel[6] = { 3, 2, 1, 0, 5, 4 };
+
+// 以下两个判断对 int 运算符和带 '.' 后缀的 float 运算符都成立
+int relIndex(const string& op) {
+    static const char* const rel[] = { "<", "<=", ">", ">=", "==", "!=" };
+    string s = scalarOp(op);
+    for (int k = 0; k < 6; k++) if (s == rel[k]) return k;
+    return -1;
+}
+
+bool isArith(const string& op) {
+    string s = scalarOp(op);
+    return s == "+" || s == "-" || s == "*" || s == "/";
+}
+bool isReg(const string& x) { return !x.empty() && x[0] == '%'; }
+bool isXmm(const string& x) { return x.compare(0, 4, "%xmm") == 0; }
+bool isImm(const string& x) { return !x.empty() && x[0] == '$'; }
+bool isMem(const string& x) { return x.find('(') != string::npos; }
+
+// 活跃区间：覆盖名字活跃的第一条到最后一条指令（不区分区间内的空洞）
+struct Interval {
+    string name;
+    int start, end;
+    int reg = -1;       // 分到的寄存器编号，-1 表示溢出
+};
+
+class AsmEmitter {
+private:
+    vector<TAC> tac;
+    map<string, SlotType> types;
+    bool allocate;
+    int n;
+
+    vector<bool> fuseJump;          // i 处的比较与 i+1 处的条件跳转合并
+    vector<bool> fuseCopy;          // i 处的运算直接写入 i+1 处复写的目标
+    set<string> elided;             // 被合并掉、不需要位置的临时变量
+    vector<string> userVars;        // 按名字排序，决定 while_run 写出的顺序
+
+    map<string, string> loc;        // 名字 -> 操作数（寄存器或栈槽）
+    set<string> liveAtEntry;        // 入口处活跃、需要清零的名字
+    vector<bool> calleeUsed = vector<bool>(numGPR, false);
+    int numSpillSlots = 0;
+    int numAllocated = 0, numSpilled = 0;
+    map<uint32_t, string> floatLabels;
+    set<int> errorSites;
+    ostringstream body;
+
+    void findFusions();
+    void allocateRegisters();
+    int stateOffset() const;        // st 指针在栈帧中的位置
+
+    // 操作数
+    string floatConst(float f);
+    string intOperand(const string& name);
+    string floatOperand(const string& name, const string& scratch);
+    SlotType typeOf(const string& name) const;
+    string label(const string& target) const;
+
+    // 数据传送与结果写回
+    void ins(const string& text) {
+        size_t space = text.find(' ');
+        if (space == string::npos) body << "\t" << text << "\n";
+        else body << "\t" << text.substr(0, space) << "\t" << text.substr(space + 1) << "\n";
+    }
+    void moveInt(const string& src, const string& dst);
+    void moveFloat(const string& src, const string& dst);
+    void finish(const string& value, SlotType valueType, const string& dst);
+    void truthFlags(const string& name, const string& scratch);
+    string errorLabel(int i) { errorSites.insert(i); return ".Lerr" + to_string(i); }
+
+    void emitInstr(int i);
+    void emitCompare(const TAC& t, bool& isFloatCompare);
+    void emitMain(ostringstream& out) const;
+
+public:
+    AsmEmitter(const vector<TAC>& code, const map<string, string>& varTypes, bool allocate)
+        : tac(splitTempWebs(code)), types(inferNameTypes(tac, varTypes)), allocate(allocate), n((int)tac.size()) {}
+    string emit(bool withMain, string& error);
+};
+
+SlotType AsmEmitter::typeOf(const string& name) const {
+    ConstVal c;
+    if (parseConst(name, c)) return c.isFloat ? SlotType::FLOAT : SlotType::INT;
+    return types.at(name);
+}
+
+string AsmEmitter::label(const string& target) const {
+    int a = labelAddr(target);
+    return (a < 0 || a >= n) ? ".Lend" : ".L" + to_string(a);
+}
+
+// ============================================================================
+// 合并与寄存器分配
+// ============================================================================
+
+void AsmEmitter::findFusions() {
+    fuseJump.assign(n, false);
+    fuseCopy.assign(n, false);
+    if (!allocate) return;      // 朴素代码逐条翻译
+
+    vector<bool> isTarget(n + 1, false);
+    map<string, int> useCount, defCount;
+    for (const auto& t : tac) {
+        if (isJumpOp(t.op)) {
+            int a = labelAddr(t.result);
+            if (a >= 0 && a < n) isTarget[a] = true;
+        }
+        for (const auto& u : usesOf(t)) useCount[u]++;
+        string d = defOf(t);
+        if (!d.empty()) defCount[d]++;
+    }
+    for (int i = 0; i + 1 < n; i++) {
+        const TAC& t = tac[i];
+        const TAC& next = tac[i + 1];
+        const string& d = t.result;
+        if (isJumpOp(t.op) || t.op == ":=" || isTarget[i + 1] || !isTempName(d)) continue;
+        if (defCount[d] != 1 || useCount[d] != 1) continue;
+        if (relIndex(t.op) >= 0 && isCondJumpOp(next.op) && next.arg1 == d) {
+            fuseJump[i] = true;
+        } else if (next.op == ":=" && next.arg1 == d && types.at(next.result) == types.at(d)) {
+            fuseCopy[i] = true;
+        } else {
+            continue;
+        }
+        elided.insert(d);
+        i++;
+    }
+}
+
+void AsmEmitter::allocateRegisters() {
+    CFG cfg(tac);
+    LivenessAnalysis liveness(cfg);
+    vector<BitVector> liveOut = liveness.liveOutPerInstruction();
+
+    map<string, Interval> byName;
+    auto extend = [&](const string& name, int pos) {
+        if (name.empty() || isConstName(name) || elided.count(name)) return;
+        auto it = byName.find(name);
+        if (it == byName.end()) {
+            Interval iv;
+            iv.name = name;
+            iv.start = iv.end = pos;
+            byName[name] = iv;
+        } else {
+            it->second.start = min(it->second.start, pos);
+            it->second.end = max(it->second.end, pos);
+        }
+    };
+    for (const auto& kv : types) {
+        // 用户变量从入口（清零）一直活到出口（写回 st），出错提前退出时也要写回
+        if (!isTempName(kv.first)) {
+            extend(kv.first, 0);
+            extend(kv.first, n);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (const auto& u : usesOf(tac[i])) extend(u, i);
+        extend(defOf(tac[i]), i);
+        for (int b = liveOut[i].findNext(0); b >= 0; b = liveOut[i].findNext(b + 1)) extend(liveness.nameOf(b), i);
+    }
+
+    // int 与 float 各自线性扫描
+    for (int cls = 0; cls < 2; cls++) {
+        bool isFloat = cls == 1;
+        vector<Interval> ivs;
+        for (const auto& kv : byName) {
+            if ((types.at(kv.first) == SlotType::FLOAT) == isFloat) ivs.push_back(kv.second);
+        }
+        sort(ivs.begin(), ivs.end(), [](const Interval& a, const Interval& b) {
+            return a.start != b.start ? a.start < b.start : a.name < b.name;
+        });
+        int numRegs = isFloat ? numXMM : numGPR;
+        vector<bool> busy(numRegs, false);
+        vector<Interval*> active;
+        if (allocate) {
+            for (auto& iv : ivs) {
+                // 结束早于当前起点的区间释放寄存器（同一条指令上不共用，读写顺序无须顾虑）
+                for (size_t k = 0; k < active.size();) {
+                    if (active[k]->end < iv.start) {
+                        busy[active[k]->reg] = false;
+                        active.erase(active.begin() + k);
+                    } else {
+                        k++;
+                    }
+                }
+                int r = -1;
+                for (int k = 0; k < numRegs && r < 0; k++) if (!busy[k]) r = k;
+                if (r < 0) {
+                    // 溢出结束最晚的区间
+                    auto last = max_element(active.begin(), active.end(),
+                                            [](const Interval* a, const Interval* b) { return a->end < b->end; });
+                    if ((*last)->end > iv.end) {
+                        r = (*last)->reg;
+                        (*last)->reg = -1;
+                        active.erase(last);
+                    }
+                }
+                if (r >= 0) {
+                    iv.reg = r;
+                    busy[r] = true;
+                    active.push_back(&iv);
+                }
+            }
+        }
+        for (const auto& iv : ivs) {
+            if (iv.start == 0) liveAtEntry.insert(iv.name);
+            if (iv.reg >= 0) {
+                loc[iv.name] = isFloat ? "%xmm" + to_string(iv.reg + 2) : gpr32[iv.reg];
+                if (!isFloat && iv.reg >= firstCalleeSaved) calleeUsed[iv.reg] = true;
+                numAllocated++;
+            } else {
+                loc[iv.name] = "#" + to_string(numSpillSlots++);   // 栈帧布局确定后换成偏移
+                numSpilled++;
+            }
+        }
+    }
+
+    int pushed = 0;
+    for (int r = 0; r < numGPR; r++) if (calleeUsed[r]) pushed++;
+    for (auto& kv : loc) {
+        if (kv.second[0] != '#') continue;
+        int slot = stoi(kv.second.substr(1));
+        kv.second = to_string(-(8 * pushed + 8 + 4 * (slot + 1))) + "(%rbp)";
+    }
+}
+
+int AsmEmitter::stateOffset() const {
+    int pushed = 0;
+    for (int r = 0; r < numGPR; r++) if (calleeUsed[r]) pushed++;
+    return -(8 * pushed + 8);
+}
+
+// ============================================================================
+// 操作数与数据传送
+// ============================================================================
+
+string AsmEmitter::floatConst(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, 4);
+    auto it = floatLabels.find(bits);
+    if (it == floatLabels.end()) it = floatLabels.insert(make_pair(bits, ".LF" + to_string(floatLabels.size()))).first;
+    return it->second + "(%rip)";
+}
+
+string AsmEmitter::intOperand(const string& name) {
+    ConstVal c;
+    if (parseConst(name, c)) return "$" + to_string(convertConst(c, false).i);
+    return loc.at(name);
+}
+
+// float 操作数：常量放在只读数据段，int 变量先转换到 scratch
+string AsmEmitter::floatOperand(const string& name, const string& scratch) {
+    ConstVal c;
+    if (parseConst(name, c)) return floatConst(convertConst(c, true).f);
+    if (types.at(name) == SlotType::FLOAT) return loc.at(name);
+    ins("pxor " + scratch + ", " + scratch);
+    ins("cvtsi2ssl " + loc.at(name) + ", " + scratch);
+    return scratch;
+}
+
+void AsmEmitter::moveInt(const string& src, const string& dst) {
+    if (src == dst) return;
+    if (isMem(src) && isMem(dst)) {
+        ins("movl " + src + ", %edx");
+        ins("movl %edx, " + dst);
+    } else {
+        ins("movl " + src + ", " + dst);
+    }
+}
+
+void AsmEmitter::moveFloat(const string& src, const string& dst) {
+    if (src == dst) return;
+    if (isXmm(src) && isXmm(dst)) {
+        ins("movaps " + src + ", " + dst);
+    } else if (isMem(src) && isMem(dst)) {
+        ins("movl " + src + ", %edx");     // 按位复制
+        ins("movl %edx, " + dst);
+    } else {
+        ins("movss " + src + ", " + dst);
+    }
+}
+
+// 把类型为 valueType 的值写入 dst，按 dst 的类型转换
+void AsmEmitter::finish(const string& value, SlotType valueType, const string& dst) {
+    SlotType dt = types.at(dst);
+    string d = loc.at(dst);
+    if (dt == valueType) {
+        if (dt == SlotType::FLOAT) moveFloat(value, d);
+        else moveInt(value, d);
+        return;
+    }
+    if (dt == SlotType::FLOAT) {
+        // int -> float
+        string v = value;
+        if (isImm(v)) {
+            moveFloat(floatConst((float)stoi(v.substr(1))), d);
+            return;
+        }
+        string x = isXmm(d) ? d : "%xmm0";
+        ins("pxor " + x + ", " + x);
+        ins("cvtsi2ssl " + v + ", " + x);
+        moveFloat(x, d);
+    } else {
+        // float -> int，向零截断
+        string r = isReg(d) ? d : "%edx";
+        ins("cvttss2si " + value + ", " + r);
+        moveInt(r, d);
+    }
+}
+
+// 按操作数真假设置 ZF（值为 0 时 ZF=1）
+void AsmEmitter::truthFlags(const string& name, const string& scratch) {
+    if (typeOf(name) == SlotType::FLOAT) {
+        string x = floatOperand(name, "%xmm0");
+        if (!isXmm(x)) {
+            ins("movss " + x + ", %xmm0");
+            x = "%xmm0";
+        }
+        ins("pxor %xmm1, %xmm1");
+        ins("ucomiss %xmm1, " + x);
+        return;
+    }
+    string x = intOperand(name);
+    if (isReg(x)) {
+        ins("testl " + x + ", " + x);
+    } else if (isMem(x)) {
+        ins("cmpl $0, " + x);
+    } else {
+        ins("movl " + x + ", " + scratch);
+        ins("testl " + scratch + ", " + scratch);
+    }
+}
+
+// ============================================================================
+// 指令选择
+// ============================================================================
+
+// 比较 arg1 与 arg2，设置标志位
+void AsmEmitter::emitCompare(const TAC& t, bool& isFloatCompare) {
+    isFloatCompare = isFloatOp(t.op) || typeOf(t.arg1) == SlotType::FLOAT || typeOf(t.arg2) == SlotType::FLOAT;
+    if (isFloatCompare) {
+        string x = floatOperand(t.arg1, "%xmm0");
+        if (!isXmm(x)) {
+            ins("movss " + x + ", %xmm0");
+            x = "%xmm0";
+        }
+        string y = floatOperand(t.arg2, "%xmm1");
+        ins("ucomiss " + y + ", " + x);
+    } else {
+        string x = intOperand(t.arg1), y = intOperand(t.arg2);
+        if (!isReg(x)) {
+            ins("movl " + x + ", %eax");
+            x = "%eax";
+        }
+        ins("cmpl " + y + ", " + x);
+    }
+}
+
+void AsmEmitter::emitInstr(int i) {
+    const TAC& t = tac[i];
+    body << "\t# " << t.result << " := " << t.arg1 << (t.arg2.empty() ? "" : " " + t.op + " " + t.arg2)
+         << (isJumpOp(t.op) || t.arg2.empty() ? "  (" + t.op + ")" : "") << "\n";
+
+    if (t.op == "goto") {
+        ins("jmp " + label(t.result));
+        return;
+    }
+    if (isCondJumpOp(t.op)) {
+        ConstVal c;
+        bool jz = t.op == "jz";
+        if (parseConst(t.arg1, c)) {
+            if (jz == c.isZero()) ins("jmp " + label(t.result));
+            return;
+        }
+        truthFlags(t.arg1, "%eax");
+        ins(string(jz ? "je " : "jne ") + label(t.result));
+        return;
+    }
+    if (fuseJump[i]) {
+        // T := a < b; jz T, L  ==>  cmp; jge L
+        const TAC& jump = tac[i + 1];
+        bool isFloatCompare;
+        emitCompare(t, isFloatCompare);
+        int rel = relIndex(t.op);
+        if (jump.op == "jz") rel = negatedRel[rel];
+        ins(string("j") + (isFloatCompare ? floatCC : intCC)[rel] + " " + label(jump.result));
+        return;
+    }
+    if (t.op == ":=" || isConversionOp(t.op)) {
+        // itof / ftoi 与赋值一样由 finish 按目标类型转换
+        SlotType at = typeOf(t.arg1);
+        finish(at == SlotType::FLOAT ? floatOperand(t.arg1, "%xmm0") : intOperand(t.arg1), at, t.result);
+        return;
+    }
+
+    // 运算结果写到 dst（与下一条复写合并时直接写复写目标）
+    string dst = fuseCopy[i] ? tac[i + 1].result : t.result;
+    string d = loc.at(dst);
+    SlotType dt = types.at(dst);
+    SlotType a = typeOf(t.arg1);
+    SlotType b = t.arg2.empty() ? a : typeOf(t.arg2);
+    bool isFloat = isFloatOp(t.op) || a == SlotType::FLOAT || b == SlotType::FLOAT;
+    string locB = t.arg2.empty() || isConstName(t.arg2) ? "" : loc.at(t.arg2);
+
+    if (isArith(t.op) && isFloat) {
+        // 用户变量在出错时要保留旧值，先在 xmm0 中算完、检查后再写回
+        bool direct = dt == SlotType::FLOAT && isXmm(d) && d != locB && isTempName(dst);
+        string r = direct ? d : "%xmm0";
+        moveFloat(floatOperand(t.arg1, r), r);
+        string y = floatOperand(t.arg2, "%xmm1");
+        static const map<string, string> sse = { { "+", "addss" }, { "-", "subss" }, { "*", "mulss" }, { "/", "divss" } };
+        ins(sse.at(scalarOp(t.op)) + " " + y + ", " + r);
+        ins("movd " + r + ", %eax");
+        ins("andl $0x7f800000, %eax");
+        ins("cmpl $0x7f800000, %eax");
+        ins("je " + errorLabel(i));
+        finish(r, SlotType::FLOAT, dst);
+    } else if (t.op == "/") {
+        string x = intOperand(t.arg1), y = intOperand(t.arg2);
+        int v = isImm(y) ? stoi(y.substr(1)) : 0;
+        if (isImm(y) && v != 0 && v != -1 && v != INT_MIN) {
+            // 除以常量：乘以 m = 2^(31+l)/|d| + 1 再右移 32+l-1 位，负数的商再加 1（向零截断）
+            uint32_t ad = v < 0 ? 0u - (uint32_t)v : (uint32_t)v;
+            int l = 0;
+            while ((1ull << l) < ad) l++;
+            if (l == 0) l = 1;
+            uint64_t m = (1ull << (31 + l)) / ad + 1;
+            if (ad == 1) {
+                ins("movl " + x + ", %eax");
+            } else {
+                ins(isImm(x) ? "movq " + x + ", %rax" : "movslq " + x + ", %rax");
+                ins("movabsq $" + to_string(m) + ", %rcx");
+                ins("imulq %rcx, %rax");
+                ins("sarq $" + to_string(31 + l) + ", %rax");
+                ins("movl " + x + ", %edx");
+                ins("shrl $31, %edx");
+                ins("addl %edx, %eax");
+            }
+            if (v < 0) ins("negl %eax");
+            finish("%eax", SlotType::INT, dst);
+            return;
+        }
+        ins("movl " + x + ", %eax");
+        if (isImm(y)) {
+            if (v == 0) {
+                ins("jmp " + errorLabel(i));
+                return;
+            }
+            if (v == -1) {
+                ins("cmpl $-2147483648, %eax");
+                ins("je " + errorLabel(i));
+            }
+            ins("movl " + y + ", %ecx");
+        } else {
+            ins("movl " + y + ", %ecx");
+            ins("testl %ecx, %ecx");
+            ins("je " + errorLabel(i));
+            ins("cmpl $-1, %ecx");
+            ins("jne 1f");
+            ins("cmpl $-2147483648, %eax");
+            ins("je " + errorLabel(i));
+            body << "1:\n";
+        }
+        ins("cltd");
+        ins("idivl %ecx");
+        finish("%eax", SlotType::INT, dst);
+    } else if (isArith(t.op)) {
+        static const map<string, string> alu = { { "+", "addl" }, { "-", "subl" }, { "*", "imull" } };
+        bool direct = dt == SlotType::INT && isReg(d) && d != locB;
+        string r = direct ? d : "%eax";
+        moveInt(intOperand(t.arg1), r);
+        ins(alu.at(t.op) + " " + intOperand(t.arg2) + ", " + r);
+        finish(r, SlotType::INT, dst);
+    } else if (relIndex(t.op) >= 0) {
+        bool isFloatCompare;
+        emitCompare(t, isFloatCompare);
+        ins(string("set") + (isFloatCompare ? floatCC : intCC)[relIndex(t.op)] + " %al");
+        ins("movzbl %al, %eax");
+        finish("%eax", SlotType::INT, dst);
+    } else if (t.op == "&&" || t.op == "||") {
+        truthFlags(t.arg1, "%eax");
+        ins("setne %al");
+        truthFlags(t.arg2, "%ecx");
+        ins("setne %cl");
+        ins(string(t.op == "&&" ? "andb" : "orb") + " %cl, %al");
+        ins("movzbl %al, %eax");
+        finish("%eax", SlotType::INT, dst);
+    } else if (t.op == "!") {
+        truthFlags(t.arg1, "%eax");
+        ins("sete %al");
+        ins("movzbl %al, %eax");
+        finish("%eax", SlotType::INT, dst);
+    } else if (scalarOp(t.op) == "neg" && isFloat) {
+        ConstVal c;
+        if (parseConst(t.arg1, c)) {
+            finish(floatConst(-convertConst(c, true).f), SlotType::FLOAT, dst);
+            return;
+        }
+        string x = floatOperand(t.arg1, "%xmm0");
+        ins((isXmm(x) ? "movd " : "movl ") + x + ", %eax");
+        ins("xorl $0x80000000, %eax");      // 翻转符号位
+        ins("movd %eax, %xmm0");
+        finish("%xmm0", SlotType::FLOAT, dst);
+    } else if (t.op == "neg") {
+        bool direct = dt == SlotType::INT && isReg(d);
+        string r = direct ? d : "%eax";
+        moveInt(intOperand(t.arg1), r);
+        ins("negl " + r);
+        finish(r, SlotType::INT, dst);
+    } else {
+        body << "\t# 未知指令 " << t.op << "\n";
+    }
+}
+
+// ============================================================================
+// 输出
+// ============================================================================
+
+// 与 C 后端的 main 相同：可选参数为重复执行次数，输出结束时的变量值和最快一次的用时
+void AsmEmitter::emitMain(ostringstream& out) const {
+    int stateBytes = (int)userVars.size() * 4;
+    int frame = (stateBytes + 15) / 16 * 16 + 8;    // 压入 rbp 和 5 个寄存器后补齐 16 字节对齐
+    out << R"(
+	.globl	main
+	.type	main, @function
+main:
+	pushq	%rbp
+	movq	%rsp, %rbp
+	pushq	%rbx
+	pushq	%r12
+	pushq	%r13
+	pushq	%r14
+	pushq	%r15
+)";
+    out << "\tsubq\t$" << frame << ", %rsp\n";
+    out << R"(	movl	$1, %ebx		# ebx = 重复次数
+	cmpl	$1, %edi
+	jle	1f
+	movq	8(%rsi), %rdi
+	call	atoi@PLT
+	movl	%eax, %ebx
+1:	xorl	%r12d, %r12d		# r12 = 已执行次数
+	movq	$-1, %r13		# r13 = 最快一次的 clock() 差值
+2:	call	clock@PLT
+	movq	%rax, %r14
+	movq	%rsp, %rdi
+	call	while_run
+	movl	%eax, %r15d		# r15 = 结束状态
+	call	clock@PLT
+	subq	%r14, %rax
+	cmpq	$-1, %r13
+	je	3f
+	cmpq	%r13, %rax
+	jge	4f
+3:	movq	%rax, %r13
+4:	incl	%r12d
+	cmpl	%ebx, %r12d
+	jl	2b
+	testl	%r15d, %r15d
+	jle	5f
+	leaq	.Lmsg_error(%rip), %rdi
+	leal	-1(%r15), %esi
+	xorl	%eax, %eax
+	call	printf@PLT
+5:
+)";
+    for (size_t k = 0; k < userVars.size(); k++) {
+        bool isFloat = types.at(userVars[k]) == SlotType::FLOAT;
+        out << "\tleaq\t.Lname" << k << "(%rip), %rdi\n";
+        if (isFloat) out << "\tmovss\t" << 4 * k << "(%rsp), %xmm0\n\tcall\twhile_print_float\n";
+        else out << "\tmovl\t" << 4 * k << "(%rsp), %esi\n\tcall\twhile_print_int\n";
+    }
+    out << R"(	cmpl	$1, %ebx
+	jle	6f
+	cvtsi2sdq	%r13, %xmm0
+	divsd	.Lticks_per_ms(%rip), %xmm0
+	leaq	.Lmsg_time(%rip), %rdi
+	movl	$1, %eax
+	call	printf@PLT
+6:	xorl	%eax, %eax
+	testl	%r15d, %r15d
+	setg	%al
+	leaq	-40(%rbp), %rsp
+	popq	%r15
+	popq	%r14
+	popq	%r13
+	popq	%r12
+	popq	%rbx
+	popq	%rbp
+	ret
+	.size	main, .-main
+
+while_print_int:
+	subq	$8, %rsp
+	movl	%esi, %edx
+	movq	%rdi, %rsi
+	leaq	.Lfmt_int(%rip), %rdi
+	xorl	%eax, %eax
+	call	printf@PLT
+	addq	$8, %rsp
+	ret
+
+# 与 formatConst 相同：%.9g，没有小数点和指数时补 ".0"
+while_print_float:
+	pushq	%rbx
+	subq	$48, %rsp
+	movq	%rdi, %rbx
+	cvtss2sd	%xmm0, %xmm0
+	movq	%rsp, %rdi
+	movl	$40, %esi
+	leaq	.Lfmt_g(%rip), %rdx
+	movl	$1, %eax
+	call	snprintf@PLT
+	movq	%rsp, %rdi
+	leaq	.Lfloat_marks(%rip), %rsi
+	call	strpbrk@PLT
+	testq	%rax, %rax
+	jne	1f
+	movq	%rsp, %rdi
+	leaq	.Lfloat_suffix(%rip), %rsi
+	call	strcat@PLT
+1:	leaq	.Lfmt_str(%rip), %rdi
+	movq	%rbx, %rsi
+	movq	%rsp, %rdx
+	xorl	%eax, %eax
+	call	printf@PLT
+	addq	$48, %rsp
+	popq	%rbx
+	ret
+
+	.section	.rodata
+.Lfmt_int:	.string	"  %s = %d\n"
+.Lfmt_str:	.string	"  %s = %s\n"
+.Lfmt_g:	.string	"%.9g"
+.Lfloat_marks:	.string	".eE"
+.Lfloat_suffix:	.string	".0"
+.Lmsg_error:	.string	"运行时错误: 第 %d 条指令无法求值（除零或结果溢出）\n"
+.Lmsg_time:	.string	"用时 %.3f ms\n"
+)";
+    for (size_t k = 0; k < userVars.size(); k++) out << ".Lname" << k << ":\t.string\t\"" << userVars[k] << "\"\n";
+    out << "\t.align\t8\n.Lticks_per_ms:\t.double\t1000.0\t\t# POSIX 的 CLOCKS_PER_SEC 为 1000000\n";
+}
+
+string AsmEmitter::emit(bool withMain, string& error) {
+    for (const auto& kv : types) {
+        if (kv.second == SlotType::DYN) {
+            error = "变量 " + kv.first + " 先后被赋予 int 和 float 值，汇编后端不支持类型不固定的变量";
+            return "";
+        }
+        if (!isTempName(kv.first)) userVars.push_back(kv.first);
+    }
+    findFusions();
+    allocateRegisters();
+
+    set<int> targets;
+    for (const auto& t : tac) {
+        int a = labelAddr(t.result);
+        if (isJumpOp(t.op) && a >= 0 && a < n) targets.insert(a);
+    }
+    for (int i = 0; i < n; i++) {
+        if (targets.count(i)) body << ".L" << i << ":\n";
+        emitInstr(i);
+        if (fuseJump[i] || fuseCopy[i]) i++;
+    }
+
+    ostringstream out;
+    out << "# 由 While 编译器生成的 x86-64 汇编（GNU as，System V ABI）\n";
+    out << "# 寄存器分配: " << (allocate ? "线性扫描" : "无（全部放在栈槽中）") << "，"
+        << numAllocated << " 个名字在寄存器中，" << numSpilled << " 个在栈上\n";
+    for (const auto& kv : loc) out << "#   " << kv.first << " -> " << kv.second << "\n";
+    out << "\t.text\n\t.globl\twhile_run\n\t.type\twhile_run, @function\nwhile_run:\n";
+    out << "\tpushq\t%rbp\n\tmovq\t%rsp, %rbp\n";
+    int pushed = 0;
+    for (int r = 0; r < numGPR; r++) {
+        if (!calleeUsed[r]) continue;
+        out << "\tpushq\t" << gpr64[r] << "\n";
+        pushed++;
+    }
+    int frame = 8 + 4 * numSpillSlots;
+    frame = (frame + 8 * pushed + 15) / 16 * 16 - 8 * pushed;
+    out << "\tsubq\t$" << frame << ", %rsp\n";
+    out << "\tmovq\t%rdi, " << stateOffset() << "(%rbp)\n";
+    // 入口处活跃的名字清零：未赋值的变量读作 0
+    set<string> cleared;
+    for (const auto& name : liveAtEntry) {
+        const string& x = loc.at(name);
+        if (!cleared.insert(x).second) continue;
+        if (isXmm(x)) out << "\tpxor\t" << x << ", " << x << "\n";
+        else if (isReg(x)) out << "\txorl\t" << x << ", " << x << "\n";
+        else out << "\tmovl\t$0, " << x << "\n";
+    }
+    out << body.str();
+    out << ".Lend:\n\txorl\t%eax, %eax\n.Lexit:\n";
+    out << "\tmovq\t" << stateOffset() << "(%rbp), %rcx\n";
+    for (size_t k = 0; k < userVars.size(); k++) {
+        const string& x = loc.at(userVars[k]);
+        if (isXmm(x)) {
+            out << "\tmovss\t" << x << ", " << 4 * k << "(%rcx)\n";
+        } else if (isReg(x)) {
+            out << "\tmovl\t" << x << ", " << 4 * k << "(%rcx)\n";
+        } else {
+            out << "\tmovl\t" << x << ", %edx\n\tmovl\t%edx, " << 4 * k << "(%rcx)\n";
+        }
+    }
+    out << "\tleaq\t" << -8 * pushed << "(%rbp), %rsp\n";
+    for (int r = numGPR - 1; r >= 0; r--) if (calleeUsed[r]) out << "\tpopq\t" << gpr64[r] << "\n";
+    out << "\tpopq\t%rbp\n\tret\n";
+    for (int i : errorSites) out << ".Lerr" << i << ":\n\tmovl\t$" << i + 1 << ", %eax\n\tjmp\t.Lexit\n";
+    out << "\t.size\twhile_run, .-while_run\n";
+
+    if (withMain) emitMain(out);
+    if (!floatLabels.empty()) {
+        out << "\t.section\t.rodata\n\t.align\t4\n";
+        for (const auto& kv : floatLabels) {
+            float f;
+            memcpy(&f, &kv.first, 4);
+            ConstVal c;
+            c.isFloat = true;
+            c.f = f;
+            out << kv.second << ":\t.long\t" << kv.first << "\t\t# " << formatConst(c) << "\n";
+        }
+    }
+    out << "\t.section\t.note.GNU-stack,\"\",@progbits\n";
+    return out.str();
+}
+
+} // namespace
+
+string emitAsmSource(const vector<TAC>& code, const map<string, string>& varTypes,
+                     bool allocateRegisters, bool withMain, string& error) {
+    AsmEmitter emitter(code, varTypes, allocateRegisters);
+    return emitter.emit(withMain, error);
+}
@@ -0,0 +1,24 @@
+#ifndef ASMBACKEND_H
+#define ASMBACKEND_H
+
+#include "types.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === x86-64 汇编后端 ===
+// 把三地址码翻译为 GNU as 语法（AT&T）的 x86-64 System V 汇编，可直接用 gcc 汇编、链接：
+//   - 指令选择：int 运算用通用寄存器指令，float 运算用 SSE 标量指令，
+//     “T := a < b; jz T” 翻译为 cmp + jcc，“T := a + b; x := T” 直接算到 x；
+//   - 寄存器分配：按活跃变量分析求出每个名字的活跃区间，int 与 float 两类分别做线性扫描，
+//     寄存器不够时溢出区间结束最晚的名字到栈上；用户变量的区间覆盖整个程序；
+//   - allocateRegisters 为 false 时所有名字都放在栈槽中、逐条翻译（对比用的朴素代码）。
+// 入口 int while_run(int32_t* st)：按名字顺序把结束时的用户变量写入 st（每个 4 字节），
+// 返回 0 表示正常结束，k > 0 表示第 k-1 条指令出现运行时错误；不限制跳转次数。
+// withMain 时附带与 C 后端相同的 main（可选参数为重复执行次数）。
+// 含类型不固定（DYN）名字的程序无法翻译，返回空串并在 error 中说明原因。
+
+string emitAsmSource(const vector<TAC>& code, const map<string, string>& varTypes,
+                     bool allocateRegisters, bool withMain, string& error);
+
+#endif // ASMBACKEND_H
@@ -0,0 +1,117 @@
+// x86-64 汇编后端的寄存器分配基准
+// 对每个程序分别生成线性扫描寄存器分配的汇编（--emit=asm）和全部用栈槽的朴素汇编（--emit=asm-stack），
+// 用系统的 gcc 汇编、链接后运行，取最快一次 while_run 的用时，并与参考求值器核对结束时的变量值。
+//
+// 编译：g++ -O2 -std=c++11 -I. -o bench_asm benchmarks/bench_asm.cpp lexer.cpp parser.cpp codegen.cpp
+//       compiler.cpp tacutil.cpp optimizer.cpp evaluator.cpp cfg.cpp dataflow.cpp ssa.cpp vm.cpp jit.cpp
+//       cbackend.cpp asmbackend.cpp outsink.cpp irformat.cpp stats.cpp arena.cpp compile.cpp compilecache.cpp peephole.cpp profiler.cpp -pthread
+// 运行：./bench_asm [程序文件...]，默认运行 benchmarks/ 下的循环程序（需要 x86-64 Linux 和 gcc）
+
+#include "compile.h"
+#include "optimizer.h"
+#include "evaluator.h"
+#include "asmbackend.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+struct NativeRun {
+    bool built = false;
+    double ms = -1;
+    string output;
+};
+
+// 汇编、链接并运行，返回程序输出和其中报告的用时
+static NativeRun buildAndRun(const string& source, const string& stem, int repeat) {
+    NativeRun run;
+    ofstream(stem + ".s") << source;
+    if (system(("gcc -o " + stem + " " + stem + ".s").c_str()) != 0) return run;
+    run.built = true;
+    FILE* pipe = popen((stem + " " + to_string(repeat)).c_str(), "r");
+    if (!pipe) return run;
+    char buffer[256];
+    while (fgets(buffer, sizeof buffer, pipe)) {
+        string line = buffer;
+        if (line.compare(0, 7, "用时 ") == 0) run.ms = atof(line.c_str() + 7);
+        else run.output += line;
+    }
+    pclose(pipe);
+    return run;
+}
+
+// 结束时每个变量的输出行都要出现，出错时要报告运行时错误
+static bool sameState(const EvalResult& expected, const string& output) {
+    if (!expected.ok && output.find("运行时错误") == string::npos) return false;
+    for (const auto& kv : expected.vars) {
+        if (output.find("  " + kv.first + " = " + formatConst(kv.second) + "\n") == string::npos) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> files;
+    for (int i = 1; i < argc; i++) files.push_back(argv[i]);
+    if (files.empty()) {
+        files = { "benchmarks/sum_loop.txt", "benchmarks/float_loop.txt",
+                  "benchmarks/nested_loops.txt", "benchmarks/cse_loop.txt" };
+    }
+
+    // 中文表头每个字占 3 个字节，列宽按字节数补齐
+    cout << left << setw(22) << "程序" << setw(10) << "代码" << setw(18) << "栈槽(ms)"
+         << setw(22) << "寄存器分配(ms)" << setw(12) << "加速比" << "状态" << endl;
+
+    for (const auto& file : files) {
+        ifstream in(file);
+        if (!in) {
+            cerr << "无法打开 " << file << endl;
+            continue;
+        }
+        stringstream ss;
+        ss << in.rdbuf();
+
+        // 只编译，不输出词法表和分析过程
+        CompileResult cg = compile(ss.str());
+        if (!cg.ok) {
+            cerr << file << " 编译失败" << endl;
+            continue;
+        }
+
+        string name = file.substr(file.find_last_of("/\\") + 1);
+        for (int opt = 0; opt < 2; opt++) {
+            vector<TAC> code = cg.tac;
+            if (opt) {
+                TACOptimizer optimizer(cg.varTypes);
+                code = optimizer.optimize(code);
+            }
+            TACEvaluator evaluator(cg.varTypes, 2000000000LL);
+            EvalResult expected = evaluator.run(code);
+
+            string error;
+            string stackAsm = emitAsmSource(code, cg.varTypes, false, true, error);
+            string regAsm = emitAsmSource(code, cg.varTypes, true, true, error);
+            cout << left << setw(20) << name << setw(opt ? 8 : 10) << (opt ? "-O" : "原始");
+            if (!error.empty()) {
+                cout << error << endl;
+                continue;
+            }
+            string stem = "/tmp/bench_asm_" + to_string(opt);
+            NativeRun stack = buildAndRun(stackAsm, stem + "_stack", 5);
+            NativeRun reg = buildAndRun(regAsm, stem + "_reg", 5);
+            if (!stack.built || !reg.built) {
+                cout << "汇编失败" << endl;
+                continue;
+            }
+            bool same = sameState(expected, stack.output) && sameState(expected, reg.output);
+            cout << fixed << setprecision(3) << setw(14) << stack.ms << setw(16) << reg.ms
+                 << setw(9) << setprecision(2) << (reg.ms > 0 ? stack.ms / reg.ms : 0.0)
+                 << (same ? "一致" : "不一致！") << endl;
+            cout.unsetf(ios::fixed);
+        }
+    }
+    return 0;
+}
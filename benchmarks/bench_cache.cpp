@@ -0,0 +1,113 @@
+// 编译缓存基准
+// 合成含 n 条 while 语句的程序，比较三种情况的用时：不使用缓存直接 compile()、
+// 缓存未命中（编译并写入条目）和缓存命中（读一个条目并校验）。
+// 然后在大小上限只能容纳一部分程序的缓存上按偏斜的访问序列反复编译，报告命中率和淘汰次数。
+// 每次运行在源程序开头加一行不同的注释，键与上一次运行的条目不重复，
+// 旧条目由缓存自身按大小上限淘汰，不需要手动清理目录。
+//
+// 编译：g++ -O2 -std=c++11 -I. -o bench_cache benchmarks/bench_cache.cpp lexer.cpp parser.cpp codegen.cpp
+//       tacutil.cpp outsink.cpp irformat.cpp stats.cpp arena.cpp compile.cpp compilecache.cpp peephole.cpp -pthread
+// 运行：./bench_cache [缓存目录] [语句数...]（默认目录 bench_cache.tmp）
+
+#include "compile.h"
+#include "compilecache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+static string makeProgram(const string& nonce, int statements, int variant) {
+    ostringstream src;
+    src << "// " << nonce << " " << variant << "\n";
+    src << "int i; int s; float f; int k;\ni = 0; s = 0; f = 0.5; k = " << variant << ";\n";
+    for (int j = 0; j < statements; j++) {
+        src << "while (i < " << j % 50 + 1 << ") { s = s + i * " << j % 7 + 1
+            << " - k / 3; f = f * 0.5 + i; i++; }\n";
+    }
+    return src.str();
+}
+
+static double msSince(chrono::steady_clock::time_point begin) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char* argv[]) {
+    string dir = "bench_cache.tmp";
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) {
+        char* end = nullptr;
+        long n = strtol(argv[i], &end, 10);
+        if (*end == '\0' && n > 0) sizes.push_back((int)n);
+        else dir = argv[i];
+    }
+    if (sizes.empty()) sizes = { 10, 100, 1000, 10000 };
+
+    const Parser& parser = sharedParser();
+    string nonce = to_string(chrono::steady_clock::now().time_since_epoch().count());
+    CompileCache cache(dir, 256ULL * 1024 * 1024);
+    long long entries = 0, bytes = 0, entryBytes = 0;
+
+    // 1. 单个程序：不使用缓存 / 未命中 / 命中，命中取 5 次中最快的一次
+    cout << left << setw(10) << "语句数" << setw(14) << "compile(ms)" << setw(14) << "未命中(ms)"
+         << setw(14) << "命中(ms)" << setw(10) << "加速比" << "条目字节\n";
+    for (int n : sizes) {
+        string source = makeProgram(nonce, n, 0);
+        auto begin = chrono::steady_clock::now();
+        CompileResult direct = compile(source, parser);
+        double compileMs = msSince(begin);
+
+        bool hit = false;
+        cache.usage(entries, bytes);
+        long long before = bytes;
+        begin = chrono::steady_clock::now();
+        cache.compile(source, parser, CompileOptions(), &hit);
+        double missMs = msSince(begin);
+        if (hit) cerr << "警告: 第一次编译命中了缓存\n";
+        cache.usage(entries, bytes);
+        entryBytes = bytes - before;
+
+        double hitMs = 1e300;
+        CompileResult cached;
+        for (int r = 0; r < 5; r++) {
+            begin = chrono::steady_clock::now();
+            cached = cache.compile(source, parser, CompileOptions(), &hit);
+            hitMs = min(hitMs, msSince(begin));
+            if (!hit) cerr << "警告: 第二次编译未命中缓存\n";
+        }
+        if (cached.tac.size() != direct.tac.size() || cached.ok != direct.ok) cerr << "警告: 命中的结果与直接编译不同\n";
+        cout << left << setw(10) << n << fixed << setprecision(3) << setw(14) << compileMs << setw(14) << missMs
+             << setw(14) << hitMs << setprecision(1) << setw(10) << compileMs / hitMs << entryBytes << "\n";
+    }
+
+    // 2. 容量有限时的命中率：64 个不同的程序，上限约可容纳其中 16 个，
+    //    访问序列偏向编号小的程序（取两个均匀随机数中较小的一个）
+    const int programs = 64, accesses = 2000;
+    vector<string> sources;
+    for (int v = 0; v < programs; v++) sources.push_back(makeProgram(nonce + "-lru", 100, v + 1));
+    cache.usage(entries, bytes);
+    long long before = bytes;
+    cache.compile(sources[0], parser);
+    cache.usage(entries, bytes);
+    unsigned long long limit = (unsigned long long)max(1LL, bytes - before) * 16;
+
+    CompileCache small(dir + "-lru", limit);
+    uint64_t s = 1;
+    auto next = [&s]() {
+        s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (int)((s >> 33) % programs);
+    };
+    auto begin = chrono::steady_clock::now();
+    for (int a = 0; a < accesses; a++) small.compile(sources[min(next(), next())], parser);
+    double totalMs = msSince(begin);
+    const CacheCounters& c = small.getCounters();
+    cout << "\n" << programs << " 个程序，上限 " << limit << " 字节，访问 " << accesses << " 次: 命中率 "
+         << fixed << setprecision(1) << 100.0 * c.hits / (c.hits + c.misses) << "%，淘汰 " << c.evictions
+         << " 个条目，平均每次 " << setprecision(3) << totalMs / accesses << " ms\n";
+    return 0;
+}
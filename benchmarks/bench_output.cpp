@@ -0,0 +1,90 @@
+// 缓冲输出基准
+// 合成含 n 条 while 语句的程序，把完整的编译输出（词法表、分析过程、三地址码）分别写入
+// 内存字符串、文件和控制台，并把同样的内容按行用 ofstream << endl 写入文件作对比。
+// 最后一列是同一程序只调用 compile()、不记录分析过程也不输出的用时。
+//
+// 编译：g++ -O2 -std=c++11 -I. -o bench_output benchmarks/bench_output.cpp lexer.cpp parser.cpp codegen.cpp
+//       compiler.cpp tacutil.cpp optimizer.cpp evaluator.cpp cfg.cpp dataflow.cpp ssa.cpp vm.cpp jit.cpp
+//       cbackend.cpp asmbackend.cpp outsink.cpp irformat.cpp stats.cpp arena.cpp compile.cpp compilecache.cpp peephole.cpp profiler.cpp -pthread
+// 运行：./bench_output [语句数...] > /dev/null（表格输出到 cerr）
+
+#include "compiler.h"
+#include "compile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static string makeProgram(int statements) {
+    ostringstream src;
+    src << "int i; int s; float f; int k;\ni = 0; s = 0; f = 0.5; k = 3;\n";
+    for (int j = 0; j < statements; j++) {
+        src << "while (i < " << j % 50 + 1 << ") { s = s + i * " << j % 7 + 1
+            << " - k / 3; f = f * 0.5 + i; i++; }\n";
+    }
+    return src.str();
+}
+
+template <typename F>
+static double bestMs(F f) {
+    double best = 1e300;
+    for (int r = 0; r < 3; r++) {
+        auto begin = chrono::steady_clock::now();
+        f();
+        best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(atoi(argv[i]));
+    if (sizes.empty()) sizes = { 250, 1000, 4000 };
+    const string path = "bench_output.tmp";
+
+    // 中文表头每个字占 3 个字节，列宽按字节数补齐
+    cerr << left << setw(10) << "语句数" << setw(16) << "输出(MB)" << setw(18) << "字符串(ms)"
+         << setw(16) << "文件(ms)" << setw(18) << "控制台(ms)" << setw(30) << "逐行 endl 写文件(ms)"
+         << "compile() 不输出(ms)" << endl;
+    for (int n : sizes) {
+        string program = makeProgram(n);
+        WhileCompiler compiler;
+
+        string text;
+        double toString = bestMs([&]() {
+            text.clear();
+            OutputSink sink(text);
+            compiler.setOutput(sink);
+            compiler.run(program);
+        });
+        double toFile = bestMs([&]() {
+            OutputSink sink(path);
+            compiler.setOutput(sink);
+            compiler.run(program);
+        });
+        compiler.setOutput(OutputSink::console());
+        double toConsole = bestMs([&]() { compiler.run(program); });
+
+        // 对比：同样的字节按行写入、每行 endl 刷新（只计写出，不含编译）
+        double perLine = bestMs([&]() {
+            ofstream file(path);
+            size_t begin = 0, end;
+            while ((end = text.find('\n', begin)) != string::npos) {
+                file << text.substr(begin, end - begin) << endl;
+                begin = end + 1;
+            }
+        });
+        remove(path.c_str());
+        double library = bestMs([&]() { compile(program); });
+        cerr << left << setw(10) << n << fixed << setprecision(2) << setw(12) << text.size() / 1048576.0
+             << setw(14) << toString << setw(12) << toFile << setw(15) << toConsole << setw(25) << perLine
+             << library << endl;
+        cerr.unsetf(ios::fixed);
+    }
+    return 0;
+}
@@ -0,0 +1,653 @@
+// 编译各阶段的基准
+// 用带种子的生成器合成符合文法的程序（语句数、while 嵌套深度、表达式长度、运算符比例、
+// 注释密度和注入错误的比例都可调），分别计时分析器构造、词法分析、语法分析和代码生成。
+// 语法分析只做 LR(1) 识别并记录移进/归约序列，代码生成按该序列回放语义动作，
+// 两个阶段的时间互不包含。每个阶段先预热若干次，再取多次运行的中位数和 p95，
+// 并按 token 数换算吞吐量。另外对比顺序 compile() 与三线程流水线 compile() 的用时，
+// 流水线的理想用时接近三个阶段中最慢的一个。结果可写成 JSON，并与保存的基线逐项比较，变慢超过阈值时报告回归。
+//
+// 编译：g++ -O2 -std=c++11 -I. -o bench_phases benchmarks/bench_phases.cpp benchmarks/heapcount.cpp lexer.cpp parser.cpp
+//       codegen.cpp tacutil.cpp outsink.cpp stats.cpp arena.cpp compile.cpp peephole.cpp -pthread
+// 运行：./bench_phases                                   默认的一组生成程序
+//       ./bench_phases --batch 256                       流水线每批的 token 数（默认 512）
+//       ./bench_phases --statements 5000 --depth 6 ...   只运行按参数生成的一个程序
+//       ./bench_phases --json out.json --baseline benchmarks/phases_baseline.json
+
+#include "lexer.h"
+#include "parser.h"
+#include "codegen.h"
+#include "compile.h"
+#include "heapcount.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+// ============================================================================
+// 程序生成器
+// ============================================================================
+
+struct GenOptions {
+    string name = "custom";
+    uint64_t seed = 1;
+    int statements = 1000;      // 语句总数（含 while 语句本身）
+    int depth = 3;              // while 最大嵌套深度
+    int exprLen = 4;            // 每个表达式的运算符个数上限
+    int mix[4] = { 4, 3, 2, 1 };// + - * / 的相对权重
+    double comments = 0.0;      // 每条语句前插入注释的概率
+    double errors = 0.0;        // 每条语句注入错误的概率
+};
+
+// splitmix64：各平台上序列相同，同一种子总是生成同一个程序
+struct Rng {
+    uint64_t s;
+    explicit Rng(uint64_t seed) : s(seed) {}
+    uint64_t next() {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    int below(int n) { return (int)(next() % (uint64_t)n); }
+    bool chance(double p) { return (next() >> 11) * (1.0 / 9007199254740992.0) < p; }
+};
+
+class ProgramGenerator {
+private:
+    const GenOptions& opt;
+    Rng rng;
+    ostringstream src;
+    int remaining;
+    int intVars = 8, floatVars = 4;
+
+    string var() {
+        int k = rng.below(intVars + floatVars);
+        return k < intVars ? "i" + to_string(k) : "f" + to_string(k - intVars);
+    }
+    string intVar() { return "i" + to_string(rng.below(intVars)); }
+
+    string atom() {
+        switch (rng.below(8)) {
+        case 0: return to_string(rng.below(100));
+        case 1: return to_string(rng.below(10)) + "." + to_string(rng.below(100));
+        case 2: return var() + (rng.below(2) ? "++" : "--");
+        case 3: return "-" + var();
+        default: return var();
+        }
+    }
+
+    string arithOp() {
+        int total = opt.mix[0] + opt.mix[1] + opt.mix[2] + opt.mix[3];
+        int r = rng.below(max(total, 1));
+        const char* ops[4] = { "+", "-", "*", "/" };
+        for (int k = 0; k < 4; k++) {
+            if (r < opt.mix[k]) return ops[k];
+            r -= opt.mix[k];
+        }
+        return "+";
+    }
+
+    string expr(int ops) {
+        string e = atom();
+        for (int k = 0; k < ops; k++) {
+            string rhs = atom();
+            if (k + 1 < ops && rng.chance(0.2)) rhs = "(" + rhs + " " + arithOp() + " " + atom() + ")";
+            e += " " + arithOp() + " " + rhs;
+        }
+        return e;
+    }
+
+    string condition() {
+        static const char* relops[6] = { "<", "<=", ">", ">=", "==", "!=" };
+        string c = intVar() + " " + relops[rng.below(6)] + " " + expr(rng.below(2));
+        int extra = rng.below(3);
+        for (int k = 0; k < extra; k++) {
+            string rhs = var() + " " + relops[rng.below(6)] + " " + to_string(rng.below(50));
+            if (rng.chance(0.2)) rhs = "!(" + rhs + ")";
+            c += rng.below(2) ? " && " + rhs : " || " + rhs;
+        }
+        return c;
+    }
+
+    string simpleStatement(int depth) {
+        if (depth > 0 && rng.chance(0.03)) return rng.below(2) ? "break;" : "continue;";
+        if (rng.chance(0.1)) return var() + (rng.below(2) ? "++;" : "--;");
+        return var() + " = " + expr(rng.below(opt.exprLen + 1)) + ";";
+    }
+
+    // 一条语句注入一种错误：缺少分号、非法字符、多余的运算符
+    string corrupt(string s) {
+        switch (rng.below(3)) {
+        case 0: if (!s.empty() && s.back() == ';') s.pop_back(); break;
+        case 1: s.insert(rng.below((int)s.size() + 1), "$"); break;
+        default: s.insert(s.find(' ') == string::npos ? 0 : s.find(' '), " * "); break;
+        }
+        injected++;
+        return s;
+    }
+
+    void line(int depth, const string& text) {
+        if (rng.chance(opt.comments)) {
+            src << string(depth * 4, ' ')
+                << (rng.below(2) ? "// 第 " + to_string(opt.statements - remaining) + " 条语句\n"
+                                 : "/* 循环体内的注释\n" + string(depth * 4, ' ') + "   跨越两行 */\n");
+        }
+        src << string(depth * 4, ' ') << (rng.chance(opt.errors) ? corrupt(text) : text) << '\n';
+    }
+
+    // 生成一个语句块，至少一条语句
+    void block(int depth, int budget) {
+        int emitted = 0;
+        while (remaining > 0 && (emitted == 0 || budget > 0)) {
+            emitted++;
+            budget--;
+            remaining--;
+            if (depth < opt.depth && remaining > 1 && rng.chance(0.15)) {
+                line(depth, "while (" + condition() + ") {");
+                block(depth + 1, 1 + rng.below(8));
+                src << string(depth * 4, ' ') << "}\n";
+            } else {
+                line(depth, simpleStatement(depth));
+            }
+        }
+    }
+
+public:
+    int injected = 0;
+
+    explicit ProgramGenerator(const GenOptions& opt) : opt(opt), rng(opt.seed), remaining(opt.statements) {}
+
+    string generate() {
+        for (int k = 0; k < intVars; k++) src << "int i" << k << " = " << k + 1 << ";\n";
+        for (int k = 0; k < floatVars; k++) src << "float f" << k << " = " << k << ".5;\n";
+        while (remaining > 0) block(0, remaining);
+        return src.str();
+    }
+};
+
+// ============================================================================
+// 分阶段执行
+// ============================================================================
+
+// 与编译器主类相同的 token → 终结符映射
+static string terminalOf(const Word& w) {
+    if (w.sym >= 36 && w.sym <= 42) return w.token;
+    if (w.token == "true" || w.token == "false") return w.token;
+    return w.sym == 0 ? "i" : (w.sym == 1 ? "n" : w.token);
+}
+
+// 语法分析的输出：移进（prod = -1，token 为被移进的 token）或归约（token 为当时的向前看 token）
+struct ParseStep {
+    int prod;
+    int token;
+};
+
+// 只做 LR(1) 识别，返回是否接受；失败时 errorToken 为出错的 token 下标
+static bool parseOnly(const Parser& parser, const vector<string>& terminals, vector<ParseStep>& trace, int& errorToken) {
+    const auto& actionTable = parser.getActionTable();
+    const auto& gotoTable = parser.getGotoTable();
+    const auto& productions = parser.getProductions();
+    vector<int> stateStack(1, 0);
+    trace.clear();
+    int ptr = 0;
+    while (true) {
+        const auto& row = actionTable.at(stateStack.back());
+        auto it = row.find(terminals[ptr]);
+        if (it == row.end()) {
+            errorToken = ptr;
+            return false;
+        }
+        const Action& act = it->second;
+        if (act.type == ActionType::SHIFT) {
+            stateStack.push_back(act.target);
+            trace.push_back({ -1, ptr++ });
+        } else if (act.type == ActionType::REDUCE) {
+            const Production& p = productions[act.target];
+            stateStack.resize(stateStack.size() - p.right.size());
+            stateStack.push_back(gotoTable.at(stateStack.back()).at(p.left));
+            trace.push_back({ act.target, ptr });
+        } else {
+            return act.type == ActionType::ACCEPT;
+        }
+    }
+}
+
+// 按移进/归约序列回放语义动作，与编译器主类的语义栈操作相同
+static int replayCodegen(const Parser& parser, const vector<Word>& tokens, const vector<ParseStep>& trace) {
+    const auto& productions = parser.getProductions();
+    CodeGenerator codegen;
+    vector<SemItem> semStack;
+    vector<SemItem> popped;
+    for (const ParseStep& step : trace) {
+        codegen.clearCurrentStepQuads();
+        const Word& w = tokens[step.token];
+        if (step.prod < 0) {
+            if (w.token == "while") codegen.enterLoop();
+            semStack.push_back({ w.token });
+            continue;
+        }
+        size_t n = productions[step.prod].right.size();
+        popped.assign(semStack.end() - n, semStack.end());
+        semStack.resize(semStack.size() - n);
+        codegen.setSourceLine(w.line);
+        semStack.push_back(codegen.handleProduction(step.prod, popped, semStack));
+    }
+    return (int)codegen.getTACCode().size();
+}
+
+// ============================================================================
+// 计时与统计
+// ============================================================================
+
+struct Stat {
+    bool valid = false;
+    double median = 0, p95 = 0;
+};
+
+static Stat summarize(vector<double> ms) {
+    Stat s;
+    if (ms.empty()) return s;
+    sort(ms.begin(), ms.end());
+    s.valid = true;
+    s.median = ms[ms.size() / 2];
+    // p95 取最近秩：第 ceil(0.95 n) 个
+    s.p95 = ms[min(ms.size() - 1, (ms.size() * 95 + 99) / 100 - 1)];
+    return s;
+}
+
+static double msSince(chrono::steady_clock::time_point begin) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+// ============================================================================
+// 堆分配计数
+// ============================================================================
+// 全局 operator new 在 heapcount.cpp 中替换，这里取分析器构造前后计数的差；
+// 区域分配器直接向 malloc 申请的块另由 parser.arena_chunks 计数
+
+struct AllocCount {
+    long long allocations = 0;
+    long long bytes = 0;
+};
+
+static AllocCount countParserBuild() {
+    Stats stats;
+    long long allocations = heapAllocations, bytes = heapBytes;
+    {
+        Parser p(&stats);
+    }
+    AllocCount c;
+    c.allocations = heapAllocations - allocations + stats.counter("parser.arena_chunks");
+    c.bytes = heapBytes - bytes + stats.counter("parser.arena_reserved_bytes");
+    return c;
+}
+
+// 按显示宽度左对齐补齐：UTF-8 的中文字符占 3 个字节、显示为 2 列
+static string cell(const string& text, int width) {
+    int shown = 0;
+    for (size_t k = 0; k < text.size(); k++) {
+        unsigned char c = text[k];
+        if ((c & 0xC0) != 0x80) shown += c >= 0xE0 ? 2 : 1;
+    }
+    return text + string(max(1, width - shown), ' ');
+}
+
+// 前四项是分阶段计时；compile 为顺序 compile()，pipeline 为流水线 compile()
+static const int PHASE_COUNT = 6;
+static const char* PHASES[PHASE_COUNT] = { "lex", "parse", "codegen", "total", "compile", "pipeline" };
+
+struct CaseResult {
+    GenOptions gen;
+    size_t bytes = 0;
+    int tokens = 0;
+    int injected = 0;
+    int instructions = 0;
+    string status;              // "ok" / "lex_error" / "syntax_error"
+    Stat phase[PHASE_COUNT];
+};
+
+static CaseResult runCase(const Parser& parser, const GenOptions& gen, int warmup, int runs, size_t batchSize,
+                          const string& dumpDir) {
+    CaseResult r;
+    r.gen = gen;
+    ProgramGenerator generator(gen);
+    string program = generator.generate();
+    r.bytes = program.size();
+    r.injected = generator.injected;
+    if (!dumpDir.empty()) ofstream(dumpDir + "/" + gen.name + ".txt") << program;
+
+    Lexer lexer;
+
+    vector<double> times[PHASE_COUNT];
+    vector<ParseStep> trace;
+    for (int k = 0; k < warmup + runs; k++) {
+        auto begin = chrono::steady_clock::now();
+        vector<Word> tokens = lexer.performLexicalAnalysis(program);
+        double lexMs = msSince(begin);
+        r.tokens = (int)tokens.size() - 1;      // 不计结束符 #
+
+        double parseMs = 0, codegenMs = 0;
+        if (lexer.hasErrors()) {
+            r.status = "lex_error";
+        } else {
+            vector<string> terminals;
+            terminals.reserve(tokens.size());
+            begin = chrono::steady_clock::now();
+            for (const Word& w : tokens) terminals.push_back(terminalOf(w));
+            int errorToken = -1;
+            bool accepted = parseOnly(parser, terminals, trace, errorToken);
+            parseMs = msSince(begin);
+            r.status = accepted ? "ok" : "syntax_error";
+            if (accepted) {
+                begin = chrono::steady_clock::now();
+                r.instructions = replayCodegen(parser, tokens, trace);
+                codegenMs = msSince(begin);
+            }
+        }
+        if (k < warmup) continue;
+        times[0].push_back(lexMs);
+        if (r.status != "lex_error") times[1].push_back(parseMs);
+        if (r.status == "ok") times[2].push_back(codegenMs);
+        times[3].push_back(lexMs + parseMs + codegenMs);
+    }
+
+    // 完整的 compile()：顺序执行与流水线执行交替计时。窥孔优化在三个阶段之后单独运行，
+    // 不参与流水线，这里关闭，与分阶段计时和基线保持可比
+    CompileOptions sequential, pipelined;
+    sequential.peephole = pipelined.peephole = false;
+    pipelined.pipeline = true;
+    pipelined.batchSize = batchSize;
+    for (int k = 0; k < warmup + runs; k++) {
+        auto begin = chrono::steady_clock::now();
+        compile(program, parser, sequential);
+        double sequentialMs = msSince(begin);
+        begin = chrono::steady_clock::now();
+        compile(program, parser, pipelined);
+        double pipelinedMs = msSince(begin);
+        if (k < warmup) continue;
+        times[4].push_back(sequentialMs);
+        times[5].push_back(pipelinedMs);
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) r.phase[p] = summarize(times[p]);
+    return r;
+}
+
+static double tokensPerSec(int tokens, const Stat& s) {
+    return s.valid && s.median > 0 ? tokens / (s.median / 1000.0) : 0.0;
+}
+
+// ============================================================================
+// JSON 输出与基线比较
+// ============================================================================
+
+static string jsonNumber(double v) {
+    ostringstream o;
+    o << fixed << setprecision(4) << v;
+    return o.str();
+}
+
+static void writeJSON(const string& path, const Stat& build, const AllocCount& buildAllocs, const vector<CaseResult>& results,
+                      int warmup, int runs) {
+    ofstream out(path);
+    out << "{\n  \"version\": 1,\n  \"warmup\": " << warmup << ",\n  \"runs\": " << runs << ",\n";
+    out << "  \"parser_build\": {\"median_ms\": " << jsonNumber(build.median) << ", \"p95_ms\": "
+        << jsonNumber(build.p95) << ", \"allocations\": " << buildAllocs.allocations << ", \"allocated_bytes\": "
+        << buildAllocs.bytes << "},\n  \"cases\": [\n";
+    for (size_t c = 0; c < results.size(); c++) {
+        const CaseResult& r = results[c];
+        const GenOptions& g = r.gen;
+        out << "    {\"name\": \"" << g.name << "\", \"seed\": " << g.seed << ", \"statements\": " << g.statements
+            << ", \"depth\": " << g.depth << ", \"expr\": " << g.exprLen << ", \"mix\": [" << g.mix[0] << ", "
+            << g.mix[1] << ", " << g.mix[2] << ", " << g.mix[3] << "], \"comments\": " << g.comments
+            << ", \"errors\": " << g.errors << ",\n     \"bytes\": " << r.bytes << ", \"tokens\": " << r.tokens
+            << ", \"injected\": " << r.injected << ", \"instructions\": " << r.instructions
+            << ", \"status\": \"" << r.status << "\",\n     \"phases\": {";
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            out << (p ? ", " : "") << "\"" << PHASES[p] << "\": ";
+            if (!r.phase[p].valid) { out << "null"; continue; }
+            out << "{\"median_ms\": " << jsonNumber(r.phase[p].median) << ", \"p95_ms\": " << jsonNumber(r.phase[p].p95)
+                << ", \"tokens_per_sec\": " << jsonNumber(tokensPerSec(r.tokens, r.phase[p])) << "}";
+        }
+        out << "}}" << (c + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// 只读本程序写出的 JSON：把每个数值按路径展开，数组元素中有 "name" 时用名字代替下标，
+// 例如 cases.small.phases.lex.median_ms
+class JSONFlattener {
+private:
+    const string& s;
+    size_t i = 0;
+
+    void skipSpace() { while (i < s.size() && isspace((unsigned char)s[i])) i++; }
+    string readString() {
+        string v;
+        for (i++; i < s.size() && s[i] != '"'; i++) v += s[i] == '\\' && i + 1 < s.size() ? s[++i] : s[i];
+        i++;
+        return v;
+    }
+    // 数组元素的名字：元素是对象且含有 "name" 字段时取该字段
+    string elementName(size_t start, int index) {
+        size_t close = s.find('}', start), key = s.find("\"name\"", start);
+        if (s[start] != '{' || key == string::npos || key > close) return to_string(index);
+        size_t q = s.find('"', s.find(':', key) + 1);
+        return s.substr(q + 1, s.find('"', q + 1) - q - 1);
+    }
+    void value(const string& path) {
+        skipSpace();
+        if (i >= s.size()) return;
+        if (s[i] == '{') {
+            i++;
+            while (true) {
+                skipSpace();
+                if (i >= s.size() || s[i] == '}') { i++; return; }
+                if (s[i] == ',') { i++; continue; }
+                string key = readString();
+                skipSpace();
+                i++;    // ':'
+                value(path.empty() ? key : path + "." + key);
+            }
+        } else if (s[i] == '[') {
+            i++;
+            for (int index = 0;; ) {
+                skipSpace();
+                if (i >= s.size() || s[i] == ']') { i++; return; }
+                if (s[i] == ',') { i++; continue; }
+                value(path + "." + elementName(i, index++));
+            }
+        } else if (s[i] == '"') {
+            readString();
+        } else {
+            size_t end = s.find_first_of(",}] \n", i);
+            string token = s.substr(i, end - i);
+            i = end;
+            if (token != "null" && token != "true" && token != "false") values[path] = atof(token.c_str());
+        }
+    }
+
+public:
+    map<string, double> values;
+    explicit JSONFlattener(const string& text) : s(text) { value(""); }
+};
+
+// 逐项比较中位数，变慢超过阈值（比例）的记为回归；返回回归项数
+static int compareBaseline(const string& path, const Stat& build, const vector<CaseResult>& results, double threshold) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "无法打开基线 " << path << endl;
+        return -1;
+    }
+    stringstream ss;
+    ss << in.rdbuf();
+    JSONFlattener baseline(ss.str());
+
+    vector<pair<string, double>> current;
+    current.push_back({ "parser_build.median_ms", build.median });
+    for (const auto& r : results) {
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            if (r.phase[p].valid) current.push_back({ "cases." + r.gen.name + ".phases." + PHASES[p] + ".median_ms", r.phase[p].median });
+        }
+    }
+
+    int regressions = 0, compared = 0;
+    cout << "\n与基线 " << path << " 比较（阈值 +" << threshold * 100 << "%）:\n";
+    for (const auto& kv : current) {
+        auto it = baseline.values.find(kv.first);
+        if (it == baseline.values.end() || it->second <= 0) continue;
+        compared++;
+        double ratio = kv.second / it->second;
+        if (ratio > 1 + threshold) {
+            regressions++;
+            cout << "  回归 " << kv.first << ": " << jsonNumber(it->second) << " -> " << jsonNumber(kv.second)
+                 << " ms (+" << fixed << setprecision(1) << (ratio - 1) * 100 << "%)\n";
+            cout.unsetf(ios::fixed);
+        } else if (ratio < 1 / (1 + threshold)) {
+            cout << "  变快 " << kv.first << ": " << jsonNumber(it->second) << " -> " << jsonNumber(kv.second) << " ms\n";
+        }
+    }
+    cout << "  比较 " << compared << " 项，回归 " << regressions << " 项\n";
+    return regressions;
+}
+
+// ============================================================================
+// 命令行
+// ============================================================================
+
+static vector<GenOptions> defaultSuite() {
+    vector<GenOptions> suite;
+    auto add = [&](const string& name, uint64_t seed, int statements, int depth, int exprLen) -> GenOptions& {
+        GenOptions g;
+        g.name = name;
+        g.seed = seed;
+        g.statements = statements;
+        g.depth = depth;
+        g.exprLen = exprLen;
+        suite.push_back(g);
+        return suite.back();
+    };
+    add("small", 1, 200, 3, 4);
+    add("medium", 2, 2000, 3, 4);
+    add("large", 3, 20000, 3, 4);
+    add("deep", 4, 2000, 12, 3);
+    add("long_expr", 5, 1000, 2, 40);
+    GenOptions& mulDiv = add("mul_div", 6, 2000, 3, 6);
+    mulDiv.mix[0] = 1; mulDiv.mix[1] = 1; mulDiv.mix[2] = 4; mulDiv.mix[3] = 4;
+    add("comments", 7, 2000, 3, 4).comments = 0.5;
+    add("errors", 8, 2000, 3, 4).errors = 0.002;
+    return suite;
+}
+
+int main(int argc, char* argv[]) {
+    GenOptions custom;
+    bool useCustom = false;
+    int warmup = 2, runs = 15;
+    size_t batchSize = 512;
+    double threshold = 0.15;
+    string jsonPath, baselinePath, dumpDir;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) { custom.seed = strtoull(argv[++i], nullptr, 10); useCustom = true; }
+        else if (arg == "--statements" && hasValue) { custom.statements = atoi(argv[++i]); useCustom = true; }
+        else if (arg == "--depth" && hasValue) { custom.depth = atoi(argv[++i]); useCustom = true; }
+        else if (arg == "--expr" && hasValue) { custom.exprLen = atoi(argv[++i]); useCustom = true; }
+        else if (arg == "--mix" && hasValue) {
+            // 例如 --mix 1,1,4,4 表示 + - * / 的权重
+            sscanf(argv[++i], "%d,%d,%d,%d", &custom.mix[0], &custom.mix[1], &custom.mix[2], &custom.mix[3]);
+            useCustom = true;
+        }
+        else if (arg == "--comments" && hasValue) { custom.comments = atof(argv[++i]); useCustom = true; }
+        else if (arg == "--errors" && hasValue) { custom.errors = atof(argv[++i]); useCustom = true; }
+        else if (arg == "--name" && hasValue) custom.name = argv[++i];
+        else if (arg == "--warmup" && hasValue) warmup = atoi(argv[++i]);
+        else if (arg == "--runs" && hasValue) runs = max(1, atoi(argv[++i]));
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = atof(argv[++i]) / 100.0;
+        else if (arg == "--dump" && hasValue) dumpDir = argv[++i];
+        else if (arg == "--batch" && hasValue) batchSize = max(1, atoi(argv[++i]));
+        else {
+            cerr << "未知参数: " << arg << "\n用法: bench_phases [--seed N] [--statements N] [--depth N] [--expr N]"
+                 << " [--mix a,s,m,d] [--comments P] [--errors P] [--name 名字] [--warmup N] [--runs N]"
+                 << " [--json 文件] [--baseline 文件] [--threshold 百分比] [--dump 目录] [--batch N]" << endl;
+            return 2;
+        }
+    }
+    vector<GenOptions> suite = useCustom ? vector<GenOptions>{ custom } : defaultSuite();
+
+    // 分析器构造与输入无关，单独计时（构造函数同时写出 items.txt 和 table.csv）
+    vector<double> buildTimes;
+    for (int k = 0; k < warmup + runs; k++) {
+        auto begin = chrono::steady_clock::now();
+        Parser p;
+        double ms = msSince(begin);
+        if (k >= warmup) buildTimes.push_back(ms);
+    }
+    Stat build = summarize(buildTimes);
+    AllocCount buildAllocs = countParserBuild();
+    Parser parser;
+
+    cout << "预热 " << warmup << " 次，计时 " << runs << " 次，时间为 中位数/p95 (ms)\n";
+    cout << "分析器构造: " << fixed << setprecision(3) << build.median << " / " << build.p95 << " ms，堆分配 "
+         << buildAllocs.allocations << " 次，" << setprecision(1) << buildAllocs.bytes / 1024.0 << " KB\n\n";
+    cout << cell("程序", 12) << cell("字节", 10) << cell("token", 10) << cell("TAC", 9) << cell("状态", 18)
+         << cell("词法", 18) << cell("语法", 18) << cell("代码生成", 18) << cell("合计", 20) << "百万token/秒" << endl;
+
+    vector<CaseResult> results;
+    for (const auto& gen : suite) {
+        CaseResult r = runCase(parser, gen, warmup, runs, batchSize, dumpDir);
+        results.push_back(r);
+        string status = r.status == "ok" ? "正常" : r.status == "lex_error" ? "词法错误" : "语法错误";
+        if (r.injected) status += "(注入" + to_string(r.injected) + ")";
+        cout << cell(gen.name, 12) << cell(to_string(r.bytes), 10) << cell(to_string(r.tokens), 10)
+             << cell(to_string(r.instructions), 9) << cell(status, 18);
+        for (int p = 0; p < 4; p++) {
+            ostringstream text;
+            if (r.phase[p].valid) text << fixed << setprecision(3) << r.phase[p].median << "/" << r.phase[p].p95;
+            else text << "-";
+            cout << cell(text.str(), p == 3 ? 20 : 18);
+        }
+        cout << fixed << setprecision(2) << tokensPerSec(r.tokens, r.phase[3]) / 1e6 << endl;
+        cout.unsetf(ios::fixed);
+    }
+
+    // 流水线：与顺序 compile() 及最慢阶段（三个阶段中位数的最大值）比较
+    cout << "\n流水线编译（每批 " << batchSize << " 个 token，" << thread::hardware_concurrency() << " 个硬件线程）\n";
+    cout << cell("程序", 12) << cell("顺序 compile()", 20) << cell("流水线", 20) << cell("最慢阶段", 12)
+         << cell("加速比", 10) << "流水线/最慢阶段" << endl;
+    for (const auto& r : results) {
+        double slowest = 0;
+        for (int p = 0; p < 3; p++) if (r.phase[p].valid) slowest = max(slowest, r.phase[p].median);
+        const Stat& seq = r.phase[4];
+        const Stat& pipe = r.phase[5];
+        ostringstream a, b, c, d, e;
+        a << fixed << setprecision(3) << seq.median << "/" << seq.p95;
+        b << fixed << setprecision(3) << pipe.median << "/" << pipe.p95;
+        c << fixed << setprecision(3) << slowest;
+        d << fixed << setprecision(2) << (pipe.median > 0 ? seq.median / pipe.median : 0.0);
+        e << fixed << setprecision(2) << (slowest > 0 ? pipe.median / slowest : 0.0);
+        cout << cell(r.gen.name, 12) << cell(a.str(), 20) << cell(b.str(), 20) << cell(c.str(), 12)
+             << cell(d.str(), 10) << e.str() << endl;
+    }
+
+    if (!jsonPath.empty()) {
+        writeJSON(jsonPath, build, buildAllocs, results, warmup, runs);
+        cout << "\n结果已写入 " << jsonPath << endl;
+    }
+    if (!baselinePath.empty()) {
+        int regressions = compareBaseline(baselinePath, build, results, threshold);
+        if (regressions != 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include "heapcount.h"
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+atomic<long long> heapAllocations(0);
+atomic<long long> heapBytes(0);
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    heapBytes.fetch_add((long long)size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
@@ -0,0 +1,12 @@
+#ifndef BENCH_HEAPCOUNT_H
+#define BENCH_HEAPCOUNT_H
+
+#include <atomic>
+
+// 替换全局 operator new / operator delete（定义在 heapcount.cpp），统计整个进程的堆分配次数和字节数。
+// 替换函数单独放在一个翻译单元中，调用方看不到它们的定义，编译器不会把 malloc/free 内联到 new/delete 的调用处；
+// 流水线编译的工作线程也会分配内存，计数用原子变量
+extern std::atomic<long long> heapAllocations;
+extern std::atomic<long long> heapBytes;
+
+#endif // BENCH_HEAPCOUNT_H
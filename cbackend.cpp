@@ -0,0 +1,367 @@
+#include "cbackend.h"
+#include "tacutil.h"
+#include "vm.h"
+#include <sstream>
+#include <set>
+#include <climits>
+
+using namespace std;
+
+namespace {
+
+const char* const prelude = R"(#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#ifdef WHILE_BRANCH_LIMIT
+#define WHILE_BRANCH() do { if (--budget < 0) { status = -1; goto L_end; } } while (0)
+#else
+#define WHILE_BRANCH() ((void)0)
+#endif
+#define WHILE_FAIL(addr) do { status = (addr) + 1; goto L_end; } while (0)
+)";
+
+// 类型不固定的名字：带类型标记的值，运算规则与 foldBinary/foldUnary 相同
+const char* const dynRuntime = R"(
+typedef struct { int isFloat; int i; float f; } while_dyn;
+enum { DYN_ADD, DYN_SUB, DYN_MUL, DYN_DIV, DYN_LT, DYN_LE, DYN_GT, DYN_GE, DYN_EQ, DYN_NE,
+       DYN_AND, DYN_OR, DYN_NEG, DYN_NOT };
+
+static while_dyn dyn_int(int i) { while_dyn v; v.isFloat = 0; v.i = i; v.f = 0.0f; return v; }
+static while_dyn dyn_float(float f) { while_dyn v; v.isFloat = 1; v.i = 0; v.f = f; return v; }
+static float dyn_as_float(while_dyn v) { return v.isFloat ? v.f : (float)v.i; }
+static int dyn_as_int(while_dyn v) { return v.isFloat ? (int)v.f : v.i; }
+static int dyn_truth(while_dyn v) { return v.isFloat ? v.f != 0.0f : v.i != 0; }
+
+static int dyn_op(int op, while_dyn a, while_dyn b, while_dyn* r) {
+    if (op == DYN_AND) { *r = dyn_int(dyn_truth(a) && dyn_truth(b)); return 1; }
+    if (op == DYN_OR) { *r = dyn_int(dyn_truth(a) || dyn_truth(b)); return 1; }
+    if (op == DYN_NOT) { *r = dyn_int(!dyn_truth(a)); return 1; }
+    if (op == DYN_NEG) { *r = a.isFloat ? dyn_float(-a.f) : dyn_int((int)(0u - (unsigned)a.i)); return 1; }
+    if (a.isFloat || b.isFloat) {
+        float x = dyn_as_float(a), y = dyn_as_float(b), f;
+        switch (op) {
+        case DYN_LT: *r = dyn_int(x < y); return 1;
+        case DYN_LE: *r = dyn_int(x <= y); return 1;
+        case DYN_GT: *r = dyn_int(x > y); return 1;
+        case DYN_GE: *r = dyn_int(x >= y); return 1;
+        case DYN_EQ: *r = dyn_int(x == y); return 1;
+        case DYN_NE: *r = dyn_int(x != y); return 1;
+        case DYN_ADD: f = x + y; break;
+        case DYN_SUB: f = x - y; break;
+        case DYN_MUL: f = x * y; break;
+        default: f = x / y; break;
+        }
+        if (!isfinite(f)) return 0;
+        *r = dyn_float(f);
+        return 1;
+    }
+    {
+        int x = a.i, y = b.i;
+        switch (op) {
+        case DYN_LT: *r = dyn_int(x < y); return 1;
+        case DYN_LE: *r = dyn_int(x <= y); return 1;
+        case DYN_GT: *r = dyn_int(x > y); return 1;
+        case DYN_GE: *r = dyn_int(x >= y); return 1;
+        case DYN_EQ: *r = dyn_int(x == y); return 1;
+        case DYN_NE: *r = dyn_int(x != y); return 1;
+        case DYN_ADD: *r = dyn_int((int)((unsigned)x + (unsigned)y)); return 1;
+        case DYN_SUB: *r = dyn_int((int)((unsigned)x - (unsigned)y)); return 1;
+        case DYN_MUL: *r = dyn_int((int)((unsigned)x * (unsigned)y)); return 1;
+        default:
+            if (y == 0 || (x == INT_MIN && y == -1)) return 0;
+            *r = dyn_int(x / y);
+            return 1;
+        }
+    }
+}
+)";
+
+const char* const printRuntime = R"(
+#include <stdlib.h>
+#include <time.h>
+)";
+
+const char* const printIntRuntime = R"(
+static void while_print_int(const char* name, int v) { printf("  %s = %d\n", name, v); }
+)";
+
+const char* const printFloatRuntime = R"(
+static void while_print_float(const char* name, float v) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%.9g", (double)v);
+    if (!strpbrk(buf, ".eE")) strcat(buf, ".0");
+    printf("  %s = %s\n", name, buf);
+}
+)";
+
+const char* const printDynRuntime = R"(static void while_print_dyn(const char* name, while_dyn v) {
+    if (v.isFloat) while_print_float(name, v.f);
+    else while_print_int(name, v.i);
+}
+)";
+
+// 通用运算在 dynRuntime 中的编号
+const char* dynOpName(const string& op) {
+    static const char* const ops[][2] = {
+        { "+", "DYN_ADD" }, { "-", "DYN_SUB" }, { "*", "DYN_MUL" }, { "/", "DYN_DIV" },
+        { "<", "DYN_LT" }, { "<=", "DYN_LE" }, { ">", "DYN_GT" }, { ">=", "DYN_GE" },
+        { "==", "DYN_EQ" }, { "!=", "DYN_NE" }, { "&&", "DYN_AND" }, { "||", "DYN_OR" },
+        { "neg", "DYN_NEG" }, { "!", "DYN_NOT" },
+    };
+    for (const auto& p : ops) if (op == p[0]) return p[1];
+    return nullptr;
+}
+
+bool isRelop(const string& op) {
+    return op == "<" || op == "<=" || op == ">" || op == ">=" || op == "==" || op == "!=";
+}
+
+class CEmitter {
+private:
+    vector<TAC> tac;
+    map<string, SlotType> types;
+    set<string> userVars;
+    ostringstream body;
+    bool needEnd = false;
+
+    // C 标识符：用户变量加 v_ 前缀（避开 C 关键字），临时变量加 t_ 前缀，版本号的 '.' 换成 '_'
+    static string ident(const string& name) {
+        string id = (isTempName(name) ? "t_" : "v_") + name;
+        for (char& c : id) if (c == '.') c = '_';
+        return id;
+    }
+
+    static string literal(const ConstVal& c) {
+        if (c.isFloat) {
+            string s = formatConst(c) + "f";
+            return c.f < 0 ? "(" + s + ")" : s;
+        }
+        if (c.i == INT_MIN) return "(-2147483647 - 1)";
+        return c.i < 0 ? "(" + to_string(c.i) + ")" : to_string(c.i);
+    }
+
+    SlotType typeOf(const string& name) const {
+        ConstVal c;
+        if (parseConst(name, c)) return c.isFloat ? SlotType::FLOAT : SlotType::INT;
+        return types.at(name);
+    }
+
+    // 以 want 类型读取操作数（DYN 表示包装成 while_dyn）
+    string operand(const string& name, SlotType want) const {
+        ConstVal c;
+        if (parseConst(name, c)) {
+            if (want == SlotType::DYN) return (c.isFloat ? "dyn_float(" : "dyn_int(") + literal(c) + ")";
+            return literal(convertConst(c, want == SlotType::FLOAT));
+        }
+        SlotType have = types.at(name);
+        string id = ident(name);
+        if (have == want) return id;
+        if (want == SlotType::DYN) return (have == SlotType::FLOAT ? "dyn_float(" : "dyn_int(") + id + ")";
+        if (have == SlotType::DYN) return (want == SlotType::FLOAT ? "dyn_as_float(" : "dyn_as_int(") + id + ")";
+        return (want == SlotType::FLOAT ? "(float)" : "(int)") + id;
+    }
+
+    // 把类型为 have 的表达式赋给 dst（按 dst 的类型转换）
+    string assign(const string& dst, const string& expr, SlotType have) const {
+        SlotType want = types.at(dst);
+        string e = expr;
+        if (have != want) {
+            if (want == SlotType::DYN) e = (have == SlotType::FLOAT ? "dyn_float(" : "dyn_int(") + expr + ")";
+            else if (have == SlotType::DYN) e = (want == SlotType::FLOAT ? "dyn_as_float(" : "dyn_as_int(") + expr + ")";
+            else e = (want == SlotType::FLOAT ? "(float)(" : "(int)(") + expr + ")";
+        }
+        return ident(dst) + " = " + e + ";";
+    }
+
+    string target(const string& label) {
+        int a = labelAddr(label);
+        if (a < 0 || a >= (int)tac.size()) {
+            needEnd = true;
+            return "L_end";
+        }
+        return "L" + to_string(a);
+    }
+
+    string fail(int addr) {
+        needEnd = true;
+        return "WHILE_FAIL(" + to_string(addr) + ");";
+    }
+
+    void emitInstr(int i);
+    void collectNames();
+
+public:
+    CEmitter(const vector<TAC>& code, const map<string, string>& varTypes)
+        : tac(splitTempWebs(code)), types(inferNameTypes(tac, varTypes)) {
+        collectNames();
+    }
+    string emit(bool withMain);
+};
+
+void CEmitter::collectNames() {
+    for (const auto& kv : types) {
+        if (!isTempName(kv.first)) userVars.insert(kv.first);
+    }
+}
+
+void CEmitter::emitInstr(int i) {
+    const TAC& t = tac[i];
+    if (t.op == "decl") return;
+    if (t.op == "goto") {
+        body << "    WHILE_BRANCH(); goto " << target(t.result) << ";\n";
+        return;
+    }
+    if (isCondJumpOp(t.op)) {
+        string x;
+        ConstVal c;
+        if (parseConst(t.arg1, c)) x = c.isZero() ? "0" : "1";
+        else if (types.at(t.arg1) == SlotType::DYN) x = "dyn_truth(" + ident(t.arg1) + ")";
+        else x = ident(t.arg1);
+        string cond = t.op == "jz" ? "!" + x : x;
+        body << "    WHILE_BRANCH(); if (" << cond << ") goto " << target(t.result) << ";\n";
+        return;
+    }
+
+    SlotType a = typeOf(t.arg1);
+    SlotType b = t.arg2.empty() ? a : typeOf(t.arg2);
+    SlotType d = types.at(t.result);
+    if (t.op == ":=" || isConversionOp(t.op)) {
+        // itof / ftoi 与赋值一样按结果的类型转换
+        body << "    " << assign(t.result, operand(t.arg1, a), a) << "\n";
+        return;
+    }
+
+    // float 运算符的两个操作数都按 float 读取
+    string op = scalarOp(t.op);
+    bool floatOp = isFloatOp(t.op);
+
+    // 含类型不固定的名字：交给 dyn_op 求值
+    if (a == SlotType::DYN || b == SlotType::DYN || d == SlotType::DYN) {
+        auto dynArg = [&](const string& name) {
+            return floatOp ? "dyn_float(" + operand(name, SlotType::FLOAT) + ")" : operand(name, SlotType::DYN);
+        };
+        string rhs = t.arg2.empty() ? "dyn_int(0)" : dynArg(t.arg2);
+        body << "    { while_dyn r; if (!dyn_op(" << dynOpName(op) << ", " << dynArg(t.arg1)
+             << ", " << rhs << ", &r)) " << fail(i) << " " << assign(t.result, "r", SlotType::DYN) << " }\n";
+        return;
+    }
+
+    SlotType work = (floatOp || a == SlotType::FLOAT || b == SlotType::FLOAT) ? SlotType::FLOAT : SlotType::INT;
+    bool isFloat = work == SlotType::FLOAT;
+    if (op == "+" || op == "-" || op == "*" || op == "/") {
+        string x = operand(t.arg1, work), y = operand(t.arg2, work);
+        if (isFloat) {
+            // 操作数先放进局部变量：GCC 前端会把 0.0f - (float)i 折叠成 -(float)i，i 为 0 时得到 -0.0
+            body << "    { float x = " << x << ", y = " << y << ", r = x " << op << " y; if (!isfinite(r)) " << fail(i)
+                 << " " << assign(t.result, "r", SlotType::FLOAT) << " }\n";
+        } else if (op == "/") {
+            body << "    if (" << y << " == 0 || (" << x << " == INT_MIN && " << y << " == -1)) " << fail(i) << "\n";
+            body << "    " << assign(t.result, x + " / " + y, SlotType::INT) << "\n";
+        } else {
+            string e = "(int)((unsigned)" + x + " " + op + " (unsigned)" + y + ")";
+            body << "    " << assign(t.result, e, SlotType::INT) << "\n";
+        }
+    } else if (isRelop(op)) {
+        body << "    " << assign(t.result, "(" + operand(t.arg1, work) + " " + op + " " + operand(t.arg2, work) + ")",
+                                 SlotType::INT) << "\n";
+    } else if (t.op == "&&" || t.op == "||") {
+        // 逻辑运算只看真假，各操作数保持自己的类型
+        body << "    " << assign(t.result, "(" + operand(t.arg1, a) + " " + t.op + " " + operand(t.arg2, b) + ")",
+                                 SlotType::INT) << "\n";
+    } else if (t.op == "!") {
+        body << "    " << assign(t.result, "!" + operand(t.arg1, a), SlotType::INT) << "\n";
+    } else if (op == "neg") {
+        string e = isFloat ? "-" + operand(t.arg1, work) : "(int)(0u - (unsigned)" + operand(t.arg1, work) + ")";
+        body << "    " << assign(t.result, e, work) << "\n";
+    } else {
+        body << "    /* 未知指令 " << t.op << " */\n";
+    }
+}
+
+string CEmitter::emit(bool withMain) {
+    int n = (int)tac.size();
+    set<int> labels;
+    bool hasDyn = false;
+    for (const auto& t : tac) {
+        if (!isJumpOp(t.op)) continue;
+        int a = labelAddr(t.result);
+        if (a >= 0 && a < n) labels.insert(a);
+        needEnd = true;     // 定义 WHILE_BRANCH_LIMIT 时每个跳转都可能去 L_end
+    }
+    for (const auto& kv : types) if (kv.second == SlotType::DYN) hasDyn = true;
+
+    for (int i = 0; i < n; i++) {
+        if (labels.count(i)) body << "L" << i << ":\n";
+        emitInstr(i);
+    }
+
+    auto cType = [](SlotType t) {
+        return t == SlotType::FLOAT ? "float" : t == SlotType::DYN ? "while_dyn" : "int";
+    };
+    auto zero = [](SlotType t) {
+        return t == SlotType::FLOAT ? "0.0f" : t == SlotType::DYN ? "{ 0, 0, 0.0f }" : "0";
+    };
+
+    ostringstream out;
+    out << "/* 由 While 编译器生成的 C 代码 */\n" << prelude;
+    if (hasDyn) out << dynRuntime;
+
+    out << "\nstruct while_state {\n";
+    for (const auto& name : userVars) out << "    " << cType(types.at(name)) << " " << ident(name) << ";\n";
+    if (userVars.empty()) out << "    int unused;\n";   // C 不允许空结构体
+    out << "};\n\n";
+
+    out << "int while_run(struct while_state* st) {\n";
+    out << "    int status = 0;\n";
+    out << "#ifdef WHILE_BRANCH_LIMIT\n    long long budget = WHILE_BRANCH_LIMIT;\n    (void)budget;\n#endif\n";
+    for (const auto& kv : types) {
+        out << "    " << cType(kv.second) << " " << ident(kv.first) << " = " << zero(kv.second) << ";\n";
+    }
+    out << "\n" << body.str();
+    if (needEnd) out << "L_end:\n";
+    for (const auto& name : userVars) out << "    st->" << ident(name) << " = " << ident(name) << ";\n";
+    if (userVars.empty()) out << "    st->unused = 0;\n";
+    out << "    return status;\n}\n";
+
+    if (withMain) {
+        out << "\n#ifndef WHILE_NO_MAIN" << printRuntime;
+        set<SlotType> printed;
+        for (const auto& name : userVars) printed.insert(types.at(name));
+        bool dynVar = printed.count(SlotType::DYN) > 0;
+        if (printed.count(SlotType::INT) || dynVar) out << printIntRuntime;
+        if (printed.count(SlotType::FLOAT) || dynVar) out << printFloatRuntime;
+        if (dynVar) out << printDynRuntime;
+        // 可选参数为重复执行次数，大于 1 时输出最快一次的用时（基准测试用）
+        out << "\nint main(int argc, char** argv) {\n";
+        out << "    struct while_state st;\n";
+        out << "    int repeat = argc > 1 ? atoi(argv[1]) : 1;\n";
+        out << "    int status = 0, k;\n";
+        out << "    double best = 0.0;\n";
+        out << "    for (k = 0; k < repeat || k == 0; k++) {\n";
+        out << "        clock_t begin = clock();\n";
+        out << "        double ms;\n";
+        out << "        status = while_run(&st);\n";
+        out << "        ms = (double)(clock() - begin) * 1000.0 / CLOCKS_PER_SEC;\n";
+        out << "        if (k == 0 || ms < best) best = ms;\n";
+        out << "    }\n";
+        out << "    if (status > 0) printf(\"运行时错误: 第 %d 条指令无法求值（除零或结果溢出）\\n\", status - 1);\n";
+        out << "    if (status < 0) printf(\"达到跳转次数上限，已停止\\n\");\n";
+        for (const auto& name : userVars) {
+            SlotType t = types.at(name);
+            const char* fn = t == SlotType::FLOAT ? "while_print_float" : t == SlotType::DYN ? "while_print_dyn" : "while_print_int";
+            out << "    " << fn << "(\"" << name << "\", st." << ident(name) << ");\n";
+        }
+        out << "    if (repeat > 1) printf(\"用时 %.3f ms\\n\", best);\n";
+        out << "    return status > 0;\n}\n#endif\n";
+    }
+    return out.str();
+}
+
+} // namespace
+
+string emitCSource(const vector<TAC>& code, const map<string, string>& varTypes, bool withMain) {
+    CEmitter emitter(code, varTypes);
+    return emitter.emit(withMain);
+}
@@ -0,0 +1,21 @@
+#ifndef CBACKEND_H
+#define CBACKEND_H
+
+#include "types.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === C 源码后端 ===
+// 把三地址码翻译为自包含的 C 翻译单元，交给系统的 C 编译器（gcc -O2 等）做提前编译：
+//   - 变量和临时变量按推断的静态类型声明为 int/float 局部变量，类型不固定的用带标记的 while_dyn；
+//   - 跳转目标翻译为 C 标号，jz/jnz/goto 翻译为 if (!x) goto / if (x) goto / goto；
+//   - 入口函数 int while_run(struct while_state*) 执行程序，把结束时的用户变量写入结构体，
+//     返回 0 表示正常结束，k > 0 表示第 k-1 条指令出现运行时错误，-1 表示达到跳转次数上限；
+//   - withMain 时附带 main，按名字顺序输出结束时的变量值（格式与 --run 相同）。
+// 语义与参考求值器一致：int 运算按无符号回绕，整数除零、INT_MIN / -1 和非有限浮点结果报错。
+// 编译时定义 WHILE_BRANCH_LIMIT=n 可限制跳转次数（默认不计数），定义 WHILE_NO_MAIN 可去掉 main。
+
+string emitCSource(const vector<TAC>& code, const map<string, string>& varTypes, bool withMain = true);
+
+#endif // CBACKEND_H
@@ -0,0 +1,245 @@
+#include "cfg.h"
+#include "tacutil.h"
+#include <algorithm>
+#include <set>
+
+using namespace std;
+
+CFG::CFG(const vector<TAC>& code) : code(&code) {
+    buildBlocks();
+    computeRPO();
+    computeDominators();
+    findLoops();
+}
+
+// 按首指令划分基本块，末尾追加虚拟出口块，跳出代码范围的跳转都连到出口块
+void CFG::buildBlocks() {
+    const vector<TAC>& c = *code;
+    int n = (int)c.size();
+    vector<int> leaders = findLeaders(c);
+    vector<vector<int>> succ = blockSuccessors(c, leaders);
+    int nb = (int)leaders.size() - 1;
+
+    blocks.clear();
+    for (int b = 0; b <= nb; b++) {
+        BasicBlock bb;
+        bb.id = b;
+        bb.start = leaders[b];
+        bb.end = (b < nb) ? leaders[b + 1] : n;
+        if (b < nb) {
+            for (int s : succ[b]) {
+                if (find(bb.succ.begin(), bb.succ.end(), s) == bb.succ.end()) bb.succ.push_back(s);
+            }
+        }
+        blocks.push_back(bb);
+    }
+    for (const auto& bb : blocks) {
+        for (int s : bb.succ) blocks[s].pred.push_back(bb.id);
+    }
+
+    blockOfAddr.assign(n + 1, nb);
+    for (int b = 0; b < nb; b++) {
+        for (int i = blocks[b].start; i < blocks[b].end; i++) blockOfAddr[i] = b;
+    }
+}
+
+// 非递归深度优先遍历求后序，再反转得到逆后序
+void CFG::computeRPO() {
+    int nb = size();
+    rpo.clear();
+    rpoIndex.assign(nb, -1);
+    vector<bool> visited(nb, false);
+    vector<pair<int, int>> stk;  // (块号, 下一个要访问的后继下标)
+    stk.push_back(make_pair(entry(), 0));
+    visited[entry()] = true;
+    while (!stk.empty()) {
+        int b = stk.back().first;
+        int& k = stk.back().second;
+        if (k < (int)blocks[b].succ.size()) {
+            int s = blocks[b].succ[k++];
+            if (!visited[s]) {
+                visited[s] = true;
+                stk.push_back(make_pair(s, 0));
+            }
+        } else {
+            rpo.push_back(b);
+            stk.pop_back();
+        }
+    }
+    reverse(rpo.begin(), rpo.end());
+    for (int i = 0; i < (int)rpo.size(); i++) rpoIndex[rpo[i]] = i;
+}
+
+// Cooper-Harvey-Kennedy 迭代算法：按逆后序反复求前驱直接支配者的最近公共祖先
+void CFG::computeDominators() {
+    int nb = size();
+    idom.assign(nb, -1);
+    idom[entry()] = entry();
+
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b]) a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b : rpo) {
+            if (b == entry()) continue;
+            int newIdom = -1;
+            for (int p : blocks[b].pred) {
+                if (idom[p] < 0) continue;  // 尚未处理或不可达
+                newIdom = (newIdom < 0) ? p : intersect(p, newIdom);
+            }
+            if (newIdom != idom[b]) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool CFG::dominates(int a, int b) const {
+    if (!reachable(a) || !reachable(b)) return false;
+    while (true) {
+        if (a == b) return true;
+        if (b == entry()) return false;
+        b = idom[b];
+    }
+}
+
+vector<vector<int>> CFG::dominatorTree() const {
+    vector<vector<int>> children(size());
+    for (int b : rpo) {
+        if (b != entry()) children[idom[b]].push_back(b);
+    }
+    return children;
+}
+
+// Cooper-Harvey-Kennedy：汇合块 b 的每个前驱沿支配树上行到 idom(b) 为止，
+// 途经的块的支配边界都包含 b
+vector<vector<int>> CFG::dominanceFrontiers() const {
+    vector<vector<int>> df(size());
+    for (int b : rpo) {
+        int np = 0;
+        for (int p : blocks[b].pred) if (reachable(p)) np++;
+        if (np < 2) continue;
+        for (int p : blocks[b].pred) {
+            if (!reachable(p)) continue;
+            for (int runner = p; runner != idom[b]; runner = idom[runner]) {
+                if (find(df[runner].begin(), df[runner].end(), b) != df[runner].end()) break;
+                df[runner].push_back(b);
+            }
+        }
+    }
+    return df;
+}
+
+// 回边 n -> h（h 支配 n）确定自然循环：从 n 沿前驱反向搜索到 h 为止的所有块
+void CFG::findLoops() {
+    loops.clear();
+    for (int h = 0; h < size(); h++) {
+        NaturalLoop loop;
+        loop.header = h;
+        for (int p : blocks[h].pred) {
+            if (dominates(h, p)) loop.latches.push_back(p);
+        }
+        if (loop.latches.empty()) continue;
+
+        set<int> body;
+        body.insert(h);
+        vector<int> work;
+        for (int l : loop.latches) {
+            if (body.insert(l).second) work.push_back(l);
+        }
+        while (!work.empty()) {
+            int b = work.back();
+            work.pop_back();
+            for (int p : blocks[b].pred) {
+                if (reachable(p) && body.insert(p).second) work.push_back(p);
+            }
+        }
+        loop.blocks.assign(body.begin(), body.end());
+        loops.push_back(loop);
+    }
+
+    // 外层循环取严格包含本循环头部的循环中最小的一个
+    for (int i = 0; i < (int)loops.size(); i++) {
+        for (int j = 0; j < (int)loops.size(); j++) {
+            if (i == j || loops[j].blocks.size() <= loops[i].blocks.size()) continue;
+            if (!binary_search(loops[j].blocks.begin(), loops[j].blocks.end(), loops[i].header)) continue;
+            int cur = loops[i].parent;
+            if (cur < 0 || loops[j].blocks.size() < loops[cur].blocks.size()) loops[i].parent = j;
+        }
+    }
+    for (auto& loop : loops) {
+        loop.depth = 1;
+        for (int p = loop.parent; p >= 0; p = loops[p].parent) loop.depth++;
+    }
+}
+
+vector<string> CFG::verifyLoops(const vector<LoopRecord>& records) const {
+    vector<string> problems;
+    auto latchReachable = [&](const LoopRecord& r) {
+        return r.backEdge < (int)code->size() && reachable(blockOf(r.backEdge));
+    };
+
+    int expectedLoops = 0;
+    for (const auto& r : records) {
+        // 回边不可达的循环（例如循环体以 break 结束）不会形成自然循环
+        if (!latchReachable(r)) continue;
+        expectedLoops++;
+        string where = "循环 L" + to_string(r.testStart);
+
+        int header = blockOf(r.testStart), latch = blockOf(r.backEdge);
+        const NaturalLoop* found = nullptr;
+        for (const auto& loop : loops) {
+            if (loop.header == header &&
+                find(loop.latches.begin(), loop.latches.end(), latch) != loop.latches.end()) {
+                found = &loop;
+            }
+        }
+        if (!found) {
+            problems.push_back(where + " 未被识别为自然循环");
+            continue;
+        }
+
+        // 记录的深度扣除回边不可达的外层循环
+        int depth = r.depth;
+        for (const auto& o : records) {
+            if (&o == &r || latchReachable(o)) continue;
+            if (o.testStart <= r.testStart && o.exitAddr >= r.exitAddr && o.depth < r.depth) depth--;
+        }
+        if (found->depth != depth) {
+            problems.push_back(where + " 嵌套深度不一致：代码生成记录为 " + to_string(depth) +
+                               "，控制流分析为 " + to_string(found->depth));
+        }
+    }
+    if (expectedLoops != (int)loops.size()) {
+        problems.push_back("循环个数不一致：代码生成记录 " + to_string(expectedLoops) +
+                           " 个，控制流分析识别出 " + to_string(loops.size()) + " 个");
+    }
+    return problems;
+}
+
+void CFG::print(OutputSink& out) const {
+    out << "\n--- 控制流图 ---\n";
+    for (const auto& bb : blocks) {
+        if (bb.id == exit()) out << "B" << bb.id << " (出口)";
+        else out << "B" << bb.id << " [L" << bb.start << ", L" << bb.end << ")";
+        out << "  后继:";
+        for (int s : bb.succ) out << " B" << s;
+        if (!reachable(bb.id)) out << "  不可达";
+        else if (bb.id != entry()) out << "  直接支配者: B" << idom[bb.id];
+        out << '\n';
+    }
+    for (size_t i = 0; i < loops.size(); i++) {
+        const auto& loop = loops[i];
+        out << "循环 " << i + 1 << ": 头部 B" << loop.header << "，深度 " << loop.depth << "，块:";
+        for (int b : loop.blocks) out << " B" << b;
+        out << '\n';
+    }
+}
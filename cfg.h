@@ -0,0 +1,79 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "types.h"
+#include "outsink.h"
+#include <vector>
+#include <string>
+
+// === 控制流图 ===
+// 由三地址码划分基本块并连接跳转边，在此基础上计算支配树与自然循环
+
+// ----------------------------------------------------------------------------
+// 基本块 (BasicBlock)
+// ----------------------------------------------------------------------------
+// 覆盖指令区间 [start, end)；最后一个块是虚拟出口块（start == end == 指令数）
+struct BasicBlock {
+    int id;                 // 块号
+    int start, end;         // 指令区间
+    vector<int> succ;       // 后继块
+    vector<int> pred;       // 前驱块
+};
+
+// ----------------------------------------------------------------------------
+// 自然循环 (NaturalLoop)
+// ----------------------------------------------------------------------------
+// 由回边 n -> h（h 支配 n）确定，同一头部的多条回边合并为一个循环
+struct NaturalLoop {
+    int header;                 // 循环头块号
+    vector<int> latches;        // 回边的源块号
+    vector<int> blocks;         // 循环包含的块（升序）
+    int parent = -1;            // 直接外层循环在 loops 中的下标，-1 表示最外层
+    int depth = 1;              // 嵌套深度，最外层为 1
+};
+
+class CFG {
+private:
+    const vector<TAC>* code;
+    vector<BasicBlock> blocks;
+    vector<int> blockOfAddr;        // 指令地址 -> 块号
+    vector<int> rpo;                // 可达块的逆后序
+    vector<int> rpoIndex;           // 块号 -> 逆后序位置，不可达为 -1
+    vector<int> idom;               // 直接支配者，入口为自身，不可达为 -1
+    vector<NaturalLoop> loops;
+
+    void buildBlocks();
+    void computeRPO();
+    void computeDominators();
+    void findLoops();
+
+public:
+    explicit CFG(const vector<TAC>& code);
+
+    const vector<TAC>& getCode() const { return *code; }
+    const vector<BasicBlock>& getBlocks() const { return blocks; }
+    int size() const { return (int)blocks.size(); }
+    int entry() const { return 0; }
+    int exit() const { return (int)blocks.size() - 1; }
+    int blockOf(int addr) const { return blockOfAddr[addr]; }
+
+    const vector<int>& reversePostorder() const { return rpo; }
+    bool reachable(int b) const { return rpoIndex[b] >= 0; }
+
+    // 支配关系
+    int immediateDominator(int b) const { return idom[b]; }
+    bool dominates(int a, int b) const;
+    vector<vector<int>> dominatorTree() const;      // 每个可达块在支配树中的孩子
+    vector<vector<int>> dominanceFrontiers() const; // 每个块的支配边界
+
+    // 自然循环，按头部在代码中的位置排序
+    const vector<NaturalLoop>& getLoops() const { return loops; }
+
+    // 与代码生成阶段记录的循环嵌套核对，返回不一致之处（为空表示一致）
+    vector<string> verifyLoops(const vector<LoopRecord>& records) const;
+
+    // 打印基本块、支配者和循环
+    void print(OutputSink& out) const;
+};
+
+#endif // CFG_H
@@ -1,6 +1,5 @@
 #include "codegen.h"
-#include <iostream>
-#include <iomanip>
+#include "tacutil.h"
 #include <algorithm>
 
 using namespace std;
@@ -15,11 +14,12 @@ string CodeGenerator::newTemp() {
 
 // 生成三地址码指令
 void CodeGenerator::emit(const string& op, const string& a1, const string& a2, const string& res) {
-    tacCode.push_back({ op, a1, a2, res, (int)tacCode.size() });
+    tacCode.push_back({ op, a1, a2, res, (int)tacCode.size(), emitLine, emitCol });
 }
 
 // 生成四元式
 void CodeGenerator::emitQuad(const string& op, const string& a1, const string& a2, const string& res) {
+    if (!recordQuads) return;
     Quadruple q = { op, a1, a2, res };
     quads.push_back(q);
     if (!currentStepQuads.empty()) currentStepQuads += " ";
@@ -33,6 +33,112 @@ void CodeGenerator::backpatch(int addr, const string& target) {
     }
 }
 
+void CodeGenerator::backpatchList(vector<int>& list, int targetAddr) {
+    for (int addr : list) backpatch(addr, "L" + to_string(targetAddr));
+    list.clear();
+}
+
+void CodeGenerator::jumpOn(SemItem& cond, bool sense) {
+    vector<int>& jumps = sense ? cond.trueList : cond.falseList;
+    vector<int>& falls = sense ? cond.falseList : cond.trueList;
+    if (!cond.name.empty()) {
+        ConstVal v;
+        if (parseConst(cond.name, v)) {
+            // 常量条件：值与 sense 相同时无条件跳出，否则什么也不生成
+            bool truth = (v.isFloat ? v.f != 0.0f : v.i != 0) != cond.negated;
+            if (truth == sense) {
+                jumps.push_back((int)tacCode.size());
+                emit("goto", "", "", "PENDING");
+                emitQuad("j", "_", "_", "PENDING");
+            }
+        } else {
+            string op = (sense != cond.negated) ? "jnz" : "jz";
+            jumps.push_back((int)tacCode.size());
+            emit(op, cond.name, "", "PENDING");
+            emitQuad(op, cond.name, "_", "PENDING");
+        }
+        cond.name.clear();
+        cond.negated = false;
+    } else if (cond.fallTrue == sense) {
+        jumps.push_back((int)tacCode.size());
+        emit("goto", "", "", "PENDING");
+        emitQuad("j", "_", "_", "PENDING");
+    }
+    backpatchList(falls, (int)tacCode.size());
+    cond.fallTrue = !sense;
+}
+
+string CodeGenerator::typeOfVar(const string& name) {
+    auto it = varTypes.find(name);
+    if (it != varTypes.end()) return it->second;
+    declaredVars.insert(name);
+    return varTypes[name] = "int";
+}
+
+string CodeGenerator::typeOfLiteral(const string& text) const {
+    ConstVal c;
+    if (parseConst(text, c)) return c.isFloat ? "float" : "int";
+    return text.find_first_of(".eE") != string::npos ? "float" : "int";
+}
+
+void CodeGenerator::declareVar(const string& name, const string& type) {
+    auto it = varTypes.find(name);
+    if (it != varTypes.end() && it->second != type) {
+        typeDiagnostics.push_back({ DiagnosticKind::TYPE, true, sourceLine, 0,
+                                    "[类型错误] 第 " + to_string(sourceLine) + " 行: 变量 '" + name + "' 已按 " +
+                                    it->second + " 使用，不能再声明为 " + type });
+        return;
+    }
+    declaredVars.insert(name);
+    varTypes[name] = type;
+}
+
+void CodeGenerator::emitConversion(const string& src, const string& type, const string& dst) {
+    string op = type == "float" ? "itof" : "ftoi";
+    emit(op, src, "", dst);
+    emitQuad(op, src, "_", dst);
+    conversionCount++;
+}
+
+string CodeGenerator::coerce(const SemItem& v, const string& type) {
+    if (v.type == type) return v.name;
+    ConstVal c;
+    if (parseConst(v.name, c)) return formatConst(convertConst(c, type == "float"));
+    string t = newTemp();
+    emitConversion(v.name, type, t);
+    return t;
+}
+
+void CodeGenerator::assignVar(const string& name, const SemItem& v) {
+    // 隐式声明的变量取第一次赋值的类型
+    if (!varTypes.count(name)) {
+        declaredVars.insert(name);
+        varTypes[name] = v.type.empty() ? "int" : v.type;
+    }
+    string type = varTypes[name];
+    if (type == "int" && v.type == "float") {
+        typeDiagnostics.push_back({ DiagnosticKind::TYPE, false, sourceLine, 0,
+                                    "第 " + to_string(sourceLine) + " 行: float 值赋给 int 变量 '" + name + "'，向零截断" });
+    }
+    if (v.type != type && !isConstName(v.name)) {
+        emitConversion(v.name, type, name);
+        return;
+    }
+    string src = coerce(v, type);
+    emit(":=", src, "", name);
+    emitQuad("=", src, "_", name);
+}
+
+SemItem CodeGenerator::emitBinary(const string& op, const SemItem& a, const SemItem& b, bool isRelop) {
+    string type = (a.type == "float" || b.type == "float") ? "float" : "int";
+    string x = coerce(a, type), y = coerce(b, type);
+    string typedOp = type == "float" ? floatOp(op) : op;
+    SemItem res = { newTemp(), isRelop ? "int" : type };
+    emit(typedOp, x, y, res.name);
+    emitQuad(typedOp, x, y, res.name);
+    return res;
+}
+
 // 处理循环开始
 void CodeGenerator::enterLoop() {
     // 记录循环条件判断代码的起始地址，continue的跳转地址
@@ -46,6 +152,7 @@ void CodeGenerator::exitLoop() {
     if (loopAddrStack.empty()) return;
     // 即外层while的开始标签
     int testStart = loopAddrStack.top();
+    int depth = (int)loopAddrStack.size();
     loopAddrStack.pop();
     // 生成跳转到循环开始的指令（跳转到条件判断）
     emit("goto", "", "", "L" + to_string(testStart));
@@ -53,6 +160,7 @@ void CodeGenerator::exitLoop() {
     // exitAddr是循环结束的地址（在生成goto之后计算，指向goto指令之后的位置）
     // 这样break和条件跳转会跳转到循环结束的位置，而不是goto指令本身
     int exitAddr = (int)tacCode.size();
+    loopRecords.push_back({ testStart, exitAddr - 1, exitAddr, depth, emitLine, emitCol, emitLine });
     // 回填break：所有break语句跳转到循环结束标签（exitAddr位置，即goto指令之后）
     vector<int> brks = breakLists.top();
     breakLists.pop();
@@ -83,134 +191,134 @@ void CodeGenerator::handleContinue() {
     }
 }
 
-// 处理循环条件
+// 处理循环条件：条件为假的跳转链并入 break 链（在 exitLoop 中回填到循环出口），
+// 为真的跳转链回填到循环体开始。while(true) 这样的常量真条件不生成任何跳转
 void CodeGenerator::handleLoopCondition(const string& condition, const vector<SemItem>& semStack) {
     if (semStack.size() >= 2) {
-        SemItem lResult = semStack[semStack.size() - 2];
-        int jzIdx = (int)tacCode.size();
-        emit("jz", lResult.name, "", "PENDING_EXIT");
-        emitQuad("jz", lResult.name, "_", "PENDING_EXIT");
-        if (!breakLists.empty()) breakLists.top().push_back(jzIdx);
+        SemItem cond = semStack[semStack.size() - 2];
+        jumpOn(cond, false);
+        if (!breakLists.empty()) {
+            breakLists.top().insert(breakLists.top().end(), cond.falseList.begin(), cond.falseList.end());
+        }
     }
 }
 
 // 处理产生式归约时的语义动作
 SemItem CodeGenerator::handleProduction(int prodId, const vector<SemItem>& popped, const vector<SemItem>& semStack) {
     SemItem res = { "" }; //临时容器
+
+    // 本次归约生成的指令都记在产生式的起始位置（右部第一个有位置的符号）；
+    // 空产生式（M、K）没有右部，取语义栈顶之下的一项，即循环条件或 && / || 的左操作数
+    const SemItem* at = nullptr;
+    for (const auto& p : popped) {
+        if (p.line > 0) { at = &p; break; }
+    }
+    if (!at && popped.empty() && semStack.size() >= 2) at = &semStack[semStack.size() - 2];
+    emitLine = at ? at->line : 0;
+    emitCol = at ? at->col : 0;
     
     switch (prodId) {
     case 38: { // M->epsilon
         // enterLoop()记录的testStart就是条件表达式代码开始的位置，也就是循环条件判断的开始
-        if (semStack.size() >= 2) {
-            SemItem lResult = semStack[semStack.size() - 2]; // 条件表达式结果
-            // 优化：如果条件是常量true，则不需要条件判断（无限循环）
-            if (lResult.name == "true") { // while(true)
-            } else {
-                int jzIdx = (int)tacCode.size();
-                emit("jz", lResult.name, "", "PENDING_EXIT");
-                emitQuad("jz", lResult.name, "_", "PENDING_EXIT");
-                if (!breakLists.empty()) breakLists.top().push_back(jzIdx);
-            }
-        }
+        if (semStack.size() >= 2) handleLoopCondition(semStack[semStack.size() - 2].name, semStack);
         break;
     }
     case 1: { // A->while(L)M{B}，处理循环结束
+        size_t before = loopRecords.size();
         exitLoop();
+        if (loopRecords.size() > before) loopRecords.back().endLine = popped.back().line;
         break;
     }
-    case 2: //2,4,6逻辑运算
-        res.name = newTemp(); 
-        emit("||", popped[0].name, popped[2].name, res.name); 
-        emitQuad("||", popped[0].name, popped[2].name, res.name); 
+    case 46: { // K->epsilon，&& 或 || 的左操作数已归约完毕，在右操作数之前补上它的跳转
+        // 语义栈顶是运算符，其下是左操作数；整理后的左操作数作为K的语义值传给产生式2/4
+        if (semStack.size() >= 2) {
+            res = semStack[semStack.size() - 2];
+            jumpOn(res, semStack.back().name == "||");
+        }
         break;
-    case 4: 
-        res.name = newTemp(); 
-        emit("&&", popped[0].name, popped[2].name, res.name); 
-        emitQuad("&&", popped[0].name, popped[2].name, res.name); 
+    }
+    case 2: { // L->L||K M1，左操作数为真时已跳出，为假时顺序执行到右操作数
+        res = popped[3];
+        res.trueList.insert(res.trueList.begin(), popped[2].trueList.begin(), popped[2].trueList.end());
         break;
-    case 6: 
-        res.name = newTemp(); 
-        emit("!", popped[1].name, "", res.name); 
-        emitQuad("!", popped[1].name, "_", res.name); 
+    }
+    case 4: { // M1->M1&&K N，左操作数为假时已跳出，为真时顺序执行到右操作数
+        res = popped[3];
+        res.falseList.insert(res.falseList.begin(), popped[2].falseList.begin(), popped[2].falseList.end());
         break;
-    case 9: //关系运算，C->E ROP E，返回临时变量
-        res.name = newTemp(); 
-        emit(popped[1].name, popped[0].name, popped[2].name, res.name); 
-        emitQuad(popped[1].name, popped[0].name, popped[2].name, res.name); 
+    }
+    case 6: // N->!N，交换真假出口，不生成代码
+        res = popped[1];
+        swap(res.trueList, res.falseList);
+        if (res.name.empty()) res.fallTrue = !res.fallTrue;
+        else res.negated = !res.negated;
+        break;
+    case 9: //关系运算，C->E ROP E，返回 int 临时变量
+        res = emitBinary(popped[1].name, popped[0], popped[2], true);
         break;
     case 14: { //赋值语句，S->i=E，返回左边的变量名
         string varName = popped[0].name;
-        // 如果变量未声明，记录为已声明（隐式声明，但不生成decl指令）
-        if (declaredVars.find(varName) == declaredVars.end()) {
-            declaredVars.insert(varName);
-        }
-        emit(":=", popped[2].name, "", varName); 
-        emitQuad("=", popped[2].name, "_", varName); 
+        // 变量未声明时为隐式声明（不生成decl指令），类型取第一次赋值的类型
+        assignVar(varName, popped[2]);
         res.name = varName; 
+        res.type = varTypes[varName];
         break;
     }
     case 15: case 16: case 18: case 19: //算术运算，E->E+F，返回临时变量
-        res.name = newTemp();
-        emit(popped[1].name, popped[0].name, popped[2].name, res.name);
-        emitQuad(popped[1].name, popped[0].name, popped[2].name, res.name);
+        res = emitBinary(popped[1].name, popped[0], popped[2], false);
         break;
-    case 21: //一元负号，G->-G，返回临时变量
+    case 21: { //一元负号，G->-G，返回临时变量
+        string op = popped[1].type == "float" ? floatOp("neg") : "neg";
         res.name = newTemp(); 
-        emit("neg", popped[1].name, "", res.name); 
-        emitQuad("neg", popped[1].name, "_", res.name); 
+        res.type = popped[1].type;
+        emit(op, popped[1].name, "", res.name); 
+        emitQuad(op, popped[1].name, "_", res.name); 
+        break;
+    }
+    case 22: //变量，G->i，返回变量名
+        res.name = popped[0].name; 
+        res.type = typeOfVar(res.name);
         break;
-    case 22: case 23: //变量和常量，G->i或G->n，返回变量名或常量名
+    case 23: //常量，G->n，返回常量名
         res.name = popped[0].name; 
+        res.type = typeOfLiteral(res.name);
         break;
-    case 24: case 8: //括号表达式，G->(E)，返回括号内的表达式结果
-        res.name = popped[1].name; 
+    case 24: case 8: //括号表达式，G->(E)或N->(L)，返回括号内的表达式结果（含条件的回填链）
+        res = popped[1]; 
         break;
-    case 31: { // i++ (后缀自增)
+    case 31: case 33: { // i++ / i-- (后缀自增/自减)
         // 后缀自增：先保存原值，再自增，然后返回原值
         string targetId = popped[0].name;
+        string type = typeOfVar(targetId);
+        string op = popped[1].name == "++" ? "+" : "-";
+        string one = "1";
+        if (type == "float") { op = floatOp(op); one = "1.0"; }
         string oldValue = newTemp();
         emit(":=", targetId, "", oldValue);  // 保存原值
         emitQuad("=", targetId, "_", oldValue);
         string t = newTemp();
-        emit("+", targetId, "1", t);         // 计算新值
+        emit(op, targetId, one, t);          // 计算新值
         emit(":=", t, "", targetId);         // 自增
-        emitQuad("+", targetId, "1", t);
+        emitQuad(op, targetId, one, t);
         emitQuad("=", t, "_", targetId);
         res.name = oldValue;                  // 返回原值
+        res.type = type;
         break;
     }
-    case 32: { // ++i (前缀自增)
+    case 32: case 34: { // ++i / --i (前缀自增/自减)
         // 前缀自增：先自增，然后返回新值
         string targetId = popped[1].name;
+        string type = typeOfVar(targetId);
+        string op = popped[0].name == "++" ? "+" : "-";
+        string one = "1";
+        if (type == "float") { op = floatOp(op); one = "1.0"; }
         string t = newTemp();
-        emit("+", targetId, "1", t);// 计算新值
+        emit(op, targetId, one, t);  // 计算新值
         emit(":=", t, "", targetId);  // 自增
-        emitQuad("+", targetId, "1", t);
+        emitQuad(op, targetId, one, t);
         emitQuad("=", t, "_", targetId);
         res.name = targetId; // 返回新值（自增后的值）
-        break;
-    }
-    case 33: { 
-        string targetId = popped[0].name;
-        string oldValue = newTemp();
-        emit(":=", targetId, "", oldValue); 
-        emitQuad("=", targetId, "_", oldValue);
-        string t = newTemp();
-        emit("-", targetId, "1", t);  
-        emit(":=", t, "", targetId); 
-        emitQuad("-", targetId, "1", t);
-        emitQuad("=", t, "_", targetId);
-        res.name = oldValue;   
-        break;
-    }
-    case 34: { 
-        string targetId = popped[1].name;
-        string t = newTemp();
-        emit("-", targetId, "1", t); 
-        emit(":=", t, "", targetId); 
-        emitQuad("-", targetId, "1", t);
-        emitQuad("=", t, "_", targetId);
-        res.name = targetId; 
+        res.type = type;
         break;
     }
     case 36: { // break
@@ -223,40 +331,52 @@ SemItem CodeGenerator::handleProduction(int prodId, const vector<SemItem>& poppe
     }
     case 39: case 40: { // int i; float i; 不显式生成decl，只记录变量已声明
         string id = popped[1].name;
-        declaredVars.insert(id); // 记录变量已声明，但不生成decl指令
+        declareVar(id, popped[0].name);
         res.name = id;
         break;
     }
-    case 41: case 42: { // int i = E; 不显式生成decl，只生成赋值
+    case 41: case 42: { // int i = E; 不显式生成decl，只生成赋值（按声明类型转换）
         string id = popped[1].name;
-        declaredVars.insert(id); // 记录变量已声明，但不生成decl指令
-        emit(":=", popped[3].name, "", id);
-        emitQuad("=", popped[3].name, "_", id);
+        declareVar(id, popped[0].name);
+        assignVar(id, popped[3]);
         res.name = id;
         break;
     }
     case 43: 
         res.name = "true"; 
+        res.type = "int";
         break;
     case 44: 
         res.name = "false"; 
+        res.type = "int";
         break;
     case 45: 
-        res.name = popped[0].name; 
+        res = popped[0]; 
         break;
     case 35: 
         res.name = popped[0].name; 
         break;
     default: 
-        if (!popped.empty()) res.name = popped[0].name;
+        if (!popped.empty()) res = popped[0];
     }
     
+    res.line = emitLine;
+    res.col = emitCol;
     return res;
 }
 
-void CodeGenerator::printTAC() const {
-    cout << "\n--- 生成的三地址码 (TAC) ---" << endl;
-    
+void CodeGenerator::takeResults(vector<TAC>& tac, map<string, string>& types, vector<LoopRecord>& loops) {
+    tac = move(tacCode);
+    types = move(varTypes);
+    loops = move(loopRecords);
+}
+
+void CodeGenerator::printTAC(OutputSink& out) const {
+    out << "\n--- 生成的三地址码 (TAC) ---\n";
+    printTACCode(tacCode, out);
+}
+
+void printTACCode(const vector<TAC>& tacCode, OutputSink& out) {
     // 收集所有作为跳转目标的地址（包括超出范围的，用于程序结束位置）
     set<int> labelTargets;  // 存在的地址
     set<int> endTargets;    // 超出范围的地址（程序结束位置）
@@ -287,36 +407,34 @@ void CodeGenerator::printTAC() const {
         }
         
         if (labelTargets.count(t.addr)) {
-            cout << "L" << right << setw(3) << t.addr << " | ";
+            out << "L" << padRight(t.addr, 3) << " | ";
         } else {
-            cout << "    " << " | ";  // 对齐，但不显示标号
+            out << "    " << " | ";  // 对齐，但不显示标号
         }
         
         if (t.op == "goto") {
-            cout << "goto " << t.result << endl;
+            out << "goto " << t.result << '\n';
         }
         else if (t.op == "jz") {
-            cout << "if " << left << setw(10) << t.arg1 << " == 0 goto " << t.result << endl;
+            out << "if " << pad(t.arg1, 10) << " == 0 goto " << t.result << '\n';
         }
         else if (t.op == "jnz") {
-            cout << "if " << left << setw(10) << t.arg1 << " != 0 goto " << t.result << endl;
+            out << "if " << pad(t.arg1, 10) << " != 0 goto " << t.result << '\n';
         }
         else if (t.op == ":=") {
-            cout << left << setw(12) << t.result << " := " << t.arg1 << endl;
-        }
-        else if (t.op == "neg") {
-            cout << left << setw(12) << t.result << " := neg " << t.arg1 << endl;
+            out << pad(t.result, 12) << " := " << t.arg1 << '\n';
         }
-        else if (t.op == "!") {
-            cout << left << setw(12) << t.result << " := ! " << t.arg1 << endl;
+        else if (t.arg2.empty()) {
+            // 一元运算：neg / neg. / ! / itof / ftoi
+            out << pad(t.result, 12) << " := " << t.op << " " << t.arg1 << '\n';
         }
         else {
-            cout << left << setw(12) << t.result << " := " << setw(10) << t.arg1 << " " << setw(4) << t.op << " " << t.arg2 << endl;
+            out << pad(t.result, 12) << " := " << pad(t.arg1, 10) << " " << pad(t.op, 4) << " " << t.arg2 << '\n';
         }
     }
     
     // 输出程序结束位置的标号（如果有跳转到这些位置）
     for (int addr : endTargets) {
-        cout << "L" << right << setw(3) << addr << " | " << endl;
+        out << "L" << padRight(addr, 3) << " | \n";
     }
 }
@@ -2,9 +2,11 @@
 #define CODEGEN_H
 
 #include "types.h"
+#include "outsink.h"
 #include <vector>
 #include <stack>
 #include <set>
+#include <map>
 
 // === 代码生成器 ===
 
@@ -18,17 +20,44 @@ private:
     stack<int> loopAddrStack;
     stack<vector<int>> breakLists;
     stack<vector<int>> continueLists;
+    vector<LoopRecord> loopRecords;  // 已结束的循环（按结束顺序）
 
     string currentStepQuads; // 保存当前步骤生成的四元式字符串
+    bool recordQuads = true; // 是否记录四元式（只用于显示分析过程）
     
     // 已声明变量集合（用于隐式声明）
     set<string> declaredVars;
+    // 变量类型（变量名 -> "int"/"float"）：显式声明的按声明，其余在第一次出现时确定，
+    // 之后每次赋值都转换为该类型，整个程序中每个名字只有一种类型
+    map<string, string> varTypes;
+
+    // 类型检查
+    int sourceLine = 0;             // 当前归约位置的行号（用于类型错误信息）
+    int emitLine = 0, emitCol = 0;  // 当前归约的产生式在源程序中的起始位置，记入生成的每条指令
+    int conversionCount = 0;        // 插入的 itof / ftoi 条数
+    vector<Diagnostic> typeDiagnostics;     // 类型错误与警告，按发现的顺序
 
     // 生成临时变量名
     string newTemp();
     
     // 回填地址
     void backpatch(int addr, const string& target);
+    void backpatchList(vector<int>& list, int targetAddr);
+
+    // 短路求值：在当前位置补上条件尚未生成的跳转，使条件值为 sense 时跳出（记入对应的回填链），
+    // 否则顺序执行；另一条回填链回填到当前位置
+    void jumpOn(SemItem& cond, bool sense);
+
+    // 类型推断：变量第一次出现是读取时按 int（未赋值的变量读作 0）
+    string typeOfVar(const string& name);
+    string typeOfLiteral(const string& text) const;
+    void declareVar(const string& name, const string& type);
+    // 取值 v 作为 type 类型的操作数：常量直接改写字面量，其余经 itof / ftoi 转换到新的临时变量
+    string coerce(const SemItem& v, const string& type);
+    void emitConversion(const string& src, const string& type, const string& dst);
+    void assignVar(const string& name, const SemItem& v);
+    // 二元运算：两侧有一个 float 时另一侧转换为 float，使用带 '.' 后缀的 float 运算符
+    SemItem emitBinary(const string& op, const SemItem& a, const SemItem& b, bool isRelop);
 
 public:
     CodeGenerator();
@@ -41,7 +70,8 @@ public:
     
     // 获取当前步骤的四元式字符串
     string getCurrentStepQuads() const { return currentStepQuads; }
-    void clearCurrentStepQuads() { currentStepQuads = ""; }
+    void clearCurrentStepQuads() { currentStepQuads.clear(); }
+    void setRecordQuads(bool on) { recordQuads = on; }
     
     // 循环控制
     void enterLoop();
@@ -58,11 +88,24 @@ public:
     
     // 获取生成的三地址码
     const vector<TAC>& getTACCode() const { return tacCode; }
+    // 把生成结果移交给调用方（之后本对象不再使用）
+    void takeResults(vector<TAC>& tac, map<string, string>& types, vector<LoopRecord>& loops);
     const vector<Quadruple>& getQuads() const { return quads; }
+    const map<string, string>& getVarTypes() const { return varTypes; }
+    const vector<LoopRecord>& getLoopRecords() const { return loopRecords; }
+
+    // 类型检查结果
+    void setSourceLine(int line) { sourceLine = line; }
+    const vector<Diagnostic>& getTypeDiagnostics() const { return typeDiagnostics; }
+    int numConversions() const { return conversionCount; }
+    int numTemps() const { return tempCount; }
     
     // 打印三地址码
-    void printTAC() const;
+    void printTAC(OutputSink& out) const;
 };
 
+// 打印任意三地址码序列（优化后的代码也通过它输出）
+void printTACCode(const vector<TAC>& code, OutputSink& out);
+
 #endif // CODEGEN_H
 
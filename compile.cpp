@@ -0,0 +1,654 @@
+#include "compile.h"
+#include "lexer.h"
+#include "codegen.h"
+#include "peephole.h"
+#include "spscring.h"
+#include <algorithm>
+#include <atomic>
+#include <stack>
+#include <thread>
+
+using namespace std;
+
+// 语法错误诊断函数
+// parenDepth / braceDepth 为分析过程中累计的未闭合 '(' 与 '{' 个数（即符号栈中左括号多出的个数）
+static string diagnoseSyntaxError(const string& currentSymbol, const set<string>& expected, 
+                                  int parenDepth, int braceDepth) {
+    // 是否缺少分号
+    if (expected.count(";")) {
+        // 检查当前符号是否是语句的延续
+        if (currentSymbol != ";" && currentSymbol != "#") {
+            return "缺少分号 ';'。建议：在语句末尾添加分号";
+        }
+    }
+    
+    // 是否缺少右括号
+    if (expected.count(")")) {
+        // 是否有未匹配的左括号
+        if (parenDepth > 0) {
+            return "缺少右括号 ')'。建议：检查是否有未闭合的左括号 '('";
+        }
+    }
+    
+    // 是否缺少右花括号
+    if (expected.count("}")) {
+        if (braceDepth > 0) {
+            // 这里只知道未闭合的个数，具体定位由调用方根据 '{' 的行号栈给出
+            return "缺少右花括号 '}'。建议：检查是否有未闭合的左花括号 '{'";
+        }
+    }
+    
+    // 检查运算符位置错误
+    if (currentSymbol == "+" || currentSymbol == "-" || currentSymbol == "*" || currentSymbol == "/") {
+        // 如果期望的是标识符、数字或左括号，可能是运算符位置错误
+        if (expected.count("i") || expected.count("n") || expected.count("(")) {
+            return "运算符位置错误：'" + currentSymbol + "' 出现在不期望的位置。建议：检查表达式语法";
+        }
+    }
+    
+    // 检查关键字拼写错误（如果当前符号是标识符，但期望的是关键字）
+    static const char* const keywords[] = {"break", "continue", "false", "float", "int", "true", "while"};  // 按字典序检查
+    if (currentSymbol == "i" && !expected.count("i")) {
+        // 当前是标识符，但期望的不是标识符，可能是关键字拼写错误
+        for (const auto& kw : keywords) {
+            if (expected.count(kw)) {
+                return "可能是关键字拼写错误。当前是标识符，但期望关键字 '" + string(kw) + "'";
+            }
+        }
+    }
+    
+    // 检查是否在表达式中间遇到意外的符号
+    if (expected.count("i") || expected.count("n") || expected.count("(") || 
+        expected.count("true") || expected.count("false")) {
+        if (currentSymbol == "}" || currentSymbol == ";" || currentSymbol == ")") {
+            return "表达式不完整。建议：检查表达式是否缺少操作数或运算符";
+        }
+    }
+    
+    return "";  // 未识别到特定模式，返回空字符串
+}
+
+// 分析栈的显示：从栈底到栈顶用空格连接，超过 limit 个字符时显示 "..." 加末尾 keep 个字符。
+// 只从栈顶往下取到足够长为止，每步的开销与栈深无关
+static const string& stackItemText(const string& s, string&) { return s; }
+static const string& stackItemText(int x, string& buffer) { return buffer = to_string(x); }
+
+template <typename T>
+static string stackTail(const vector<T>& items, size_t limit, size_t keep) {
+    string tail, buffer;
+    size_t k = items.size();
+    while (k > 0 && tail.length() <= limit) {
+        const string& text = stackItemText(items[--k], buffer);
+        tail = tail.empty() ? text : text + " " + tail;
+    }
+    if (tail.length() <= limit) return tail;       // 整个栈都放得下
+    return "..." + tail.substr(tail.length() - keep);
+}
+
+// 产生式的文本，用作归约计数的键，如 "r14 S -> i = E"
+static string productionLabel(const Production& p) {
+    string s = "r" + to_string(p.id) + " " + p.left + " ->";
+    if (p.right.empty()) s += " ε";
+    for (const auto& sym : p.right) s += " " + sym;
+    return s;
+}
+
+bool CompileResult::hasErrors() const {
+    for (const auto& d : diagnostics) if (d.isError) return true;
+    return false;
+}
+
+vector<string> CompileResult::errorMessages() const {
+    vector<string> messages;
+    for (const auto& d : diagnostics) if (d.isError) messages.push_back(d.message);
+    return messages;
+}
+
+// 期望符号列表的文本：按关键字、运算符、分隔符、其他分组
+static string formatExpected(const set<string>& expected) {
+    string text;
+    vector<string> keywords, operators, separators, others;
+    set<string> kwSet = {"while", "break", "continue", "int", "float", "true", "false"};
+    set<string> opSet = {"+", "-", "*", "/", "++", "--", "&&", "||", "!", 
+                        ">", "<", "==", ">=", "<=", "!=", "="};
+    set<string> sepSet = {"(", ")", "{", "}", ";", ","};
+    
+    for (const auto& exp : expected) {
+        if (kwSet.count(exp)) keywords.push_back(exp);
+        else if (opSet.count(exp)) operators.push_back(exp);
+        else if (sepSet.count(exp)) separators.push_back(exp);
+        else others.push_back(exp);
+    }
+    
+    text += "\n期望的符号: ";
+    bool hasContent = false;
+    
+    if (!keywords.empty()) {
+        text += "关键字(";
+        for (size_t i = 0; i < keywords.size(); i++) {
+            if (i > 0) text += ", ";
+            text += "'" + keywords[i] + "'";
+        }
+        text += ")";
+        hasContent = true;
+    }
+    
+    if (!operators.empty()) {
+        if (hasContent) text += ", ";
+        text += "运算符(";
+        for (size_t i = 0; i < operators.size(); i++) {
+            if (i > 0) text += ", ";
+            text += "'" + operators[i] + "'";
+        }
+        text += ")";
+        hasContent = true;
+    }
+    
+    if (!separators.empty()) {
+        if (hasContent) text += ", ";
+        text += "分隔符(";
+        for (size_t i = 0; i < separators.size(); i++) {
+            if (i > 0) text += ", ";
+            text += "'" + separators[i] + "'";
+        }
+        text += ")";
+        hasContent = true;
+    }
+    
+    if (!others.empty()) {
+        if (hasContent) text += ", ";
+        for (size_t i = 0; i < others.size(); i++) {
+            if (i > 0) text += ", ";
+            text += "'" + others[i] + "'";
+        }
+    }
+    return text;
+}
+
+// 当前状态 s 下输入符号 a 没有对应的动作：构造语法错误的诊断信息。
+// 期望的符号取分析表构造时为每个状态预先求出的位集，括号深度由分析循环逐步维护，与栈深无关。
+// 文件结束时仍有未闭合的 '{'，按“缺少右花括号”报告，missingBrace 置为 true
+static Diagnostic syntaxError(const Parser& parser, int s, const string& a, const Word& w,
+                              int parenDepth, const stack<int>& braceLineStack, bool& missingBrace) {
+    string errorMsg;
+    missingBrace = false;
+    int braceDepth = (int)braceLineStack.size();
+    
+    // 期望的符号（用于错误提示）：移进的终结符与归约项目的向前看符号
+    set<string> expected = parser.getExpected(s);
+    
+    // 文件结束符特殊处理：如果遇到文件结束符#且仍在代码块内，优先报告缺少}
+    if (a == "#") {
+        // 仍有未闭合的{，或者期望的符号中包含}，说明缺少右花括号
+        if (braceDepth > 0 || expected.count("}")) {
+            errorMsg = "[语法错误] 缺少右花括号'}'";
+            // 如果位置栈不为空，提示未匹配的{的位置
+            if (!braceLineStack.empty()) {
+                int unclosedBraceLine = braceLineStack.top();
+                errorMsg += "\n提示：从第 " + to_string(unclosedBraceLine) + " 行开始的 '{' 未找到匹配的 '}'";
+            }
+            missingBrace = true;
+            return { DiagnosticKind::SYNTAX, true, w.line, w.col, errorMsg };
+        }
+    }
+    
+    // 常规错误处理
+    errorMsg = "[语法错误] 第" + to_string(w.line) + "行, 第" + to_string(w.col) + "列: ";
+    errorMsg += "遇到意外的符号 '" + a + "'";
+    
+    // 尝试诊断常见错误模式
+    string diagnosis = diagnoseSyntaxError(a, expected, parenDepth, braceDepth);
+    if (!diagnosis.empty()) {
+        errorMsg += "\n诊断: " + diagnosis;
+    }
+    
+    // 如果期望的符号中包含}，且位置栈不为空，提示未匹配的 { 的位置
+    if (expected.count("}") && !braceLineStack.empty()) {
+        int unclosedBraceLine = braceLineStack.top();
+        errorMsg += "\n提示：从第 " + to_string(unclosedBraceLine) + " 行开始的 '{' 未找到匹配的 '}'";
+    }
+    
+    // 格式化期望符号列表（分组显示）
+    if (!expected.empty()) errorMsg += formatExpected(expected);
+    return { DiagnosticKind::SYNTAX, true, w.line, w.col, errorMsg };
+}
+
+// Token 转换为分析表中使用的终结符
+// 标识符统一映射为 "i"，数字映射为 "n"
+// 关键字（36-42）或其他符号直接使用token值
+static string terminalOf(const Word& w) {
+    if (w.sym >= 36 && w.sym <= 42) return w.token;  // 关键字
+    if (w.token == "true" || w.token == "false") return w.token;  // 布尔值
+    return w.sym == 0 ? "i" : (w.sym == 1 ? "n" : w.token);  // 标识符"i", 数字"n", 其他原值
+}
+
+// ========== 流水线编译 ==========
+// 词法、语法、代码生成各占一个线程，之间用两个 SPSCRing 按批传递：
+//   词法线程 --TokenBatch--> 语法线程 --EventBatch--> 代码生成线程
+// 语法线程只做 LR(1) 分析，把移进和归约记成事件；代码生成线程按同样的顺序重放事件、
+// 维护自己的语义栈，因此生成的四元式与顺序编译完全相同。
+// 队列满时生产者让出 CPU 等待（反压），内存占用以队列容量 × 批大小为上限。
+struct TokenBatch {
+    vector<Word> tokens;
+    bool last = false;      // 之后不再有 token（正常结束或因错误停止）
+};
+
+struct ParseEvent {
+    int prodId;             // 归约的产生式编号；-1 表示移进
+    int line;               // 当前输入 token 的行号（类型错误信息用；移进时即该 token 的位置）
+    int col;
+    string token;           // 移进的 token 原文
+};
+
+struct EventBatch {
+    vector<ParseEvent> events;
+    bool last = false;
+};
+
+// 窥孔优化：在生成的三地址码上运行到不动点，循环记录的地址随之更新
+static void runPeephole(CompileResult& result, Stats* stats) {
+    ScopedTimer timer(stats, "peephole");
+    PeepholeOptimizer peephole;
+    result.peepholeRemoved = peephole.run(result.tac, &result.loopRecords);
+    result.peepholeRules = peephole.getFired();
+    if (stats) {
+        for (const auto& kv : result.peepholeRules) stats->addTo("peephole", kv.first, kv.second);
+        stats->add("peephole.removed", result.peepholeRemoved);
+        stats->add("peephole.passes", peephole.getPasses());
+    }
+}
+
+static const size_t PIPELINE_RING_CAPACITY = 16;
+
+// 放入队列，满时等待消费者取走（消费者总会读到 last 批为止，不会死锁）
+template <typename T>
+static void pushBatch(SPSCRing<T>& ring, T& batch, long long& waits) {
+    while (!ring.tryPush(batch)) {
+        waits++;
+        this_thread::yield();
+    }
+}
+
+template <typename T>
+static void popBatch(SPSCRing<T>& ring, T& batch, long long& waits) {
+    while (!ring.tryPop(batch)) {
+        waits++;
+        this_thread::yield();
+    }
+}
+
+// 遇到第一个错误即停止所有阶段：语法线程发现语法错误后置 stop，词法线程随即停止扫描；
+// 词法错误使 token 流在出错位置截断，语法线程读完为止。报告的是源码中最靠前的那个错误，
+// 因此词法错误最多报告一个（顺序编译会报告全部词法错误）。
+static CompileResult compilePipelined(const string& source, const Parser& parser, const CompileOptions& options) {
+    CompileResult result;
+    Stats* stats = options.stats;
+    int pipelineSpan = stats ? stats->beginSpan("pipeline", "compiler") : -1;
+    size_t batchSize = options.batchSize ? options.batchSize : 1;
+
+    SPSCRing<TokenBatch> tokenRing(PIPELINE_RING_CAPACITY);
+    SPSCRing<EventBatch> eventRing(PIPELINE_RING_CAPACITY);
+    atomic<bool> stop(false);
+
+    // ---- 词法线程 ----
+    Lexer lexer;
+    long long lexStart = 0, lexEnd = 0, tokenBatches = 0, lexWaits = 0;
+    thread lexThread([&]() {
+        if (stats) lexStart = stats->nowNs();
+        lexer.scanInBatches(source, batchSize, true, [&](vector<Word>& tokens) {
+            if (stop.load(memory_order_acquire)) return false;
+            TokenBatch batch;
+            batch.tokens = move(tokens);
+            pushBatch(tokenRing, batch, lexWaits);
+            tokenBatches++;
+            return true;
+        });
+        TokenBatch end;
+        end.last = true;
+        pushBatch(tokenRing, end, lexWaits);
+        if (stats) lexEnd = stats->nowNs();
+    });
+
+    // ---- 语法线程 ----
+    const auto& actionTable = parser.getActionTable();
+    const auto& gotoTable = parser.getGotoTable();
+    const auto& productions = parser.getProductions();
+    bool accepted = false, syntaxFailed = false;
+    Diagnostic syntaxDiagnostic;
+    long long parseStart = 0, parseEnd = 0, eventBatches = 0, parsePopWaits = 0, parsePushWaits = 0;
+    map<string, long long> shifts, tokenKinds;
+    vector<long long> reductions(productions.size(), 0);
+    size_t peakDepth = 1;
+    thread parseThread([&]() {
+        if (stats) parseStart = stats->nowNs();
+        vector<int> stateStack(1, 0);
+        stack<int> braceLineStack;
+        int parenDepth = 0;
+        TokenBatch in;
+        size_t pos = 0;
+        // 取下一批 token（已读完最后一批时返回 false）
+        auto refill = [&]() {
+            while (pos == in.tokens.size()) {
+                if (in.last) return false;
+                popBatch(tokenRing, in, parsePopWaits);
+                pos = 0;
+                if (stats) for (const auto& t : in.tokens) if (t.sym != -1) tokenKinds[t.typeLabel]++;
+                if (options.keepTokens) result.tokens.insert(result.tokens.end(), in.tokens.begin(), in.tokens.end());
+            }
+            return true;
+        };
+        EventBatch out;
+        out.events.reserve(batchSize);
+        auto emit = [&](int prodId, const Word& w, const string& token) {
+            out.events.push_back({ prodId, w.line, w.col, token });
+            if (out.events.size() >= batchSize) {
+                pushBatch(eventRing, out, parsePushWaits);
+                eventBatches++;
+                out = EventBatch();
+                out.events.reserve(batchSize);
+            }
+        };
+
+        while (refill()) {      // token 流在词法错误处截断时，读完即停
+            int s = stateStack.back();
+            const Word& w = in.tokens[pos];
+            string a = terminalOf(w);
+            const auto& row = actionTable.at(s);
+            auto found = row.find(a);
+            if (found == row.end()) {
+                bool missingBrace = false;
+                syntaxDiagnostic = syntaxError(parser, s, a, w, parenDepth, braceLineStack, missingBrace);
+                syntaxFailed = true;
+                break;
+            }
+            const Action& act = found->second;
+            if (act.type == ActionType::SHIFT) {
+                if (a == "{") braceLineStack.push(w.line);
+                else if (a == "}" && !braceLineStack.empty()) braceLineStack.pop();
+                else if (a == "(") parenDepth++;
+                else if (a == ")") parenDepth--;
+                stateStack.push_back(act.target);
+                emit(-1, w, w.token);
+                pos++;
+                shifts[a]++;
+                peakDepth = max(peakDepth, stateStack.size());
+            }
+            else if (act.type == ActionType::REDUCE) {
+                const Production& p = productions[act.target];
+                reductions[act.target]++;
+                stateStack.resize(stateStack.size() - p.right.size());
+                emit(act.target, w, string());
+                stateStack.push_back(gotoTable.at(stateStack.back()).at(p.left));
+            }
+            else {
+                accepted = true;
+                break;
+            }
+        }
+        // 通知词法线程停止，并读完队列中剩余的批（词法线程总会送来 last 批）
+        stop.store(true, memory_order_release);
+        pos = in.tokens.size();
+        while (refill()) pos = in.tokens.size();
+        out.last = true;
+        pushBatch(eventRing, out, parsePushWaits);
+        eventBatches++;
+        if (stats) parseEnd = stats->nowNs();
+    });
+
+    // ---- 代码生成线程 ----
+    CodeGenerator codegen;
+    codegen.setRecordQuads(false);
+    long long codegenStart = 0, codegenEnd = 0, codegenWaits = 0;
+    thread codegenThread([&]() {
+        if (stats) codegenStart = stats->nowNs();
+        vector<SemItem> semStack;
+        vector<SemItem> popped;
+        EventBatch in;
+        do {
+            popBatch(eventRing, in, codegenWaits);
+            for (const auto& ev : in.events) {
+                if (ev.prodId < 0) {
+                    if (ev.token == "while") codegen.enterLoop();
+                    semStack.push_back({ ev.token, "", {}, {}, false, false, ev.line, ev.col });
+                    continue;
+                }
+                size_t n = productions[ev.prodId].right.size();
+                popped.assign(semStack.end() - n, semStack.end());
+                semStack.resize(semStack.size() - n);
+                codegen.setSourceLine(ev.line);
+                SemItem res = codegen.handleProduction(ev.prodId, popped, semStack);
+                semStack.push_back(res);
+            }
+        } while (!in.last);
+        if (stats) codegenEnd = stats->nowNs();
+    });
+
+    lexThread.join();
+    parseThread.join();
+    codegenThread.join();
+
+    if (syntaxFailed) result.diagnostics.push_back(syntaxDiagnostic);
+    else if (lexer.hasErrors()) result.diagnostics = lexer.getDiagnostics();
+    if (accepted) {
+        result.temps = codegen.numTemps();
+        result.conversions = codegen.numConversions();
+        for (const auto& d : codegen.getTypeDiagnostics()) result.diagnostics.push_back(d);
+        codegen.takeResults(result.tac, result.varTypes, result.loopRecords);
+        if (options.peephole && !result.hasErrors()) runPeephole(result, stats);
+    }
+
+    if (stats) {
+        stats->addSpan("lex", "pipeline", lexStart, lexEnd, 2);
+        stats->addSpan("parse", "pipeline", parseStart, parseEnd, 3);
+        stats->addSpan("codegen", "pipeline", codegenStart, codegenEnd, 4);
+        stats->endSpan(pipelineSpan);
+        stats->setThreadName(2, "lexer");
+        stats->setThreadName(3, "parser");
+        stats->setThreadName(4, "codegen");
+
+        long long tokenCount = 0, shifted = 0, reduced = 0;
+        for (const auto& kv : tokenKinds) { stats->addTo("tokens", kv.first, kv.second); tokenCount += kv.second; }
+        stats->add("lex.bytes", (long long)source.size());
+        stats->add("lex.tokens", tokenCount);
+        for (const auto& kv : shifts) { stats->addTo("shifts", kv.first, kv.second); shifted += kv.second; }
+        for (size_t k = 0; k < reductions.size(); k++) {
+            if (reductions[k]) stats->addTo("reductions", productionLabel(productions[k]), reductions[k]);
+            reduced += reductions[k];
+        }
+        stats->add("parse.shifts", shifted);
+        stats->add("parse.reductions", reduced);
+        stats->setMax("parse.stack_peak", (long long)peakDepth);
+        stats->add("pipeline.token_batches", tokenBatches);
+        stats->add("pipeline.event_batches", eventBatches);
+        stats->add("pipeline.lex_push_waits", lexWaits);
+        stats->add("pipeline.parse_pop_waits", parsePopWaits);
+        stats->add("pipeline.parse_push_waits", parsePushWaits);
+        stats->add("pipeline.codegen_pop_waits", codegenWaits);
+        if (accepted) {
+            stats->add("tac.instructions", (long long)result.tac.size());
+            stats->add("tac.temps", result.temps);
+            stats->add("tac.conversions", result.conversions);
+        }
+    }
+    result.ok = accepted && !result.hasErrors();
+    return result;
+}
+
+CompileResult compile(const string& source, const Parser& parser, const CompileOptions& options) {
+    if (options.pipeline && !options.recordParseSteps) return compilePipelined(source, parser, options);
+    CompileResult result;
+    Stats* stats = options.stats;
+    
+    // 阶段1:词法分析
+    Lexer lexer;
+    vector<Word> tokens;
+    {
+        ScopedTimer timer(stats, "lex");
+        tokens = lexer.performLexicalAnalysis(source);
+    }
+    if (stats) {
+        map<string, long long> tokenKinds;
+        for (const auto& t : tokens) if (t.sym != -1) tokenKinds[t.typeLabel]++;
+        for (const auto& kv : tokenKinds) stats->addTo("tokens", kv.first, kv.second);
+        stats->add("lex.bytes", (long long)source.size());
+        stats->add("lex.tokens", (long long)tokens.size() - 1);
+    }
+    if (lexer.hasErrors()) {
+        result.diagnostics = lexer.getDiagnostics();
+        if (options.keepTokens) result.tokens = move(tokens);
+        return result;
+    }
+
+    // 阶段2:语法分析和代码生成
+    CodeGenerator codegen;
+    codegen.setRecordQuads(options.recordParseSteps);
+    // 初始化LR(1)分析栈
+    vector<int> stateStack;     // 状态栈：存储分析过程中的状态编号（栈底在前）
+    stateStack.push_back(0);    // 初始状态为 0
+    vector<string> symbolStack; // 符号栈：存储已识别的符号
+    symbolStack.push_back("#"); // 栈底标记
+    vector<SemItem> semStack;   // 语义栈：存储语义信息（变量名、临时变量等）
+    stack<int> braceLineStack; // 代码块位置栈：记录每个{的行号
+    int parenDepth = 0;         // 未闭合的 ( 个数
+    int ptr = 0;                // 输入指针：指向当前处理的Token
+
+    // 获取分析表和相关数据结构
+    const auto& actionTable = parser.getActionTable();  // Action表：状态×终结符->动作
+    const auto& gotoTable = parser.getGotoTable();      // Goto表：状态×非终结符->新状态
+    const auto& productions = parser.getProductions();   // 产生式集合
+
+    // 移进、归约与栈深度的计数先记在局部变量中，分析结束（含出错返回）时一次记入 stats
+    int parseSpan = stats ? stats->beginSpan("parse_codegen", "compiler") : -1;
+    map<string, long long> shifts;
+    vector<long long> reductions(productions.size(), 0);
+    size_t peakDepth = 1;
+    auto finishParse = [&]() {
+        if (options.keepTokens) result.tokens = move(tokens);
+        if (!stats) return;
+        stats->endSpan(parseSpan);
+        long long shifted = 0, reduced = 0;
+        for (const auto& kv : shifts) { stats->addTo("shifts", kv.first, kv.second); shifted += kv.second; }
+        for (size_t k = 0; k < reductions.size(); k++) {
+            if (reductions[k]) stats->addTo("reductions", productionLabel(productions[k]), reductions[k]);
+            reduced += reductions[k];
+        }
+        stats->add("parse.shifts", shifted);
+        stats->add("parse.reductions", reduced);
+        stats->setMax("parse.stack_peak", (long long)peakDepth);
+    };
+
+    // 记录分析过程的一步（状态栈、符号栈按动作执行前的内容显示）
+    int step = 1;
+    string stStr, syStr;
+    auto record = [&](const string& a, const string& action, bool isError) {
+        result.parseSteps.push_back({ step++, stStr, syStr, a, action, codegen.getCurrentStepQuads(), isError });
+    };
+
+    // LR(1)分析主循环
+    while (true) {
+        // 获取当前状态和输入符号
+        int s = stateStack.back();        // 当前状态
+        const Word& w = tokens[ptr];      // 当前输入Token
+
+        string a = terminalOf(w);     // 将Token转换为分析表中使用的符号
+
+        // 状态栈、符号栈显示（超长时只显示栈顶一端）
+        if (options.recordParseSteps) {
+            codegen.clearCurrentStepQuads();  // 清空当前步骤的四元式字符串
+            stStr = stackTail(stateStack, 23, 20);
+            syStr = stackTail(symbolStack, 18, 15);
+        }
+
+        // 查找Action表中的动作
+        if (!actionTable.at(s).count(a)) {
+            // ========== 语法错误处理 ==========
+            bool missingBrace = false;
+            result.diagnostics.push_back(syntaxError(parser, s, a, w, parenDepth, braceLineStack, missingBrace));
+            if (options.recordParseSteps) record(a, missingBrace ? "错误: 缺少右花括号" : "错误: 语法不匹配", true);
+            finishParse();
+            return result;
+        }
+        // 获取动作
+        Action act = actionTable.at(s).at(a);
+
+        // ========== 移进动作 ==========
+        if (act.type == ActionType::SHIFT) {
+            // 如果遇到while关键字，进入循环处理
+            if (a == "while") {
+                codegen.enterLoop();  // 记录循环开始地址，初始化break/continue列表
+            }
+            // 跟踪代码块位置：遇到{时记录行号
+            if (a == "{") {
+                braceLineStack.push(w.line);
+            }
+            // 遇到}时弹出对应的{
+            else if (a == "}") {
+                if (!braceLineStack.empty()) {
+                    braceLineStack.pop();
+                }
+            }
+            else if (a == "(") parenDepth++;
+            else if (a == ")") parenDepth--;
+            if (options.recordParseSteps) record(a, "移进 S" + to_string(act.target), false);
+            // 执行移进：将新状态和符号压入栈
+            stateStack.push_back(act.target);
+            symbolStack.push_back(a);
+            // 保存Token的原始值和位置（用于代码生成与源位置记录）
+            semStack.push_back({ w.token, "", {}, {}, false, false, w.line, w.col });
+            ptr++;  // 移动输入指针
+            shifts[a]++;
+            peakDepth = max(peakDepth, stateStack.size());
+        }
+        // ========== 归约动作 ==========
+        else if (act.type == ActionType::REDUCE) {
+            // 获取产生式
+            const Production& p = productions[act.target];
+            reductions[act.target]++;
+            
+            // 从栈中弹出产生式右部长度的元素
+            vector<SemItem> popped;
+            for (int k = 0; k < (int)p.right.size(); k++) {
+                stateStack.pop_back();  // 弹出状态
+                symbolStack.pop_back();  // 弹出符号
+                popped.push_back(semStack.back());  // 保存语义信息
+                semStack.pop_back();
+            }
+            reverse(popped.begin(), popped.end());  // 反转顺序（栈是后进先出）
+            
+            // 执行语义动作：生成代码（行号用于类型错误信息）
+            codegen.setSourceLine(w.line);
+            SemItem res = codegen.handleProduction(act.target, popped, semStack);
+            if (options.recordParseSteps) record(a, "归约 r" + to_string(act.target), false);
+
+            symbolStack.push_back(p.left);
+            stateStack.push_back(gotoTable.at(stateStack.back()).at(p.left));
+            semStack.push_back(res);
+        }
+        else if (act.type == ActionType::ACCEPT) {
+            if (options.recordParseSteps) record(a, "ACCEPT", false);
+            break;
+        }
+    }
+    finishParse();
+    result.temps = codegen.numTemps();
+    result.conversions = codegen.numConversions();
+    for (const auto& d : codegen.getTypeDiagnostics()) result.diagnostics.push_back(d);
+    codegen.takeResults(result.tac, result.varTypes, result.loopRecords);
+    if (options.peephole && !result.hasErrors()) runPeephole(result, stats);
+    if (stats) {
+        stats->add("tac.instructions", (long long)result.tac.size());
+        stats->add("tac.temps", result.temps);
+        stats->add("tac.conversions", result.conversions);
+    }
+    result.ok = !result.hasErrors();
+    return result;
+}
+
+const Parser& sharedParser() {
+    static const Parser parser(nullptr, false);
+    return parser;
+}
+
+CompileResult compile(const string& source, const CompileOptions& options) {
+    return compile(source, sharedParser(), options);
+}
@@ -0,0 +1,63 @@
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include "types.h"
+#include "parser.h"
+#include "stats.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// === 嵌入用的编译接口 ===
+// compile() 完成词法分析、LR(1) 语法分析和代码生成，结果全部放在 CompileResult 中返回，
+// 编译过程不向控制台或文件输出任何内容。分析表由调用方构造一次后反复使用：
+// 编译只读取 Parser，多个线程可以共用同一个 Parser 同时编译。
+// 命令行程序（WhileCompiler）也通过它编译，再把结果格式化输出。
+
+// 语法分析过程的一步（只在 recordParseSteps 时记录，用于命令行显示分析过程）
+struct ParseTraceStep {
+    int step;
+    string stateStack;      // 状态栈，超长时只保留栈顶一端
+    string symbolStack;     // 符号栈，同上
+    string input;           // 当前输入符号
+    string action;          // "移进 S5"、"归约 r14"、"ACCEPT" 或 "错误: ..."
+    string quads;           // 本步归约生成的四元式
+    bool isError;
+};
+
+struct CompileOptions {
+    bool keepTokens = false;        // 在结果中保留 token 序列
+    bool recordParseSteps = false;  // 记录每一步的分析栈和动作（格式化开销与编译本身相当）
+    Stats* stats = nullptr;         // 计时与计数，为空时不记录
+    // 流水线编译：词法、语法、代码生成分别在三个线程中按批（batchSize 个 token / 事件）并行，
+    // 遇到第一个错误即停止。recordParseSteps 时不使用
+    bool pipeline = false;
+    size_t batchSize = 512;
+    bool peephole = true;           // 生成三地址码后运行窥孔优化（peephole.h），没有错误时才运行
+};
+
+struct CompileResult {
+    bool ok = false;                    // 没有任何错误，tac 可用
+    vector<Word> tokens;                // keepTokens 时为完整的 token 序列（末尾为结束符 #）
+    vector<ParseTraceStep> parseSteps;
+    vector<Diagnostic> diagnostics;     // 按发现的顺序：词法错误，或语法错误，或类型错误与警告
+    vector<TAC> tac;
+    map<string, string> varTypes;       // 变量名 -> "int"/"float"
+    vector<LoopRecord> loopRecords;
+    int temps = 0;                      // 使用的临时变量数
+    int conversions = 0;                // 插入的 itof / ftoi 条数
+    map<string, int> peepholeRules;     // 窥孔优化各规则的触发次数
+    int peepholeRemoved = 0;            // 窥孔优化删除的指令数
+
+    bool hasErrors() const;
+    // 错误的诊断文本（不含警告）
+    vector<string> errorMessages() const;
+};
+
+CompileResult compile(const string& source, const Parser& parser, const CompileOptions& options = CompileOptions());
+
+// 进程内共享的分析表：第一次调用时构造（不写出 items.txt / table.csv），之后只读
+const Parser& sharedParser();
+CompileResult compile(const string& source, const CompileOptions& options = CompileOptions());
+
+#endif // COMPILE_H
@@ -0,0 +1,521 @@
+#include "compilecache.h"
+#include "irformat.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+#if defined(_WIN32)
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace std;
+
+// 条目格式的版本，参与缓存键的计算
+static const uint32_t CACHE_VERSION = 3;
+static const char* const ENTRY_SUFFIX = ".wcc";
+static const char* const TEMP_PREFIX = ".tmp-";
+static const long long STALE_TEMP_SECONDS = 3600;   // 超过这个时间的临时文件视为写入者已退出，清理掉
+
+// ============================================================================
+// SHA-256
+// ============================================================================
+
+namespace {
+
+class Sha256 {
+private:
+    uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    uint8_t block[64];
+    size_t used = 0;
+    uint64_t length = 0;    // 已输入的字节数
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const uint8_t* p) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+
+public:
+    void update(const void* data, size_t n) {
+        const uint8_t* p = (const uint8_t*)data;
+        length += n;
+        while (n > 0) {
+            if (used == 0 && n >= 64) {     // 整块直接压缩，不经过缓冲区
+                compress(p);
+                p += 64;
+                n -= 64;
+                continue;
+            }
+            size_t take = min(n, 64 - used);
+            memcpy(block + used, p, take);
+            used += take;
+            p += take;
+            n -= take;
+            if (used == 64) {
+                compress(block);
+                used = 0;
+            }
+        }
+    }
+    void update(const string& s) { update(s.data(), s.size()); }
+
+    string hexDigest() {
+        uint64_t bits = length * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        uint8_t zero = 0;
+        while (used != 56) update(&zero, 1);
+        uint8_t len[8];
+        for (int i = 0; i < 8; i++) len[i] = (uint8_t)(bits >> (56 - 8 * i));
+        update(len, 8);
+        static const char* const digits = "0123456789abcdef";
+        string hex;
+        for (int i = 0; i < 8; i++) {
+            for (int shift = 28; shift >= 0; shift -= 4) hex += digits[(h[i] >> shift) & 15];
+        }
+        return hex;
+    }
+};
+
+// ============================================================================
+// 条目的编码与解码（小端序）
+// ============================================================================
+
+void put32(string& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out += (char)(v >> (8 * i));
+}
+
+void put64(string& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out += (char)(v >> (8 * i));
+}
+
+void putString(string& out, const string& s) {
+    put32(out, (uint32_t)s.size());
+    out += s;
+}
+
+// 按顺序读取，越界时 ok 置为 false，之后的读取都返回 0
+struct ByteReader {
+    const string& data;
+    size_t pos;
+    bool ok = true;
+
+    ByteReader(const string& data, size_t pos) : data(data), pos(pos) {}
+
+    uint64_t get(int bytes) {
+        if (!ok || data.size() - pos < (size_t)bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) v |= (uint64_t)(uint8_t)data[pos + i] << (8 * i);
+        pos += bytes;
+        return v;
+    }
+    string getString() {
+        size_t n = (size_t)get(4);
+        if (!ok || data.size() - pos < n) {
+            ok = false;
+            return string();
+        }
+        pos += n;
+        return data.substr(pos - n, n);
+    }
+};
+
+uint64_t fnv1a64(const char* p, size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (uint8_t)p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// 文件头：魔数、版本、键（64 字节）、载荷长度、载荷的 FNV-1a 64 位校验和
+const size_t HEADER_SIZE = 4 + 4 + 64 + 8 + 8;
+
+// ============================================================================
+// 目录操作
+// ============================================================================
+
+struct DirEntry {
+    string name;
+    long long size;
+    long long mtime;    // 秒
+};
+
+bool makeDirectory(const string& path) {
+#if defined(_WIN32)
+    return _mkdir(path.c_str()) == 0;
+#else
+    return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
+
+vector<DirEntry> listDirectory(const string& path) {
+    vector<DirEntry> entries;
+#if defined(_WIN32)
+    _finddata_t fd;
+    intptr_t handle = _findfirst((path + "/*").c_str(), &fd);
+    if (handle == -1) return entries;
+    do {
+        if (!(fd.attrib & _A_SUBDIR)) entries.push_back({ fd.name, (long long)fd.size, (long long)fd.time_write });
+    } while (_findnext(handle, &fd) == 0);
+    _findclose(handle);
+#else
+    DIR* d = opendir(path.c_str());
+    if (!d) return entries;
+    while (dirent* e = readdir(d)) {
+        struct stat st;
+        string name = e->d_name;
+        if (stat((path + "/" + name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            entries.push_back({ name, (long long)st.st_size, (long long)st.st_mtime });
+    }
+    closedir(d);
+#endif
+    return entries;
+}
+
+// 把修改时间设为当前时间，作为 LRU 的“最近使用”
+void touch(const string& path) {
+#if defined(_WIN32)
+    _utime(path.c_str(), nullptr);
+#else
+    utime(path.c_str(), nullptr);
+#endif
+}
+
+// 同一目录下不会重复的临时文件名：进程号、本进程内的序号和当前时刻
+string tempName() {
+    static atomic<long long> sequence(0);
+#if defined(_WIN32)
+    long long pid = _getpid();
+#else
+    long long pid = getpid();
+#endif
+    long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    return string(TEMP_PREFIX) + to_string(pid) + "-" + to_string(++sequence) + "-" + to_string(now);
+}
+
+bool endsWith(const string& s, const string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+string sha256Hex(const string& data) {
+    Sha256 sha;
+    sha.update(data);
+    return sha.hexDigest();
+}
+
+// ============================================================================
+// CompileCache
+// ============================================================================
+
+CompileCache::CompileCache(const string& dir, unsigned long long maxBytes) : dir(dir), maxBytes(maxBytes) {
+    makeDirectory(dir);     // 已存在时失败，无妨；无法创建时写入失败计入 storeFailures
+}
+
+string CompileCache::entryPath(const string& key) const {
+    return dir + "/" + key + ENTRY_SUFFIX;
+}
+
+// 文法（全部产生式与状态数）、条目与二进制三地址码的版本、影响结果的选项，再接源程序字节。
+// 流水线编译出错时只报告第一个错误，与顺序编译的诊断不同；窥孔优化改变三地址码，两者都计入键中
+string CompileCache::keyOf(const string& source, const Parser& parser, const CompileOptions& options) {
+    string header = "while-compile-cache " + to_string(CACHE_VERSION) + " ir " + to_string(IR_VERSION) + "\n";
+    for (const auto& p : parser.getProductions()) {
+        header += p.left + " ->";
+        for (const auto& sym : p.right) header += " " + sym;
+        header += "\n";
+    }
+    header += "states " + to_string(parser.getNumStates()) + "\n";
+    header += string("pipeline ") + (options.pipeline ? "1" : "0") + "\n";
+    header += string("peephole ") + (options.peephole ? "1" : "0") + "\n";
+    Sha256 sha;
+    put64(header, source.size());
+    sha.update(header);
+    sha.update(source);
+    return sha.hexDigest();
+}
+
+bool CompileCache::load(const string& key, CompileResult& result) {
+    string path = entryPath(key);
+    ifstream in(path, ios::binary | ios::ate);
+    streamoff size = in.tellg();
+    if (!in || size < 0) return false;
+    string bytes((size_t)size, '\0');
+    in.seekg(0);
+    in.read(&bytes[0], bytes.size());
+    if (!in) return false;
+    in.close();
+
+    // 文件头与校验和
+    bool valid = bytes.size() >= HEADER_SIZE && memcmp(bytes.data(), "WCCH", 4) == 0 &&
+                 bytes.compare(8, 64, key) == 0;
+    ByteReader header(bytes, 4);
+    uint32_t version = (uint32_t)header.get(4);
+    header.pos = 72;
+    uint64_t payloadSize = header.get(8);
+    uint64_t checksum = header.get(8);
+    valid = valid && version == CACHE_VERSION && payloadSize == bytes.size() - HEADER_SIZE &&
+            checksum == fnv1a64(bytes.data() + HEADER_SIZE, bytes.size() - HEADER_SIZE);
+
+    CompileResult r;
+    if (valid) {
+        ByteReader reader(bytes, HEADER_SIZE);
+        r.ok = reader.get(1) != 0;
+        r.temps = (int)reader.get(4);
+        r.conversions = (int)reader.get(4);
+        uint32_t diagnostics = (uint32_t)reader.get(4);
+        for (uint32_t k = 0; k < diagnostics && reader.ok; k++) {
+            Diagnostic d;
+            d.kind = (DiagnosticKind)reader.get(1);
+            d.isError = reader.get(1) != 0;
+            d.line = (int)reader.get(4);
+            d.col = (int)reader.get(4);
+            d.message = reader.getString();
+            r.diagnostics.push_back(d);
+        }
+        uint32_t loops = (uint32_t)reader.get(4);
+        for (uint32_t k = 0; k < loops && reader.ok; k++) {
+            LoopRecord l;
+            l.testStart = (int)reader.get(4);
+            l.backEdge = (int)reader.get(4);
+            l.exitAddr = (int)reader.get(4);
+            l.depth = (int)reader.get(4);
+            l.line = (int)reader.get(4);
+            l.col = (int)reader.get(4);
+            l.endLine = (int)reader.get(4);
+            r.loopRecords.push_back(l);
+        }
+        r.peepholeRemoved = (int)reader.get(4);
+        uint32_t rules = (uint32_t)reader.get(4);
+        for (uint32_t k = 0; k < rules && reader.ok; k++) {
+            string name = reader.getString();
+            r.peepholeRules[name] = (int)reader.get(4);
+        }
+        // 每条指令的源位置（.wir 不保存），解码三地址码后逐条填回
+        uint32_t positions = (uint32_t)reader.get(4);
+        vector<pair<int, int>> lineCol;
+        if (reader.ok && positions <= (bytes.size() - reader.pos) / 8) lineCol.resize(positions);
+        else valid = false;
+        for (auto& lc : lineCol) {
+            lc.first = (int)reader.get(4);
+            lc.second = (int)reader.get(4);
+        }
+        // 三地址码在载荷末尾，直接在读入的缓冲区上校验和解码
+        size_t irSize = (size_t)reader.get(4);
+        valid = valid && reader.ok && bytes.size() - reader.pos == irSize;
+        if (valid) {
+            IRView view(bytes.data() + reader.pos, irSize);
+            string error;
+            valid = view.validate(error);
+            if (valid) view.toTAC(r.tac, r.varTypes);
+            valid = valid && r.tac.size() == lineCol.size();
+            for (size_t i = 0; valid && i < lineCol.size(); i++) {
+                r.tac[i].line = lineCol[i].first;
+                r.tac[i].col = lineCol[i].second;
+            }
+        }
+    }
+    if (!valid) {
+        remove(path.c_str());
+        counters.corrupt++;
+        return false;
+    }
+    touch(path);
+    result = move(r);
+    return true;
+}
+
+bool CompileCache::store(const string& key, const CompileResult& result) {
+    string ir, error;
+    if (!writeIR(result.tac, result.varTypes, ir, error)) return false;
+
+    string payload;
+    payload += (char)(result.ok ? 1 : 0);
+    put32(payload, (uint32_t)result.temps);
+    put32(payload, (uint32_t)result.conversions);
+    put32(payload, (uint32_t)result.diagnostics.size());
+    for (const auto& d : result.diagnostics) {
+        payload += (char)d.kind;
+        payload += (char)(d.isError ? 1 : 0);
+        put32(payload, (uint32_t)d.line);
+        put32(payload, (uint32_t)d.col);
+        putString(payload, d.message);
+    }
+    put32(payload, (uint32_t)result.loopRecords.size());
+    for (const auto& l : result.loopRecords) {
+        put32(payload, (uint32_t)l.testStart);
+        put32(payload, (uint32_t)l.backEdge);
+        put32(payload, (uint32_t)l.exitAddr);
+        put32(payload, (uint32_t)l.depth);
+        put32(payload, (uint32_t)l.line);
+        put32(payload, (uint32_t)l.col);
+        put32(payload, (uint32_t)l.endLine);
+    }
+    put32(payload, (uint32_t)result.peepholeRemoved);
+    put32(payload, (uint32_t)result.peepholeRules.size());
+    for (const auto& kv : result.peepholeRules) {
+        putString(payload, kv.first);
+        put32(payload, (uint32_t)kv.second);
+    }
+    put32(payload, (uint32_t)result.tac.size());
+    for (const auto& t : result.tac) {
+        put32(payload, (uint32_t)t.line);
+        put32(payload, (uint32_t)t.col);
+    }
+    putString(payload, ir);
+
+    string bytes = "WCCH";
+    put32(bytes, CACHE_VERSION);
+    bytes += key;
+    put64(bytes, payload.size());
+    put64(bytes, fnv1a64(payload.data(), payload.size()));
+    bytes += payload;
+
+    // 先完整写入临时文件，再改名为条目名
+    string temp = dir + "/" + tempName();
+    {
+        ofstream out(temp, ios::binary);
+        out.write(bytes.data(), (streamsize)bytes.size());
+        out.close();
+        if (!out) {
+            remove(temp.c_str());
+            return false;
+        }
+    }
+    string path = entryPath(key);
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        // Windows 上目标已存在时 rename 失败：内容相同的条目已由别的进程写入
+        remove(temp.c_str());
+        return ifstream(path).good();
+    }
+    return true;
+}
+
+// 条目总大小超过上限时按修改时间从旧到新删除；顺带清理写入者已退出而遗留的临时文件
+void CompileCache::evict() {
+    vector<DirEntry> entries;
+    long long total = 0;
+    long long now = (long long)time(nullptr);
+    for (auto& e : listDirectory(dir)) {
+        if (endsWith(e.name, ENTRY_SUFFIX)) {
+            total += e.size;
+            entries.push_back(e);
+        } else if (e.name.compare(0, strlen(TEMP_PREFIX), TEMP_PREFIX) == 0 && now - e.mtime > STALE_TEMP_SECONDS) {
+            remove((dir + "/" + e.name).c_str());
+        }
+    }
+    if ((unsigned long long)total <= maxBytes) return;
+    sort(entries.begin(), entries.end(), [](const DirEntry& a, const DirEntry& b) {
+        return a.mtime != b.mtime ? a.mtime < b.mtime : a.name < b.name;
+    });
+    for (const auto& e : entries) {
+        if ((unsigned long long)total <= maxBytes) break;
+        // 别的进程可能已经删除了它，只统计本进程删除成功的
+        if (remove((dir + "/" + e.name).c_str()) == 0) {
+            counters.evictions++;
+            counters.evictedBytes += e.size;
+        }
+        total -= e.size;
+    }
+}
+
+CompileResult CompileCache::compile(const string& source, const Parser& parser, const CompileOptions& options, bool* hit) {
+    Stats* stats = options.stats;
+    if (hit) *hit = false;
+    if (options.keepTokens || options.recordParseSteps) {
+        counters.bypassed++;
+        if (stats) stats->add("cache.bypassed");
+        return ::compile(source, parser, options);
+    }
+
+    string key;
+    CompileResult result;
+    {
+        ScopedTimer timer(stats, "cache.lookup");
+        key = keyOf(source, parser, options);
+        long long corrupt = counters.corrupt;
+        bool found = load(key, result);
+        if (stats) stats->add("cache.corrupt", counters.corrupt - corrupt);
+        if (found) {
+            counters.hits++;
+            if (stats) stats->add("cache.hits");
+            if (hit) *hit = true;
+            return result;
+        }
+    }
+    counters.misses++;
+    if (stats) stats->add("cache.misses");
+
+    result = ::compile(source, parser, options);
+    {
+        ScopedTimer timer(stats, "cache.store");
+        if (store(key, result)) {
+            counters.stores++;
+            long long evictions = counters.evictions;
+            evict();
+            if (stats) {
+                stats->add("cache.stores");
+                stats->add("cache.evictions", counters.evictions - evictions);
+            }
+        } else {
+            counters.storeFailures++;
+            if (stats) stats->add("cache.store_failures");
+        }
+    }
+    return result;
+}
+
+void CompileCache::usage(long long& entries, long long& bytes) const {
+    entries = 0;
+    bytes = 0;
+    for (const auto& e : listDirectory(dir)) {
+        if (!endsWith(e.name, ENTRY_SUFFIX)) continue;
+        entries++;
+        bytes += e.size;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef COMPILECACHE_H
+#define COMPILECACHE_H
+
+#include "compile.h"
+#include <string>
+
+// === 编译缓存 ===
+// 以内容寻址的磁盘缓存：键是 SHA-256(源程序字节、文法与缓存格式版本、影响结果的编译选项)，
+// 每个条目是缓存目录中名为 <键>.wcc 的一个文件，保存诊断信息、循环记录和二进制三地址码（.wir）。
+// 命中时只读一个文件，不做词法和语法分析。
+//   - 写入先写到同目录下的临时文件，再 rename 成条目名，读者看到的要么是完整的条目，要么没有；
+//     内容相同的键由谁写入都一样，多个进程可以共用一个缓存目录；
+//   - 命中时更新条目的修改时间，总大小超过上限时按修改时间从旧到新删除（LRU）；
+//   - 条目带校验和，读到损坏或不匹配的条目时删除并按未命中处理。
+// 需要 token 序列或分析过程（keepTokens / recordParseSteps）的编译不经过缓存。
+// 代码生成或诊断文本有变化时增加 compilecache.cpp 中的 CACHE_VERSION，使旧条目全部失效。
+
+struct CacheCounters {
+    long long hits = 0;
+    long long misses = 0;
+    long long bypassed = 0;         // 需要 token 或分析过程，直接编译
+    long long stores = 0;
+    long long storeFailures = 0;    // 无法写入（目录不可写、三地址码无法编码等）
+    long long corrupt = 0;          // 校验失败而删除的条目
+    long long evictions = 0;
+    long long evictedBytes = 0;
+};
+
+class CompileCache {
+private:
+    string dir;
+    unsigned long long maxBytes;
+    CacheCounters counters;
+
+    string entryPath(const string& key) const;
+    bool load(const string& key, CompileResult& result);
+    bool store(const string& key, const CompileResult& result);
+    void evict();
+
+public:
+    // maxBytes 为缓存目录中条目的总大小上限；目录不存在时创建
+    explicit CompileCache(const string& dir, unsigned long long maxBytes = 64ULL * 1024 * 1024);
+
+    // 缓存键：64 个十六进制字符
+    string keyOf(const string& source, const Parser& parser, const CompileOptions& options);
+
+    // 命中时返回缓存的结果，否则调用 compile() 并写入缓存；hit 不为空时填入是否命中
+    CompileResult compile(const string& source, const Parser& parser, const CompileOptions& options = CompileOptions(),
+                          bool* hit = nullptr);
+
+    const CacheCounters& getCounters() const { return counters; }
+    const string& getDirectory() const { return dir; }
+    // 当前缓存目录中条目的个数与总字节数
+    void usage(long long& entries, long long& bytes) const;
+};
+
+// SHA-256 摘要的十六进制形式
+string sha256Hex(const string& data);
+
+#endif // COMPILECACHE_H
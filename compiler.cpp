@@ -1,406 +1,321 @@
 #include "compiler.h"
-#include <iostream>
-#include <iomanip>
+#include "optimizer.h"
+#include "ssa.h"
+#include "evaluator.h"
+#include "profiler.h"
+#include "vm.h"
+#include "jit.h"
+#include "cbackend.h"
+#include "asmbackend.h"
+#include "irformat.h"
+#include "dataflow.h"
+#include <fstream>
 #include <algorithm>
+#include <chrono>
 
 using namespace std;
 
-// 语法错误诊断函数
-static string diagnoseSyntaxError(const string& currentSymbol, const set<string>& expected, 
-                                  const stack<string>& symbolStack, const vector<Word>& tokens, int ptr) {
-    // 是否缺少分号
-    if (expected.count(";")) {
-        // 检查当前符号是否是语句的延续
-        if (currentSymbol != ";" && currentSymbol != "#") {
-            return "缺少分号 ';'。建议：在语句末尾添加分号";
+WhileCompiler::WhileCompiler() : parser(&stats) {
+}
+
+void WhileCompiler::setOutput(OutputSink& sink) {
+    output = &sink;
+}
+
+void WhileCompiler::run(const string& input) {
+    ScopedTimer timer(&stats, "compile");
+    runStages(input, *output);
+    output->flush();
+}
+
+void WhileCompiler::runStages(const string& input, OutputSink& out) {
+    // 使用编译缓存时不需要 token 序列和分析过程，命中时直接取缓存的结果
+    CompileOptions options;
+    options.keepTokens = !cache;
+    options.recordParseSteps = !pipeline && !cache;
+    options.pipeline = pipeline;
+    options.peephole = peephole;
+    options.stats = &stats;
+    bool cacheHit = false;
+    result = cache ? cache->compile(input, parser, options, &cacheHit) : compile(input, parser, options);
+    errorMessages = result.errorMessages();
+
+    bool lexicalError = false, syntaxError = false;
+    string syntaxMessage;
+    for (const auto& d : result.diagnostics) {
+        if (d.kind == DiagnosticKind::LEXICAL) {
+            lexicalError = true;
+            out << "错误: " << d.message << '\n';
+        } else if (d.kind == DiagnosticKind::SYNTAX) {
+            syntaxError = true;
+            syntaxMessage = d.message;
         }
     }
-    
-    // 是否缺少右括号
-    if (expected.count(")")) {
-        // 检查符号栈中是否有未匹配的左括号
-        stack<string> tmpCheck = symbolStack;  //复制栈
-        vector<string> symbols; //创建一个向量
-        while (!tmpCheck.empty()) {
-            symbols.push_back(tmpCheck.top()); //将栈顶符号存入symbols
-            tmpCheck.pop();
-        }
-        reverse(symbols.begin(), symbols.end()); //这样就与源代码里的顺序一样了
-        
-        int openParens = 0, closeParens = 0; //统计计数
-        for (const auto& sym : symbols) {
-            if (sym == "(") openParens++;
-            else if (sym == ")") closeParens++;
-        }
-        
-        if (openParens > closeParens) {
-            return "缺少右括号 ')'。建议：检查是否有未闭合的左括号 '('";
+
+    // 阶段1:词法分析结果；使用编译缓存时只输出是否命中
+    if (cache) {
+        out << "编译缓存: " << (cacheHit ? "命中，未进行词法与语法分析" : "未命中，编译结果已写入缓存")
+            << " (" << cache->getDirectory() << ")\n";
+    } else {
+        out << "--- 词法分析结果 ---\n";
+        out << pad("Token", 15) << pad("符号码", 10) << pad("类型", 15) << pad("行号", 8) << pad("列号", 8) << '\n';
+        ScopedTimer timer(&stats, "print_tokens");
+        for (auto& t : result.tokens) {
+            if (t.sym == -1) continue;
+            out << pad(t.token, 15) << pad(t.sym, 10) << pad(t.typeLabel, 15) << pad(t.line, 8) << pad(t.col, 8) << '\n';
         }
+        out << string(100, '-') << '\n';
     }
     
-    // 是否缺少右花括号
-    if (expected.count("}")) {
-        stack<string> tmpCheck = symbolStack;
-        vector<string> symbols;
-        while (!tmpCheck.empty()) {
-            symbols.push_back(tmpCheck.top());
-            tmpCheck.pop();
-        }
-        reverse(symbols.begin(), symbols.end());
-        
-        int openBraces = 0, closeBraces = 0;
-        for (const auto& sym : symbols) {
-            if (sym == "{") openBraces++;
-            else if (sym == "}") closeBraces++;
+    if (lexicalError) {
+        out << "\n--- 错误汇总 ---\n";
+        for (auto& err : errorMessages) {
+            out << err << '\n';
         }
-        
-        if (openBraces > closeBraces) {
-            // 这里只能接收到传参进来的符号栈，具体定位在主循环中
-            return "缺少右花括号 '}'。建议：检查是否有未闭合的左花括号 '{'";
+        out << string(100, '-') << '\n';
+        return;
+    }
+
+    // 阶段2:语法分析过程（出错的一步之前先输出诊断信息）；流水线编译和使用编译缓存时不记录分析过程
+    if (cache) {
+        if (syntaxError) out << "\n" << syntaxMessage << '\n';
+    } else if (pipeline) {
+        out << "流水线编译: 词法、语法分析与代码生成并行执行，不记录分析过程\n";
+        if (syntaxError) out << "\n" << syntaxMessage << '\n';
+    } else {
+        out << pad("步骤", 6) << pad("状态栈", 25) << pad("符号栈", 20) << pad("当前输入", 12) << pad("动作", 15) << '\n';
+        ScopedTimer timer(&stats, "print_parse");
+        for (const auto& st : result.parseSteps) {
+            if (st.isError) out << "\n" << syntaxMessage << '\n';
+            out << pad(st.step, 6) << pad(st.stateStack, 25) << pad(st.symbolStack, 20) << pad(st.input, 12);
+            if (st.isError) out << st.action << '\n';
+            else out << pad(st.action, 15) << st.quads << '\n';
         }
     }
+    if (syntaxError) return;
+
+    out << string(100, '-') << '\n';
     
-    // 检查运算符位置错误
-    if (currentSymbol == "+" || currentSymbol == "-" || currentSymbol == "*" || currentSymbol == "/") {
-        // 如果期望的是标识符、数字或左括号，可能是运算符位置错误
-        if (expected.count("i") || expected.count("n") || expected.count("(")) {
-            return "运算符位置错误：'" + currentSymbol + "' 出现在不期望的位置。建议：检查表达式语法";
+    if (!errorMessages.empty()) {
+        out << "\n--- 错误汇总 ---\n";
+        for (auto& err : errorMessages) {
+            out << err << '\n';
         }
+        return;
     }
     
-    // 检查关键字拼写错误（如果当前符号是标识符，但期望的是关键字）
-    set<string> keywords = {"while", "break", "continue", "int", "float", "true", "false"};
-    if (currentSymbol == "i" && !expected.count("i")) {
-        // 当前是标识符，但期望的不是标识符，可能是关键字拼写错误
-        for (const auto& kw : keywords) {
-            if (expected.count(kw)) {
-                return "可能是关键字拼写错误。当前是标识符，但期望关键字 '" + kw + "'";
+    // 打印生成的三地址码
+    {
+        ScopedTimer timer(&stats, "print_tac");
+        out << "\n--- 生成的三地址码 (TAC) ---\n";
+        printTACCode(result.tac, out);
+        if (!result.peepholeRules.empty()) {
+            out << "窥孔优化: 删除 " << result.peepholeRemoved << " 条指令 (";
+            bool first = true;
+            for (const auto& kv : result.peepholeRules) {
+                out << (first ? "" : ", ") << kv.first << " x" << kv.second;
+                first = false;
             }
+            out << ")\n";
         }
     }
     
-    // 检查是否在表达式中间遇到意外的符号
-    if (expected.count("i") || expected.count("n") || expected.count("(") || 
-        expected.count("true") || expected.count("false")) {
-        if (currentSymbol == "}" || currentSymbol == ";" || currentSymbol == ")") {
-            return "表达式不完整。建议：检查表达式是否缺少操作数或运算符";
+    // 类型推断结果：每个变量的类型、插入的转换条数、float 赋给 int 的截断提示
+    {
+        ScopedTimer timer(&stats, "typecheck");
+        int ints = 0, floats = 0;
+        for (const auto& kv : result.varTypes) (kv.second == "float" ? floats : ints)++;
+        out << "\n类型: " << ints << " 个 int 变量, " << floats << " 个 float 变量, 插入 "
+            << result.conversions << " 条类型转换\n";
+        for (const auto& d : result.diagnostics) if (!d.isError) out << "  警告: " << d.message << '\n';
+        for (const auto& p : checkTACTypes(result.tac, result.varTypes)) out << "  类型检查: " << p << '\n';
+    }
+    
+    // 控制流图、支配关系与循环，并与代码生成阶段记录的循环嵌套核对
+    if (showCFG) {
+        ScopedTimer timer(&stats, "cfg");
+        CFG cfg(result.tac);
+        cfg.print(out);
+        vector<string> problems = cfg.verifyLoops(result.loopRecords);
+        if (problems.empty()) {
+            out << "循环嵌套核对: 与代码生成记录一致\n";
+        } else {
+            for (const auto& p : problems) out << "循环嵌套核对: " << p << '\n';
+        }
+        ReachingDefinitions reaching(cfg);
+        LivenessAnalysis liveness(cfg);
+        out << "到达定值: " << reaching.numDefinitions() << " 个定值点，迭代 "
+            << reaching.getResult().iterations << " 次\n";
+        out << "活跃变量: " << liveness.numNames() << " 个名称，迭代 "
+            << liveness.getResult().iterations << " 次\n";
+        for (const auto& bb : cfg.getBlocks()) {
+            out << "  B" << bb.id << " 入口活跃:";
+            for (int k = 0; k < liveness.numNames(); k++) {
+                if (liveness.liveAtBlockEntry(bb.id, liveness.nameOf(k))) out << " " << liveness.nameOf(k);
+            }
+            out << '\n';
         }
     }
     
-    return "";  // 未识别到特定模式，返回空字符串
-}
-
-WhileCompiler::WhileCompiler() {
-}
-
-void WhileCompiler::run(const string& input) {
-    hasError = false;
-    errorMessages.clear(); 
-    lexer.clearErrors();
+    // SSA 形式，以及稀疏条件常量传播和 SSA 死代码删除之后的结果
+    if (showSSA) {
+        ScopedTimer timer(&stats, "ssa");
+        SSAForm ssa(result.tac, result.varTypes);
+        out << "\n--- SSA 形式 (" << ssa.numPhis() << " 个 φ 函数) ---\n";
+        ssa.print(out);
+        ssa.propagateConstants();
+        ssa.eliminateDeadCode();
+        out << "\n--- 常量传播与死代码删除之后 ---\n";
+        ssa.print(out);
+        vector<TAC> back;
+        if (ssa.destruct(back)) {
+            out << "\n--- 转回三地址码 ---\n";
+            printTACCode(back, out);
+        }
+        for (const auto& kv : ssa.getStats()) out << "  " << kv.first << ": " << kv.second << '\n';
+    }
     
-    // 阶段1:词法分析
-    vector<Word> tokens = lexer.performLexicalAnalysis(input);
-
-    cout << "--- 词法分析结果 ---" << endl;
-    cout << left << setw(15) << "Token" << setw(10) << "符号码" << setw(15) << "类型" << setw(8) << "行号" << setw(8) << "列号" << endl;
-    for (auto& t : tokens) {
-        if (t.sym == -1) continue;
-        cout << left << setw(15) << t.token << setw(10) << t.sym << setw(15) << t.typeLabel << setw(8) << t.line << setw(8) << t.col << endl;
+    // 优化并打印优化后的三地址码
+    vector<TAC> optimized;
+    if (optimize) {
+        ScopedTimer timer(&stats, "optimize");
+        TACOptimizer optimizer(result.varTypes);
+        optimized = optimizer.optimize(result.tac);
+        stats.add("tac.optimized_instructions", (long long)optimized.size());
+        out << "\n--- 优化后的三地址码 (TAC) ---\n";
+        printTACCode(optimized, out);
+        optimizer.printReport(out);
+        for (const auto& p : checkTACTypes(optimized, result.varTypes)) out << "优化后类型检查: " << p << '\n';
     }
-    cout << string(100, '-') << endl;
     
-    if (lexer.hasErrors()) {
-        cout << "\n--- 错误汇总 ---" << endl;
-        for (auto& err : lexer.getErrorMessages()) {
-            cout << err << endl;
+    // 统计实际执行的指令数（优化前后对比）
+    if (countExec) {
+        ScopedTimer timer(&stats, "evaluate");
+        TACEvaluator evaluator(result.varTypes);
+        out << "\n--- 执行统计 (参考求值) ---\n";
+        EvalResult base = evaluator.run(result.tac);
+        out << "优化前执行指令数: " << base.steps << (base.limitHit ? " (达到步数上限)" : "")
+            << ", 其中跳转 " << base.branches << '\n';
+        if (!base.ok) out << "运行时错误: " << base.error << '\n';
+        if (optimize) {
+            EvalResult opt = evaluator.run(optimized);
+            out << "优化后执行指令数: " << opt.steps << (opt.limitHit ? " (达到步数上限)" : "")
+                << ", 其中跳转 " << opt.branches << '\n';
+            if (!opt.ok) out << "运行时错误: " << opt.error << '\n';
+            if (base.ok && opt.ok && !base.limitHit && !opt.limitHit) {
+                bool same = true;
+                for (const auto& kv : base.vars) {
+                    // 优化后从未被赋值的变量（如删除了 d := d）结束时仍是初始值 0
+                    auto it = opt.vars.find(kv.first);
+                    ConstVal v = (it != opt.vars.end()) ? it->second : convertConst(ConstVal(), kv.second.isFloat);
+                    if (formatConst(v) != formatConst(kv.second)) same = false;
+                }
+                out << "结束时变量状态" << (same ? "一致" : "不一致！") << '\n';
+            }
         }
-        cout << string(100, '-') << endl;
-        return;
+    }
+    
+    // 执行剖析：剖析生成的三地址码（循环按代码生成的记录划分），按源位置报告热点
+    if (profileExec) {
+        ScopedTimer timer(&stats, "profile");
+        TACProfiler profiler(result.varTypes);
+        ProfileResult profile = profiler.run(result.tac, result.loopRecords);
+        stats.add("profile.steps", profile.eval.steps);
+        TACProfiler::printReport(profile, result.tac, out);
     }
 
-    // 阶段2:语法分析和代码生成
-    // 初始化LR(1)分析栈
-    stack<int> stateStack;      // 状态栈：存储分析过程中的状态编号
-    stateStack.push(0);         // 初始状态为 0
-    stack<string> symbolStack;  // 符号栈：存储已识别的符号
-    symbolStack.push("#");      // 栈底标记
-    vector<SemItem> semStack;   // 语义栈：存储语义信息（变量名、临时变量等）
-    stack<int> braceLineStack; // 代码块位置栈：记录每个{的行号
-    int ptr = 0;                // 输入指针：指向当前处理的Token
-
-    // 获取分析表和相关数据结构
-    const auto& actionTable = parser.getActionTable();  // Action表：状态×终结符->动作
-    const auto& gotoTable = parser.getGotoTable();      // Goto表：状态×非终结符->新状态
-    const auto& productions = parser.getProductions();   // 产生式集合
-    const auto& states = parser.getStates();            // LR(1)项目集集合
-    const auto& Vt = parser.getVt();                    // 终结符集合
-    const auto& Vn = parser.getVn();                    // 非终结符集合
-
-    // 输出语法分析过程表头
-    cout << left << setw(6) << "步骤" << setw(25) << "状态栈" << setw(20) << "符号栈" << setw(12) << "当前输入" << setw(15) << "动作" << endl;
-    int step = 1;
-
-    // LR(1)分析主循环
-    while (true) {
-        codegen.clearCurrentStepQuads();  // 清空当前步骤的四元式字符串
-        
-        // 获取当前状态和输入符号
-        int s = stateStack.top();         // 当前状态
-        Word w = tokens[ptr];             // 当前输入Token
-
-        // 将Token转换为分析表中使用的符号
-        // 标识符统一映射为 "i"，数字映射为 "n"
-        // 关键字（36-42）或其他符号直接使用token值
-        string a;
-        if (w.sym >= 36 && w.sym <= 42) a = w.token;  // 关键字
-        else if (w.token == "true" || w.token == "false") a = w.token;  // 布尔值
-        else a = (w.sym == 0 ? "i" : (w.sym == 1 ? "n" : w.token));  // 标识符"i", 数字"n", 其他原值
-
-        // 状态栈显示
-        string stStr = ""; 
-        stack<int> tmpS = stateStack; 
-        vector<int> vS; //临时容器
-        while (!tmpS.empty()) { 
-            vS.push_back(tmpS.top()); //将栈顶状态存入vS
-            tmpS.pop(); 
-        }
-        reverse(vS.begin(), vS.end()); //这样就与源代码里的顺序一样了
-        for (int x : vS) {
-            if (stStr.length() > 0) stStr += " ";
-            stStr += to_string(x); //将状态转换为字符串并存入stStr
-        }
-        // 限制状态栈显示长度
-        if (stStr.length() > 23) {
-            stStr = "..." + stStr.substr(stStr.length() - 20);
-        }
+    // 在字节码虚拟机上执行（优化后的代码优先）
+    if (runVM) {
+        ScopedTimer timer(&stats, "vm");
+        const vector<TAC>& program = optimize ? optimized : result.tac;
+        TACVM vm(program, result.varTypes);
+        auto begin = chrono::steady_clock::now();
+        VMResult r = vm.run();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        out << "\n--- 虚拟机执行 ---\n";
+        out << "字节码 " << vm.numInstructions() << " 条，槽位 " << vm.numSlots()
+            << " 个（动态类型 " << vm.numDynamicSlots() << " 个）\n";
+        out << "执行跳转 " << r.branches << " 次，用时 " << fixedPoint(ms, 3) << " ms\n";
+        if (r.limitHit) out << "达到跳转次数上限，已停止\n";
+        if (!r.ok) out << "运行时错误: " << r.error << '\n';
+        for (const auto& kv : r.vars) out << "  " << kv.first << " = " << formatConst(kv.second) << '\n';
+    }
 
-        // 符号栈显示
-        string syStr = ""; 
-        stack<string> tmpSy = symbolStack; 
-        vector<string> vSy;
-        while (!tmpSy.empty()) { 
-            vSy.push_back(tmpSy.top()); 
-            tmpSy.pop(); 
-        }
-        reverse(vSy.begin(), vSy.end());
-        for (auto& x : vSy) {
-            if (syStr.length() > 0) syStr += " ";
-            syStr += x;
-        }
-        // 限制符号栈显示长度
-        if (syStr.length() > 18) {
-            syStr = "..." + syStr.substr(syStr.length() - 15);
+    if (runJIT) {
+        ScopedTimer timer(&stats, "jit");
+        const vector<TAC>& program = optimize ? optimized : result.tac;
+        TACVM vm(program, result.varTypes);
+        TACJit jit(vm);
+        auto begin = chrono::steady_clock::now();
+        VMResult r = jit.run();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+        out << "\n--- 本机代码执行 (x86-64 JIT) ---\n";
+        if (jit.isCompiled()) {
+            out << "字节码 " << vm.numInstructions() << " 条，生成机器码 " << jit.codeBytes()
+                << " 字节（回调虚拟机的指令 " << jit.numFallbacks() << " 条）\n";
+        } else {
+            out << "未能生成本机代码（" << jit.reason() << "），改用虚拟机执行\n";
         }
+        out << "执行跳转 " << r.branches << " 次，用时 " << fixedPoint(ms, 3) << " ms\n";
+        if (r.limitHit) out << "达到跳转次数上限，已停止\n";
+        if (!r.ok) out << "运行时错误: " << r.error << '\n';
+        for (const auto& kv : r.vars) out << "  " << kv.first << " = " << formatConst(kv.second) << '\n';
+    }
 
-        // 查找Action表中的动作
-        if (!actionTable.at(s).count(a)) {
-            // ========== 语法错误处理 ==========
-            hasError = true;
-            string errorMsg;
-            
-            // 收集期望的符号（用于错误提示）
-            // 从当前状态的所有项目中提取期望的符号
-            set<string> expected;
-            for (auto& it : states[s]) {
-                if (it.dotPos < (int)productions[it.prodId].right.size()) {
-                    string nextSym = productions[it.prodId].right[it.dotPos];
-                    if (Vt.count(nextSym)) expected.insert(nextSym);
-                }
-            }
-            // 也检查归约项
-            for (auto& it : states[s]) {
-                if (it.dotPos == (int)productions[it.prodId].right.size() || productions[it.prodId].right.empty()) {
-                    for (auto& la : it.lookahead) {
-                        expected.insert(la);
-                    }
-                }
-            }
-            
-            // 文件结束符特殊处理：如果遇到文件结束符#且仍在代码块内，优先报告缺少}
-            if (a == "#") {
-                // 检查符号栈中是否有未闭合的{
-                // 从栈底到栈顶遍历，统计{和}的匹配情况
-                stack<string> tmpCheck = symbolStack;
-                vector<string> symbols;  // 从栈底到栈顶的符号序列
-                while (!tmpCheck.empty()) {
-                    symbols.push_back(tmpCheck.top());
-                    tmpCheck.pop();
-                }
-                reverse(symbols.begin(), symbols.end());  // 反转得到从栈底到栈顶的顺序
-                
-                // 统计{和}的数量
-                int openBraces = 0;
-                int closeBraces = 0;
-                for (const auto& sym : symbols) {
-                    if (sym == "{") openBraces++;
-                    else if (sym == "}") closeBraces++;
-                }
-                
-                // 如果{的数量大于}的数量，或者期望的符号中包含}，说明缺少右花括号
-                if (openBraces > closeBraces || expected.count("}")) {
-                    errorMsg = "[语法错误] 缺少右花括号'}'";
-                    // 如果位置栈不为空，提示未匹配的{的位置
-                    if (!braceLineStack.empty()) {
-                        int unclosedBraceLine = braceLineStack.top();
-                        errorMsg += "\n提示：从第 " + to_string(unclosedBraceLine) + " 行开始的 '{' 未找到匹配的 '}'";
-                    }
-                    errorMessages.push_back(errorMsg);
-                    cout << "\n" << errorMsg << endl;
-                    cout << left << setw(6) << step << setw(25) << stStr << setw(20) << syStr << setw(12) << a << "错误: 缺少右花括号" << endl;
-                    return;
-                }
-            }
-            
-            // 常规错误处理
-            errorMsg = "[语法错误] 第" + to_string(w.line) + "行, 第" + to_string(w.col) + "列: ";
-            errorMsg += "遇到意外的符号 '" + a + "'";
-            
-            // 尝试诊断常见错误模式
-            string diagnosis = diagnoseSyntaxError(a, expected, symbolStack, tokens, ptr);
-            if (!diagnosis.empty()) {
-                errorMsg += "\n诊断: " + diagnosis;
+    // 输出其他后端的目标代码（与 -O 同用时翻译优化后的代码）
+    if (!emitTarget.empty()) {
+        ScopedTimer timer(&stats, "emit");
+        const vector<TAC>& program = optimize ? optimized : result.tac;
+        string text, title;
+        if (emitTarget == "c") {
+            text = emitCSource(program, result.varTypes);
+            title = "C 源码";
+        } else if (emitTarget == "asm" || emitTarget == "asm-stack") {
+            string error;
+            text = emitAsmSource(program, result.varTypes, emitTarget == "asm", true, error);
+            title = "汇编代码";
+            if (!error.empty()) {
+                out << "\n无法生成汇编代码: " << error << '\n';
+                return;
             }
-            
-            // 如果期望的符号中包含}，且位置栈不为空，提示未匹配的 { 的位置
-            if (expected.count("}") && !braceLineStack.empty()) {
-                int unclosedBraceLine = braceLineStack.top();
-                errorMsg += "\n提示：从第 " + to_string(unclosedBraceLine) + " 行开始的 '{' 未找到匹配的 '}'";
+        } else if (emitTarget == "ir") {
+            string error;
+            if (!writeIR(program, result.varTypes, text, error)) {
+                out << "\n无法生成二进制三地址码: " << error << '\n';
+                return;
             }
-            
-            // 格式化期望符号列表（分组显示）
-            if (!expected.empty()) {
-                // 分组：关键字、运算符、分隔符、其他
-                vector<string> keywords, operators, separators, others;
-                set<string> kwSet = {"while", "break", "continue", "int", "float", "true", "false"};
-                set<string> opSet = {"+", "-", "*", "/", "++", "--", "&&", "||", "!", 
-                                    ">", "<", "==", ">=", "<=", "!=", "="};
-                set<string> sepSet = {"(", ")", "{", "}", ";", ","};
-                
-                for (const auto& exp : expected) {
-                    if (kwSet.count(exp)) keywords.push_back(exp);
-                    else if (opSet.count(exp)) operators.push_back(exp);
-                    else if (sepSet.count(exp)) separators.push_back(exp);
-                    else others.push_back(exp);
-                }
-                
-                errorMsg += "\n期望的符号: ";
-                bool hasContent = false;
-                
-                if (!keywords.empty()) {
-                    errorMsg += "关键字(";
-                    for (size_t i = 0; i < keywords.size(); i++) {
-                        if (i > 0) errorMsg += ", ";
-                        errorMsg += "'" + keywords[i] + "'";
-                    }
-                    errorMsg += ")";
-                    hasContent = true;
-                }
-                
-                if (!operators.empty()) {
-                    if (hasContent) errorMsg += ", ";
-                    errorMsg += "运算符(";
-                    for (size_t i = 0; i < operators.size(); i++) {
-                        if (i > 0) errorMsg += ", ";
-                        errorMsg += "'" + operators[i] + "'";
-                    }
-                    errorMsg += ")";
-                    hasContent = true;
-                }
-                
-                if (!separators.empty()) {
-                    if (hasContent) errorMsg += ", ";
-                    errorMsg += "分隔符(";
-                    for (size_t i = 0; i < separators.size(); i++) {
-                        if (i > 0) errorMsg += ", ";
-                        errorMsg += "'" + separators[i] + "'";
-                    }
-                    errorMsg += ")";
-                    hasContent = true;
-                }
-                
-                if (!others.empty()) {
-                    if (hasContent) errorMsg += ", ";
-                    for (size_t i = 0; i < others.size(); i++) {
-                        if (i > 0) errorMsg += ", ";
-                        errorMsg += "'" + others[i] + "'";
-                    }
+            title = "二进制三地址码";
+            // 读回并与内存中的三地址码逐条比较
+            IRView view(text.data(), text.size());
+            vector<TAC> back;
+            map<string, string> backTypes;
+            bool same = view.validate(error);
+            if (same) {
+                view.toTAC(back, backTypes);
+                same = back.size() == program.size() && backTypes == result.varTypes;
+                for (size_t i = 0; same && i < back.size(); i++) {
+                    const TAC& x = back[i];
+                    const TAC& y = program[i];
+                    same = x.op == y.op && x.arg1 == y.arg1 && x.arg2 == y.arg2 && x.result == y.result && x.addr == y.addr;
                 }
             }
-            
-            errorMessages.push_back(errorMsg);
-            cout << "\n" << errorMsg << endl;
-            cout << left << setw(6) << step << setw(25) << stStr << setw(20) << syStr << setw(12) << a << "错误: 语法不匹配" << endl;
+            out << "\n--- " << title << " ---\n";
+            out << text.size() << " 字节: 字符串 " << view.numStrings() << " 个，指令 " << view.numInstructions()
+                << " 条，变量类型 " << view.numVars() << " 个\n";
+            out << "往返校验: " << (same ? "一致" : "不一致！" + error) << '\n';
+        } else {
+            out << "\n未知的输出格式: " << emitTarget << '\n';
             return;
         }
-        // 获取动作
-        Action act = actionTable.at(s).at(a);
-
-        // ========== 移进动作 ==========
-        if (act.type == ActionType::SHIFT) {
-            // 如果遇到while关键字，进入循环处理
-            if (a == "while") {
-                codegen.enterLoop();  // 记录循环开始地址，初始化break/continue列表
-            }
-            // 跟踪代码块位置：遇到{时记录行号
-            if (a == "{") {
-                braceLineStack.push(w.line);
-            }
-            // 遇到}时弹出对应的{
-            else if (a == "}") {
-                if (!braceLineStack.empty()) {
-                    braceLineStack.pop();
-                }
-            }
-            // 输出分析步骤
-            cout << left << setw(6) << step++ << setw(25) << stStr << setw(20) << syStr << setw(12) << a << setw(15) << "移进 S" + to_string(act.target) << endl;
-            // 执行移进：将新状态和符号压入栈
-            stateStack.push(act.target);
-            symbolStack.push(a);
-            semStack.push_back({ w.token });  // 保存Token的原始值（用于代码生成）
-            ptr++;  // 移动输入指针
-        }
-        // ========== 归约动作 ==========
-        else if (act.type == ActionType::REDUCE) {
-            // 获取产生式
-            Production p = productions[act.target];
-            
-            // 从栈中弹出产生式右部长度的元素
-            vector<SemItem> popped;
-            for (int k = 0; k < (int)p.right.size(); k++) {
-                stateStack.pop();  // 弹出状态
-                symbolStack.pop();  // 弹出符号
-                popped.push_back(semStack.back());  // 保存语义信息
-                semStack.pop_back();
-            }
-            reverse(popped.begin(), popped.end());  // 反转顺序（栈是后进先出）
-            
-            // 执行语义动作：生成代码
-            SemItem res = codegen.handleProduction(act.target, popped, semStack);
-
-            cout << left << setw(6) << step++ << setw(25) << stStr << setw(20) << syStr << setw(12) << a << setw(15) << "归约 r" + to_string(act.target) << codegen.getCurrentStepQuads() << endl;
-
-            symbolStack.push(p.left);
-            stateStack.push(gotoTable.at(stateStack.top()).at(p.left));
-            semStack.push_back(res);
-        }
-        else if (act.type == ActionType::ACCEPT) {
-            cout << left << setw(6) << step++ << setw(25) << stStr << setw(20) << syStr << setw(12) << a << setw(15) << "ACCEPT" << endl;
-            break;
-        }
-    }
-
-    cout << string(100, '-') << endl;
-    
-    if (hasError) {
-        cout << "\n--- 错误汇总 ---" << endl;
-        for (auto& err : errorMessages) {
-            cout << err << endl;
+        if (emitPath.empty()) {
+            if (emitTarget != "ir") out << "\n--- " << title << " ---\n" << text;     // 二进制格式不输出到控制台
+        } else {
+            ofstream file(emitPath, ios::binary);
+            file << text;
+            if (file) out << "\n" << title << "已写入: " << emitPath << '\n';
+            else out << "\n错误: 无法写入 '" << emitPath << "'\n";
         }
-        return;
     }
-    
-    // 打印生成的三地址码
-    codegen.printTAC();
 }
 
 
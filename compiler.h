@@ -1,33 +1,71 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
-#include "lexer.h"
-#include "parser.h"
+#include "compile.h"
+#include "compilecache.h"
 #include "codegen.h"
+#include "outsink.h"
+#include "stats.h"
 #include <string>
 #include <vector>
-#include <stack>
 
 // === 编译器主类 ===
+// 命令行使用：通过 compile() 编译（记录 token 与分析过程），再把结果和各项分析、执行、
+// 目标代码输出格式化写入 OutputSink
 
 class WhileCompiler {
 private:
-    Lexer lexer;
+    Stats stats;            // 各阶段计时与计数（先于 parser 构造，记录分析表的构造过程）
     Parser parser;
-    CodeGenerator codegen;
+    CompileResult result;   // 最近一次编译的结果
+    OutputSink* output = &OutputSink::console();   // 各阶段输出写入的目标
     
     // 错误处理
-    bool hasError = false;
     vector<string> errorMessages;
 
+    // 编译选项
+    bool optimize = false;  // 是否在代码生成后运行 TAC 优化器
+    bool countExec = false; // 是否用参考求值器统计执行指令数
+    bool profileExec = false;   // 是否剖析执行，按源位置报告热点
+    bool showCFG = false;   // 是否输出控制流图、循环与数据流分析结果
+    bool showSSA = false;   // 是否输出 SSA 形式及 SSA 上的优化结果
+    bool runVM = false;     // 是否在字节码虚拟机上执行生成的代码
+    bool runJIT = false;    // 是否编译为 x86-64 本机代码执行
+    bool pipeline = false;  // 是否用流水线编译（不输出语法分析过程）
+    bool peephole = true;   // 是否在生成三地址码后运行窥孔优化
+    CompileCache* cache = nullptr;  // 编译缓存，为空时不使用（使用时不输出词法与语法分析过程）
+    string emitTarget;      // 额外输出的目标代码格式（"c"、"asm"、"asm-stack"、"ir"），空表示不输出
+    string emitPath;        // 目标代码写入的文件，空表示输出到控制台
+
+    void runStages(const string& input, OutputSink& out);
+
 public:
     WhileCompiler();
     
-    // 运行编译器
+    // 运行编译器，结束时把输出全部刷新到目标
     void run(const string& input);
+    void setOutput(OutputSink& sink);
+    
+    // 编译选项
+    void setOptimize(bool on) { optimize = on; }
+    void setCountExecution(bool on) { countExec = on; }
+    void setProfile(bool on) { profileExec = on; }
+    void setShowCFG(bool on) { showCFG = on; }
+    void setShowSSA(bool on) { showSSA = on; }
+    void setRunVM(bool on) { runVM = on; }
+    void setRunJIT(bool on) { runJIT = on; }
+    void setPipeline(bool on) { pipeline = on; }
+    void setPeephole(bool on) { peephole = on; }
+    void setCache(CompileCache* c) { cache = c; }
+    void setEmit(const string& target, const string& path) { emitTarget = target; emitPath = path; }
+    
+    // 最近一次编译的结果（基准程序直接取三地址码）
+    const CompileResult& getResult() const { return result; }
+    // 计时与计数（--stats / --trace-out 输出）
+    const Stats& getStats() const { return stats; }
     
     // 错误处理
-    bool hasErrors() const { return hasError || lexer.hasErrors(); }
+    bool hasErrors() const { return result.hasErrors(); }
     const vector<string>& getErrorMessages() const { return errorMessages; }
 };
 
@@ -0,0 +1,251 @@
+#include "dataflow.h"
+#include "tacutil.h"
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+// ============================================================================
+// BitVector
+// ============================================================================
+
+BitVector::BitVector(int n, bool value) : words((n + 63) / 64, value ? ~(uint64_t)0 : 0), nbits(n) {
+    // 全 1 时清掉最后一个字中超出 n 的位，保证相等比较只看有效位
+    if (value && (n & 63)) words.back() &= ((uint64_t)1 << (n & 63)) - 1;
+}
+
+int BitVector::count() const {
+    int c = 0;
+    for (uint64_t w : words) c += __builtin_popcountll(w);
+    return c;
+}
+
+int BitVector::findNext(int from) const {
+    if (from >= nbits) return -1;
+    size_t k = from >> 6;
+    uint64_t w = words[k] & (~(uint64_t)0 << (from & 63));
+    while (true) {
+        if (w) return (int)(k * 64 + __builtin_ctzll(w));
+        if (++k >= words.size()) return -1;
+        w = words[k];
+    }
+}
+
+bool BitVector::unionWith(const BitVector& o) {
+    bool changed = false;
+    for (size_t k = 0; k < words.size(); k++) {
+        uint64_t v = words[k] | o.words[k];
+        if (v != words[k]) { words[k] = v; changed = true; }
+    }
+    return changed;
+}
+
+bool BitVector::intersectWith(const BitVector& o) {
+    bool changed = false;
+    for (size_t k = 0; k < words.size(); k++) {
+        uint64_t v = words[k] & o.words[k];
+        if (v != words[k]) { words[k] = v; changed = true; }
+    }
+    return changed;
+}
+
+void BitVector::subtract(const BitVector& o) {
+    for (size_t k = 0; k < words.size(); k++) words[k] &= ~o.words[k];
+}
+
+// ============================================================================
+// 通用求解器
+// ============================================================================
+
+// 工作表按处理顺序中的位置排序：前向问题用逆后序，后向问题用其逆序，
+// 使大多数块在处理时其前驱（后继）已经是最新值，迭代次数接近循环嵌套深度。
+DataflowResult solveDataflow(const CFG& cfg, const DataflowProblem& p) {
+    int nb = cfg.size();
+    bool forward = (p.dir == DataflowProblem::FORWARD);
+    bool useUnion = (p.meet == DataflowProblem::UNION);
+
+    // 处理顺序：可达块的逆后序，再补上不可达块（后向问题中它们仍可能有活跃信息）
+    vector<int> order = cfg.reversePostorder();
+    for (int b = 0; b < nb; b++) if (!cfg.reachable(b)) order.push_back(b);
+    if (!forward) reverse(order.begin(), order.end());
+    vector<int> position(nb);
+    for (int k = 0; k < nb; k++) position[order[k]] = k;
+
+    DataflowResult r;
+    BitVector init(p.numBits, !useUnion);
+    r.in.assign(nb, init);
+    r.out.assign(nb, init);
+    int boundaryBlock = forward ? cfg.entry() : cfg.exit();
+
+    // 工作表按位置轮转扫描：一次扫描中只向后推进，加入到当前位置之前的块
+    // （例如循环头）留到下一轮扫描，避免每条回边都把整个循环体重跑一遍
+    set<int> work;
+    for (int k = 0; k < nb; k++) work.insert(k);
+    const vector<BasicBlock>& blocks = cfg.getBlocks();
+    int cursor = 0;
+
+    while (!work.empty()) {
+        auto it = work.lower_bound(cursor);
+        if (it == work.end()) it = work.begin();
+        cursor = *it;
+        int b = order[cursor];
+        work.erase(it);
+        r.iterations++;
+
+        // 汇合：前向取前驱的 out，后向取后继的 in；边界块额外汇入边界值
+        const vector<int>& sources = forward ? blocks[b].pred : blocks[b].succ;
+        BitVector meetVal(p.numBits, !useUnion);
+        bool any = false;
+        if (b == boundaryBlock) { meetVal = p.boundary; any = true; }
+        for (int s : sources) {
+            const BitVector& v = forward ? r.out[s] : r.in[s];
+            if (!any) { meetVal = v; any = true; }
+            else if (useUnion) meetVal.unionWith(v);
+            else meetVal.intersectWith(v);
+        }
+        if (!any) meetVal = BitVector(p.numBits, false);
+
+        BitVector transferred = meetVal;
+        transferred.subtract(p.kill[b]);
+        transferred.unionWith(p.gen[b]);
+
+        BitVector& before = forward ? r.in[b] : r.out[b];
+        BitVector& after = forward ? r.out[b] : r.in[b];
+        before = meetVal;
+        if (transferred != after) {
+            after = transferred;
+            const vector<int>& deps = forward ? blocks[b].succ : blocks[b].pred;
+            for (int d : deps) work.insert(position[d]);
+        }
+    }
+    return r;
+}
+
+// ============================================================================
+// 到达定值
+// ============================================================================
+
+ReachingDefinitions::ReachingDefinitions(const CFG& cfg) : cfg(cfg) {
+    const vector<TAC>& code = cfg.getCode();
+    for (int i = 0; i < (int)code.size(); i++) {
+        string d = defOf(code[i]);
+        if (d.empty()) continue;
+        bitOfAddr[i] = (int)defSites.size();
+        defsOfName[d].push_back((int)defSites.size());
+        defSites.push_back(i);
+    }
+
+    int n = (int)defSites.size();
+    DataflowProblem p;
+    p.dir = DataflowProblem::FORWARD;
+    p.meet = DataflowProblem::UNION;
+    p.numBits = n;
+    p.boundary = BitVector(n);
+    // 每个名称的全部定值组成一个掩码，块的 kill 是块内定值名称的掩码之并
+    map<string, BitVector> defMask;
+    for (const auto& kv : defsOfName) {
+        BitVector m(n);
+        for (int bit : kv.second) m.set(bit);
+        defMask[kv.first] = m;
+    }
+    for (const auto& bb : cfg.getBlocks()) {
+        BitVector gen(n), kill(n);
+        map<string, int> lastDef;  // 同一块内后面的定值覆盖前面的
+        for (int i = bb.start; i < bb.end; i++) {
+            string d = defOf(code[i]);
+            if (!d.empty()) lastDef[d] = i;
+        }
+        for (const auto& kv : lastDef) {
+            kill.unionWith(defMask[kv.first]);
+            gen.set(bitOfAddr[kv.second]);
+        }
+        kill.subtract(gen);
+        p.gen.push_back(gen);
+        p.kill.push_back(kill);
+    }
+    result = solveDataflow(cfg, p);
+}
+
+vector<int> ReachingDefinitions::reachingDefs(int addr, const string& name) const {
+    const vector<TAC>& code = cfg.getCode();
+    int b = cfg.blockOf(addr);
+    BitVector cur = result.in[b];
+    for (int i = cfg.getBlocks()[b].start; i < addr; i++) {
+        string d = defOf(code[i]);
+        if (d.empty()) continue;
+        for (int bit : defsOfName.at(d)) cur.reset(bit);
+        cur.set(bitOfAddr.at(i));
+    }
+    vector<int> res;
+    auto it = defsOfName.find(name);
+    if (it == defsOfName.end()) return res;
+    for (int bit : it->second) if (cur.test(bit)) res.push_back(defSites[bit]);
+    return res;
+}
+
+// ============================================================================
+// 活跃变量
+// ============================================================================
+
+LivenessAnalysis::LivenessAnalysis(const CFG& cfg) : cfg(cfg) {
+    const vector<TAC>& code = cfg.getCode();
+    auto addName = [&](const string& name) {
+        auto it = bitOfName.find(name);
+        if (it != bitOfName.end()) return it->second;
+        names.push_back(name);
+        return bitOfName[name] = (int)names.size() - 1;
+    };
+    for (const auto& t : code) {
+        string d = defOf(t);
+        if (!d.empty()) addName(d);
+        for (const auto& u : usesOf(t)) addName(u);
+    }
+
+    int n = (int)names.size();
+    DataflowProblem p;
+    p.dir = DataflowProblem::BACKWARD;
+    p.meet = DataflowProblem::UNION;
+    p.numBits = n;
+    p.boundary = BitVector(n);
+    for (int k = 0; k < n; k++) if (isUserVar(names[k])) p.boundary.set(k);
+
+    for (const auto& bb : cfg.getBlocks()) {
+        BitVector use(n), def(n);
+        for (int i = bb.start; i < bb.end; i++) {
+            for (const auto& u : usesOf(code[i])) {
+                int bit = bitOfName[u];
+                if (!def.test(bit)) use.set(bit);  // 块内先引用后定值
+            }
+            string d = defOf(code[i]);
+            if (!d.empty()) def.set(bitOfName[d]);
+        }
+        p.gen.push_back(use);
+        p.kill.push_back(def);
+    }
+    result = solveDataflow(cfg, p);
+}
+
+vector<BitVector> LivenessAnalysis::liveOutPerInstruction() const {
+    const vector<TAC>& code = cfg.getCode();
+    vector<BitVector> res(code.size());
+    for (const auto& bb : cfg.getBlocks()) {
+        BitVector live = result.out[bb.id];
+        for (int i = bb.end - 1; i >= bb.start; i--) {
+            res[i] = live;
+            string d = defOf(code[i]);
+            if (!d.empty()) live.reset(bitOfName.at(d));
+            for (const auto& u : usesOf(code[i])) live.set(bitOfName.at(u));
+        }
+    }
+    return res;
+}
+
+bool LivenessAnalysis::liveAtBlockEntry(int block, const string& name) const {
+    auto it = bitOfName.find(name);
+    return it != bitOfName.end() && result.in[block].test(it->second);
+}
+
+int LivenessAnalysis::bitOf(const string& name) const {
+    auto it = bitOfName.find(name);
+    return it == bitOfName.end() ? -1 : it->second;
+}
@@ -0,0 +1,108 @@
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include "cfg.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+
+// === 位向量数据流分析框架 ===
+// 以基本块为单位的 gen/kill 问题，工作表按逆后序（后向问题按其逆序）处理
+
+// ----------------------------------------------------------------------------
+// 位向量 (BitVector)
+// ----------------------------------------------------------------------------
+class BitVector {
+private:
+    vector<uint64_t> words;
+    int nbits = 0;
+
+public:
+    BitVector() {}
+    explicit BitVector(int n, bool value = false);
+
+    int size() const { return nbits; }
+    bool test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void set(int i) { words[i >> 6] |= (uint64_t)1 << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+    int count() const;
+    int findNext(int from) const;  // 从 from 开始的第一个置位的位号，没有则为 -1
+
+    // 集合运算，返回自身是否发生变化
+    bool unionWith(const BitVector& o);
+    bool intersectWith(const BitVector& o);
+    void subtract(const BitVector& o);
+
+    bool operator==(const BitVector& o) const { return words == o.words; }
+    bool operator!=(const BitVector& o) const { return words != o.words; }
+};
+
+// ----------------------------------------------------------------------------
+// 数据流问题 (DataflowProblem)
+// ----------------------------------------------------------------------------
+// 传递函数 f(x) = gen ∪ (x - kill)；前向问题中 boundary 是入口块的 in，
+// 后向问题中 boundary 是出口块的 out
+struct DataflowProblem {
+    enum Direction { FORWARD, BACKWARD };
+    enum Meet { UNION, INTERSECT };
+
+    Direction dir = FORWARD;
+    Meet meet = UNION;
+    int numBits = 0;
+    vector<BitVector> gen, kill;    // 每个基本块一项
+    BitVector boundary;
+};
+
+struct DataflowResult {
+    vector<BitVector> in, out;      // 每个基本块入口/出口处的值
+    int iterations = 0;             // 处理的工作表项数
+};
+
+DataflowResult solveDataflow(const CFG& cfg, const DataflowProblem& problem);
+
+// ----------------------------------------------------------------------------
+// 到达定值 (ReachingDefinitions)
+// ----------------------------------------------------------------------------
+class ReachingDefinitions {
+private:
+    const CFG& cfg;
+    vector<int> defSites;           // 位号 -> 定值指令地址
+    map<int, int> bitOfAddr;        // 定值指令地址 -> 位号
+    map<string, vector<int>> defsOfName;  // 名称 -> 它的全部定值位号
+    DataflowResult result;
+
+public:
+    explicit ReachingDefinitions(const CFG& cfg);
+
+    // 到达指令 addr 入口处的、对 name 的定值地址
+    vector<int> reachingDefs(int addr, const string& name) const;
+    int numDefinitions() const { return (int)defSites.size(); }
+    const DataflowResult& getResult() const { return result; }
+};
+
+// ----------------------------------------------------------------------------
+// 活跃变量 (LivenessAnalysis)
+// ----------------------------------------------------------------------------
+// 程序出口处所有用户变量视为活跃（结束时的变量状态就是程序的结果），
+// 临时变量与 SSA 版本名不视为活跃
+class LivenessAnalysis {
+private:
+    const CFG& cfg;
+    vector<string> names;           // 位号 -> 名称
+    map<string, int> bitOfName;
+    DataflowResult result;
+
+public:
+    explicit LivenessAnalysis(const CFG& cfg);
+
+    // 每条指令出口处的活跃集合（位号见 bitOf / nameOf）
+    vector<BitVector> liveOutPerInstruction() const;
+    bool liveAtBlockEntry(int block, const string& name) const;
+    int bitOf(const string& name) const;    // 不存在返回 -1
+    const string& nameOf(int bit) const { return names[bit]; }
+    int numNames() const { return (int)names.size(); }
+    const DataflowResult& getResult() const { return result; }
+};
+
+#endif // DATAFLOW_H
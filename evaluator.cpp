@@ -0,0 +1,58 @@
+#include "evaluator.h"
+
+using namespace std;
+
+TACEvaluator::TACEvaluator(const map<string, string>& varTypes, long long stepLimit)
+    : varTypes(varTypes), stepLimit(stepLimit) {
+}
+
+EvalResult TACEvaluator::run(const vector<TAC>& code, EvalObserver* observer) const {
+    EvalResult res;
+    map<string, ConstVal> env;
+
+    // 读取操作数：常量直接解析，未赋值的名称按声明类型读作 0
+    auto value = [&](const string& name) {
+        ConstVal v;
+        if (parseConst(name, v)) return v;
+        auto it = env.find(name);
+        if (it != env.end()) return it->second;
+        auto ty = varTypes.find(name);
+        v.isFloat = (ty != varTypes.end() && ty->second == "float");
+        return v;
+    };
+
+    int pc = 0, n = (int)code.size();
+    while (pc >= 0 && pc < n) {
+        if (res.steps >= stepLimit) { res.limitHit = true; break; }
+        res.steps++;
+        if (observer) observer->step(pc);
+        const TAC& t = code[pc];
+        if (isJumpOp(t.op)) res.branches++;
+
+        if (t.op == "goto") { pc = labelAddr(t.result); continue; }
+        if (isCondJumpOp(t.op)) {
+            bool zero = value(t.arg1).isZero();
+            pc = ((t.op == "jz") == zero) ? labelAddr(t.result) : pc + 1;
+            continue;
+        }
+
+        ConstVal r;
+        bool ok = t.arg2.empty() ? foldUnary(t.op, value(t.arg1), r)
+                                 : foldBinary(t.op, value(t.arg1), value(t.arg2), r);
+        if (!ok) {
+            res.ok = false;
+            res.error = "第 " + to_string(pc) + " 条指令 '" + t.op + "' 无法求值（除零或结果溢出）";
+            break;
+        }
+        // 赋给声明过的变量时按其类型转换
+        auto ty = varTypes.find(t.result);
+        if (ty != varTypes.end()) r = convertConst(r, ty->second == "float");
+        env[t.result] = r;
+        pc++;
+    }
+
+    for (const auto& kv : env) {
+        if (!isTempName(kv.first)) res.vars[kv.first] = kv.second;
+    }
+    return res;
+}
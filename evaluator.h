@@ -0,0 +1,42 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "types.h"
+#include "tacutil.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === 三地址码参考求值器 ===
+// 逐条解释执行 TAC，用于统计执行指令数和核对各优化遍/后端的结果
+// 语义：声明为 int/float 的变量赋值时按类型转换，未初始化的变量读作 0
+
+// 求值结果
+struct EvalResult {
+    bool ok = true;                 // 是否正常结束
+    bool limitHit = false;          // 是否因步数上限而停止（例如 while(true)）
+    string error;                   // 运行时错误信息（如整数除零）
+    long long steps = 0;            // 已执行的指令条数
+    long long branches = 0;         // 已执行的跳转指令条数（goto/jz/jnz）
+    map<string, ConstVal> vars;     // 结束时的用户变量（不含临时变量）
+};
+
+// 执行观察者：求值器执行每条指令之前调用 step（性能剖析用），不改变执行结果
+class EvalObserver {
+public:
+    virtual ~EvalObserver() {}
+    virtual void step(int pc) = 0;
+};
+
+class TACEvaluator {
+private:
+    map<string, string> varTypes;   // 显式声明的变量类型
+    long long stepLimit;            // 执行步数上限
+
+public:
+    TACEvaluator(const map<string, string>& varTypes, long long stepLimit = 10000000);
+
+    EvalResult run(const vector<TAC>& code, EvalObserver* observer = nullptr) const;
+};
+
+#endif // EVALUATOR_H
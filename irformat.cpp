@@ -0,0 +1,392 @@
+#include "irformat.h"
+#include "tacutil.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#define IR_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char* const opNames[IR_NUM_OPS] = {
+    "+", "-", "*", "/",
+    "<", "<=", ">", ">=", "==", "!=",
+    "&&", "||", "!", "neg",
+    ":=", "goto", "jz", "jnz", "decl",
+    "+.", "-.", "*.", "/.",
+    "<.", "<=.", ">.", ">=.", "==.", "!=.",
+    "neg.", "itof", "ftoi"
+};
+
+IROp irOpOf(const string& op) {
+    for (int k = 0; k < IR_NUM_OPS; k++) if (op == opNames[k]) return (IROp)k;
+    return IR_NUM_OPS;
+}
+
+const char* irOpName(IROp op) {
+    return op < IR_NUM_OPS ? opNames[op] : "?";
+}
+
+static uint32_t fnv1a(const uint8_t* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+// 标号只出现在跳转指令的 result 上（变量也可能叫 L3）
+static IROperandKind kindOf(const string& name, bool isTarget, uint32_t& value) {
+    value = 0;
+    if (name.empty()) return IR_NONE;
+    if (isTarget) return IR_LABEL;
+    if (isTempName(name)) return IR_TEMP;
+    if (!isConstName(name)) return IR_VAR;
+    ConstVal c;
+    if (!parseConst(name, c)) return IR_LITERAL;
+    if (c.isFloat) {
+        memcpy(&value, &c.f, 4);
+        return IR_FLOAT;
+    }
+    value = (uint32_t)c.i;
+    return IR_INT;
+}
+
+// ============================================================================
+// 写出
+// ============================================================================
+
+namespace {
+
+// 按小端序写入预先分配好大小的缓冲区
+class ByteWriter {
+private:
+    string& bytes;
+
+public:
+    explicit ByteWriter(string& bytes) : bytes(bytes) {}
+    void put8(size_t at, uint8_t v) { bytes[at] = (char)v; }
+    void put16(size_t at, uint16_t v) {
+        put8(at, (uint8_t)v);
+        put8(at + 1, (uint8_t)(v >> 8));
+    }
+    void put32(size_t at, uint32_t v) {
+        for (int k = 0; k < 4; k++) put8(at + k, (uint8_t)(v >> (8 * k)));
+    }
+};
+
+} // namespace
+
+bool writeIR(const vector<TAC>& code, const map<string, string>& varTypes, string& bytes, string& error) {
+    // 字符串表：句柄 0 为空串，其余按首次出现的顺序编号；每个操作数的句柄记下来供编码指令时使用
+    vector<string> strings = { "" };
+    unordered_map<string, uint32_t> handles = { { "", 0 } };
+    vector<uint32_t> operandHandles;
+    operandHandles.reserve(3 * code.size());
+    auto intern = [&](const string& s) {
+        auto it = handles.find(s);
+        if (it != handles.end()) return it->second;
+        uint32_t h = (uint32_t)strings.size();
+        strings.push_back(s);
+        handles[s] = h;
+        return h;
+    };
+    for (size_t i = 0; i < code.size(); i++) {
+        const TAC& t = code[i];
+        if (t.addr != (int)i) {
+            error = "第 " + to_string(i) + " 条指令的地址为 " + to_string(t.addr) + "，与下标不一致";
+            return false;
+        }
+        if (irOpOf(t.op) == IR_NUM_OPS) {
+            error = "第 " + to_string(i) + " 条指令的操作符 '" + t.op + "' 无法编码";
+            return false;
+        }
+        operandHandles.push_back(intern(t.arg1));
+        operandHandles.push_back(intern(t.arg2));
+        operandHandles.push_back(intern(t.result));
+    }
+    for (const auto& kv : varTypes) intern(kv.first);
+
+    IRHeader h;
+    memset(&h, 0, sizeof h);
+    size_t dataSize = 0;
+    for (const auto& s : strings) dataSize += s.size() + 1;
+    h.stringCount = (uint32_t)strings.size();
+    h.stringIndexOffset = sizeof(IRHeader);
+    h.stringDataOffset = (uint32_t)align8(h.stringIndexOffset + 4 * (strings.size() + 1));
+    h.instrCount = (uint32_t)code.size();
+    h.instrOffset = (uint32_t)align8(h.stringDataOffset + dataSize);
+    h.varCount = (uint32_t)varTypes.size();
+    h.varOffset = (uint32_t)(h.instrOffset + sizeof(IRInstr) * code.size());
+    size_t fileSize = h.varOffset + sizeof(IRVarEntry) * varTypes.size();
+    if (fileSize > 0xffffffffu) {
+        error = "程序过大，超出 4GB 的文件大小上限";
+        return false;
+    }
+    h.fileSize = (uint32_t)fileSize;
+
+    bytes.assign(fileSize, '\0');
+    ByteWriter w(bytes);
+
+    size_t offset = 0;
+    for (size_t k = 0; k < strings.size(); k++) {
+        w.put32(h.stringIndexOffset + 4 * k, (uint32_t)offset);
+        memcpy(&bytes[h.stringDataOffset + offset], strings[k].data(), strings[k].size());
+        offset += strings[k].size() + 1;
+    }
+    w.put32(h.stringIndexOffset + 4 * strings.size(), (uint32_t)offset);
+
+    // 普通操作数的种类与常量值只取决于字符串，每个字符串只解析一次
+    vector<uint8_t> kindOfString(strings.size(), IR_NUM_KINDS);
+    vector<uint32_t> valueOfString(strings.size(), 0);
+    for (size_t i = 0; i < code.size(); i++) {
+        const TAC& t = code[i];
+        size_t at = h.instrOffset + sizeof(IRInstr) * i;
+        const string* operands[3] = { &t.arg1, &t.arg2, &t.result };
+        IROp op = irOpOf(t.op);
+        bool jump = op == IR_GOTO || op == IR_JZ || op == IR_JNZ;
+        w.put8(at, op);
+        for (int k = 0; k < 3; k++) {
+            uint32_t handle = operandHandles[3 * i + k];
+            uint32_t value;
+            IROperandKind kind;
+            if (k == 2 && jump) {
+                kind = kindOf(*operands[k], true, value);
+            } else {
+                if (kindOfString[handle] == IR_NUM_KINDS) {
+                    kindOfString[handle] = (uint8_t)kindOf(*operands[k], false, valueOfString[handle]);
+                }
+                kind = (IROperandKind)kindOfString[handle];
+                value = valueOfString[handle];
+            }
+            w.put8(at + 1 + k, kind);
+            w.put32(at + 4 + 4 * k, handle);
+            w.put32(at + 16 + 4 * k, value);
+        }
+        w.put32(at + 28, (uint32_t)(jump ? labelAddr(t.result) : -1));
+    }
+
+    size_t k = 0;
+    for (const auto& kv : varTypes) {
+        size_t at = h.varOffset + sizeof(IRVarEntry) * k++;
+        w.put32(at, handles[kv.first]);
+        w.put8(at + 4, kv.second == "float" ? 1 : 0);
+    }
+
+    h.checksum = fnv1a((const uint8_t*)bytes.data() + sizeof(IRHeader), fileSize - sizeof(IRHeader));
+    memcpy(&bytes[0], "WTAC", 4);
+    w.put16(4, IR_VERSION);
+    w.put16(6, sizeof(IRHeader));
+    const uint32_t fields[] = { h.fileSize, h.checksum, h.stringCount, h.stringIndexOffset, h.stringDataOffset,
+                                h.instrCount, h.instrOffset, h.varCount, h.varOffset, 0 };
+    for (size_t f = 0; f < sizeof fields / sizeof fields[0]; f++) w.put32(8 + 4 * f, fields[f]);
+    return true;
+}
+
+// ============================================================================
+// 读取与校验
+// ============================================================================
+
+IRView::IRView(const void* data, size_t size) : data((const uint8_t*)data), size(size) {
+    memset(&header, 0, sizeof header);
+}
+
+uint32_t IRView::load32(size_t offset) const {
+    return (uint32_t)data[offset] | (uint32_t)data[offset + 1] << 8 |
+           (uint32_t)data[offset + 2] << 16 | (uint32_t)data[offset + 3] << 24;
+}
+
+bool IRView::validate(string& error) {
+    valid = false;
+    if (size < sizeof(IRHeader) || memcmp(data, "WTAC", 4) != 0) {
+        error = "不是二进制三地址码文件（魔数不符）";
+        return false;
+    }
+    memcpy(header.magic, data, 4);
+    header.version = (uint16_t)(data[4] | data[5] << 8);
+    header.headerSize = (uint16_t)(data[6] | data[7] << 8);
+    uint32_t* fields[] = { &header.fileSize, &header.checksum, &header.stringCount, &header.stringIndexOffset,
+                           &header.stringDataOffset, &header.instrCount, &header.instrOffset,
+                           &header.varCount, &header.varOffset, &header.reserved };
+    for (size_t f = 0; f < sizeof fields / sizeof fields[0]; f++) *fields[f] = load32(8 + 4 * f);
+
+    if (header.version != IR_VERSION) {
+        error = "不支持的版本 " + to_string(header.version) + "（当前为 " + to_string(IR_VERSION) + "）";
+        return false;
+    }
+    if (header.headerSize != sizeof(IRHeader) || header.fileSize != size) {
+        error = "文件头记录的大小与实际不符（可能被截断）";
+        return false;
+    }
+    if (fnv1a(data + sizeof(IRHeader), size - sizeof(IRHeader)) != header.checksum) {
+        error = "校验和不符，文件已损坏";
+        return false;
+    }
+
+    // 各段边界（按 64 位计算，避免溢出）
+    uint64_t n = header.stringCount;
+    uint64_t indexEnd = (uint64_t)header.stringIndexOffset + 4 * (n + 1);
+    if (n == 0 || header.stringIndexOffset < sizeof(IRHeader) || header.stringIndexOffset % 4 != 0 ||
+        indexEnd > header.stringDataOffset || header.stringDataOffset > size) {
+        error = "字符串表越界";
+        return false;
+    }
+    uint64_t dataSize = load32(header.stringIndexOffset + 4 * n);
+    if (header.stringDataOffset + dataSize > header.instrOffset ||
+        header.instrOffset % 8 != 0 ||
+        (uint64_t)header.instrOffset + sizeof(IRInstr) * (uint64_t)header.instrCount > header.varOffset ||
+        header.varOffset % 4 != 0 ||
+        (uint64_t)header.varOffset + sizeof(IRVarEntry) * (uint64_t)header.varCount > size) {
+        error = "指令或变量段越界";
+        return false;
+    }
+
+    // 字符串：偏移递增，每个恰好以一个 '\0' 结尾，句柄 0 为空串
+    const uint8_t* chars = data + header.stringDataOffset;
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t begin = load32(header.stringIndexOffset + 4 * k);
+        uint32_t end = load32(header.stringIndexOffset + 4 * (k + 1));
+        if (end <= begin || end > dataSize || chars[end - 1] != 0 ||
+            memchr(chars + begin, 0, end - begin - 1) != nullptr || (k == 0 && end != 1)) {
+            error = "第 " + to_string(k) + " 个字符串格式错误";
+            return false;
+        }
+    }
+    valid = true;
+
+    // 每个字符串作为普通操作数时的种类与常量值只解析一次（同一个变量、常量在各条指令中反复出现）
+    vector<uint8_t> kindOfString(n, IR_NUM_KINDS);
+    vector<uint32_t> valueOfString(n, 0);
+    auto where = [](uint32_t i) { return "第 " + to_string(i) + " 条指令"; };
+    for (uint32_t i = 0; i < header.instrCount; i++) {
+        IRInstr in = instruction(i);
+        if (in.op >= IR_NUM_OPS) {
+            error = where(i) + "的操作码 " + to_string(in.op) + " 无效";
+            break;
+        }
+        bool jump = in.op == IR_GOTO || in.op == IR_JZ || in.op == IR_JNZ;
+        for (int k = 0; k < 3 && error.empty(); k++) {
+            if (in.kind[k] >= IR_NUM_KINDS || in.name[k] >= n || (in.kind[k] == IR_NONE) != (in.name[k] == 0)) {
+                error = where(i) + "的操作数 " + to_string(k) + " 无效";
+                break;
+            }
+            // 种类与常量值必须与原拼写一致
+            uint32_t value;
+            IROperandKind kind;
+            if (k == 2 && jump) {
+                kind = kindOf(str(in.name[k]), true, value);
+            } else {
+                uint32_t h = in.name[k];
+                if (kindOfString[h] == IR_NUM_KINDS) kindOfString[h] = (uint8_t)kindOf(str(h), false, valueOfString[h]);
+                kind = (IROperandKind)kindOfString[h];
+                value = valueOfString[h];
+            }
+            if (kind != in.kind[k] || value != in.value[k]) error = where(i) + "的操作数 " + to_string(k) + " 与其种类或值不符";
+        }
+        if (!error.empty()) break;
+        if (jump ? (in.kind[2] != IR_LABEL || in.target != labelAddr(str(in.name[2]))) : in.target != -1) {
+            error = where(i) + "的跳转目标无效";
+            break;
+        }
+    }
+    for (uint32_t i = 0; i < header.varCount && error.empty(); i++) {
+        IRVarEntry v = var(i);
+        if (v.name == 0 || v.name >= n || v.isFloat > 1) error = "第 " + to_string(i) + " 个变量类型记录无效";
+    }
+    valid = error.empty();
+    return valid;
+}
+
+const char* IRView::str(uint32_t handle) const {
+    return (const char*)data + header.stringDataOffset + load32(header.stringIndexOffset + 4 * handle);
+}
+
+IRInstr IRView::instruction(uint32_t i) const {
+    size_t at = header.instrOffset + sizeof(IRInstr) * i;
+    IRInstr in;
+    in.op = data[at];
+    for (int k = 0; k < 3; k++) {
+        in.kind[k] = data[at + 1 + k];
+        in.name[k] = load32(at + 4 + 4 * k);
+        in.value[k] = load32(at + 16 + 4 * k);
+    }
+    in.target = (int32_t)load32(at + 28);
+    return in;
+}
+
+IRVarEntry IRView::var(uint32_t i) const {
+    size_t at = header.varOffset + sizeof(IRVarEntry) * i;
+    IRVarEntry v;
+    v.name = load32(at);
+    v.isFloat = data[at + 4];
+    memset(v.reserved, 0, sizeof v.reserved);
+    return v;
+}
+
+void IRView::toTAC(vector<TAC>& code, map<string, string>& varTypes) const {
+    code.clear();
+    varTypes.clear();
+    if (!valid) return;
+    code.reserve(header.instrCount);
+    for (uint32_t i = 0; i < header.instrCount; i++) {
+        IRInstr in = instruction(i);
+        code.push_back({ irOpName((IROp)in.op), str(in.name[0]), str(in.name[1]), str(in.name[2]), (int)i });
+    }
+    for (uint32_t i = 0; i < header.varCount; i++) {
+        IRVarEntry v = var(i);
+        varTypes[str(v.name)] = v.isFloat ? "float" : "int";
+    }
+}
+
+bool readIRFile(const string& path, vector<TAC>& code, map<string, string>& varTypes, string& error) {
+#ifdef IR_NO_MMAP
+    ifstream in(path, ios::binary);
+    if (!in) {
+        error = "无法打开 '" + path + "'";
+        return false;
+    }
+    stringstream ss;
+    ss << in.rdbuf();
+    string bytes = ss.str();
+    IRView view(bytes.data(), bytes.size());
+    if (!view.validate(error)) return false;
+    view.toTAC(code, varTypes);
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        error = "无法打开 '" + path + "'";
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        error = "不是二进制三地址码文件（文件为空）";
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "无法映射 '" + path + "'";
+        return false;
+    }
+    IRView view(mapped, size);
+    bool ok = view.validate(error);
+    if (ok) view.toTAC(code, varTypes);
+    munmap(mapped, size);
+    return ok;
+#endif
+}
@@ -0,0 +1,123 @@
+#ifndef IRFORMAT_H
+#define IRFORMAT_H
+
+#include "types.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// === 二进制三地址码格式 (.wir) ===
+// 供下游工具直接读取的紧凑格式，省去打印和重新解析文本三地址码的开销。
+// 所有整数都是小端序，各段按 8 字节对齐，文件可以 mmap 后按下标直接访问，无需解析：
+//
+//   IRHeader                 48 字节，魔数 "WTAC"、版本号、各段的偏移与元素个数、校验和
+//   字符串偏移表             uint32[stringCount + 1]，第 k 个字符串为 data[off[k], off[k+1]-1)
+//   字符串数据               各字符串依次存放，每个以 '\0' 结尾（可直接当 C 字符串使用）
+//   指令记录                 IRInstr[instrCount]，每条 32 字节，下标即指令地址
+//   变量类型                 IRVarEntry[varCount]，按名字排序的显式声明
+//
+// 句柄 0 固定为空串，表示操作数不存在。常量操作数保留原拼写，同时在 value 中给出已解析的值；
+// 跳转指令的 target 是已解析的目标地址（>= instrCount 表示程序结束）。
+// 校验和为文件头之后全部字节的 FNV-1a（32 位）。主版本号不同的文件拒绝读取。
+
+// 版本 2：算术、关系运算和取负分为 int 与 float 两组操作码，并加入 itof / ftoi 转换
+const uint16_t IR_VERSION = 2;
+
+enum IROp : uint8_t {
+    IR_ADD, IR_SUB, IR_MUL, IR_DIV,
+    IR_LT, IR_LE, IR_GT, IR_GE, IR_EQ, IR_NE,
+    IR_AND, IR_OR, IR_NOT, IR_NEG,
+    IR_ASSIGN, IR_GOTO, IR_JZ, IR_JNZ, IR_DECL,
+    IR_FADD, IR_FSUB, IR_FMUL, IR_FDIV,
+    IR_FLT, IR_FLE, IR_FGT, IR_FGE, IR_FEQ, IR_FNE,
+    IR_FNEG, IR_ITOF, IR_FTOI,
+    IR_NUM_OPS
+};
+
+enum IROperandKind : uint8_t {
+    IR_NONE,        // 空
+    IR_VAR,         // 源程序变量
+    IR_TEMP,        // 临时变量 T<n>
+    IR_INT,         // int 常量（含 true/false），value 为补码
+    IR_FLOAT,       // float 常量，value 为 IEEE 754 位模式
+    IR_LITERAL,     // 超出 int 范围等无法解析的数字字面量，value 为 0
+    IR_LABEL,       // 跳转标号 L<n>
+    IR_NUM_KINDS
+};
+
+struct IRHeader {
+    char magic[4];              // "WTAC"
+    uint16_t version;           // IR_VERSION
+    uint16_t headerSize;        // sizeof(IRHeader)
+    uint32_t fileSize;
+    uint32_t checksum;
+    uint32_t stringCount;
+    uint32_t stringIndexOffset;
+    uint32_t stringDataOffset;
+    uint32_t instrCount;
+    uint32_t instrOffset;
+    uint32_t varCount;
+    uint32_t varOffset;
+    uint32_t reserved;
+};
+
+// 操作数下标：0 = arg1，1 = arg2，2 = result
+struct IRInstr {
+    uint8_t op;                 // IROp
+    uint8_t kind[3];            // IROperandKind
+    uint32_t name[3];           // 字符串句柄
+    uint32_t value[3];          // 常量的值
+    int32_t target;             // 跳转目标地址，非跳转指令为 -1
+};
+
+struct IRVarEntry {
+    uint32_t name;              // 字符串句柄
+    uint8_t isFloat;            // 0 = int，1 = float
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(IRHeader) == 48, "IRHeader 布局");
+static_assert(sizeof(IRInstr) == 32, "IRInstr 布局");
+static_assert(sizeof(IRVarEntry) == 8, "IRVarEntry 布局");
+
+// 序列化为字节串；指令地址必须与下标一致（代码生成器和优化器都保证这一点）
+bool writeIR(const vector<TAC>& code, const map<string, string>& varTypes, string& bytes, string& error);
+
+// 对一段内存中的 .wir 数据的只读视图，validate 通过后才能访问各段
+class IRView {
+private:
+    const uint8_t* data;
+    size_t size;
+    IRHeader header;
+    bool valid = false;
+
+    uint32_t load32(size_t offset) const;
+
+public:
+    IRView(const void* data, size_t size);
+
+    // 检查文件头、版本、校验和、各段边界、字符串结尾、句柄范围、操作码与操作数种类
+    bool validate(string& error);
+
+    const IRHeader& getHeader() const { return header; }
+    uint32_t numStrings() const { return header.stringCount; }
+    uint32_t numInstructions() const { return header.instrCount; }
+    uint32_t numVars() const { return header.varCount; }
+
+    const char* str(uint32_t handle) const;         // '\0' 结尾
+    IRInstr instruction(uint32_t i) const;          // 按小端序解码，与主机字节序无关
+    IRVarEntry var(uint32_t i) const;
+
+    // 还原为三地址码和变量类型表
+    void toTAC(vector<TAC>& code, map<string, string>& varTypes) const;
+};
+
+// 读取 .wir 文件（POSIX 上 mmap），校验后还原为三地址码
+bool readIRFile(const string& path, vector<TAC>& code, map<string, string>& varTypes, string& error);
+
+// 操作码与 TAC 操作符互转，未知操作符返回 IR_NUM_OPS
+IROp irOpOf(const string& op);
+const char* irOpName(IROp op);
+
+#endif // IRFORMAT_H
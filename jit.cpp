@@ -0,0 +1,430 @@
+#include "jit.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_X86_64 1
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+using namespace std;
+
+// 生成的代码通过 r12 访问的运行上下文，偏移量写死在机器码里
+struct JitContext {
+    long long budget;       // +0  剩余的跳转次数
+    int32_t errorPc;        // +8  出错的字节码 PC
+    int32_t unused;
+    VMSlot* frame;
+    uint8_t* tags;
+    const TACVM* vm;
+};
+static_assert(offsetof(JitContext, budget) == 0 && offsetof(JitContext, errorPc) == 8,
+              "JitContext 的布局与生成代码不一致");
+
+namespace {
+
+// 函数返回的状态码
+enum { STATUS_DONE = 0, STATUS_ERROR = 1, STATUS_LIMIT = 2 };
+
+// x86 条件码（jcc/setcc 操作码的低 4 位）
+enum {
+    CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_S = 0x8,
+    CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF
+};
+
+// 关系运算 < <= > >= == != 对应的有符号整数条件码
+const int intCC[6] = { CC_L, CC_LE, CC_G, CC_GE, CC_E, CC_NE };
+
+// 只覆盖本编译器用到的指令形式；内存操作数一律为 [rbx + disp32]
+class Assembler {
+public:
+    vector<uint8_t> buf;
+
+    void u8(uint8_t v) { buf.push_back(v); }
+    void bytes(initializer_list<uint8_t> v) { buf.insert(buf.end(), v.begin(), v.end()); }
+    void u32(uint32_t v) { for (int k = 0; k < 4; k++) u8((uint8_t)(v >> (8 * k))); }
+    void u64(uint64_t v) { for (int k = 0; k < 8; k++) u8((uint8_t)(v >> (8 * k))); }
+
+    // ModRM：mod=10（disp32），基址 rbx，reg 为寄存器编号或操作码扩展
+    void slot(int reg, int k) { u8((uint8_t)(0x80 | (reg << 3) | 3)); u32((uint32_t)(k * 4)); }
+
+    int newLabel() { labelPos.push_back(-1); return (int)labelPos.size() - 1; }
+    void bind(int label) { labelPos[label] = (long)buf.size(); }
+    void jmp(int label) { u8(0xE9); rel(label); }
+    void jcc(int cc, int label) { bytes({ 0x0F, (uint8_t)(0x80 | cc) }); rel(label); }
+    void setcc(int cc, int reg) { bytes({ 0x0F, (uint8_t)(0x90 | cc), (uint8_t)(0xC0 | reg) }); }
+
+    // 常用的槽位读写
+    void loadEax(int k) { u8(0x8B); slot(0, k); }
+    void loadEcx(int k) { u8(0x8B); slot(1, k); }
+    void storeEax(int k) { u8(0x89); slot(0, k); }
+    void loadXmm0(int k) { bytes({ 0xF3, 0x0F, 0x10 }); slot(0, k); }
+    void storeXmm0(int k) { bytes({ 0xF3, 0x0F, 0x11 }); slot(0, k); }
+    void storeBool(int k) { bytes({ 0x0F, 0xB6, 0xC0 }); storeEax(k); }  // movzx eax, al
+
+    // 回填所有 rel32 位移
+    bool resolve() {
+        for (const auto& f : fixups) {
+            long target = labelPos[f.second];
+            if (target < 0) return false;
+            uint32_t rel = (uint32_t)(int32_t)(target - (long)(f.first + 4));
+            for (int k = 0; k < 4; k++) buf[f.first + k] = (uint8_t)(rel >> (8 * k));
+        }
+        return true;
+    }
+
+private:
+    vector<long> labelPos;
+    vector<pair<size_t, int>> fixups;   // rel32 的位置 -> 标号
+
+    void rel(int label) { fixups.push_back(make_pair(buf.size(), label)); u32(0); }
+};
+
+} // namespace
+
+TACJit::TACJit(TACVM& vm) : vm(vm) {
+    compile();
+}
+
+TACJit::~TACJit() {
+#ifdef JIT_X86_64
+    if (!mem) return;
+#if defined(_WIN32)
+    VirtualFree(mem, 0, MEM_RELEASE);
+#else
+    munmap(mem, memSize);
+#endif
+#endif
+}
+
+int TACJit::callGeneric(JitContext* ctx, int pc) {
+    return ctx->vm->execGeneric(ctx->vm->code[pc], ctx->frame, ctx->tags) ? 1 : 0;
+}
+
+int TACJit::callTruth(JitContext* ctx, int slot) {
+    return ctx->vm->loadSlot(slot, ctx->frame, ctx->tags).isZero() ? 0 : 1;
+}
+
+bool TACJit::compile() {
+#ifndef JIT_X86_64
+    failReason = "当前平台不是 x86-64";
+    return false;
+#else
+    const vector<VMInstr>& code = vm.code;
+    int n = (int)code.size();
+    Assembler as;
+    for (int pc = 0; pc < n; pc++) as.newLabel();   // 标号 pc 即字节码 PC 对应的本机地址
+    int doneLabel = as.newLabel(), exitLabel = as.newLabel();
+    int limitLabel = as.newLabel(), errorLabel = as.newLabel();
+    vector<int> errorStub(n, -1);
+    auto errorAt = [&](int pc) {
+        if (errorStub[pc] < 0) errorStub[pc] = as.newLabel();
+        return errorStub[pc];
+    };
+
+    // 序言：保存被调用者保存的寄存器，rbx = 槽位数组，r12 = 上下文，r13 = 跳转预算
+    as.bytes({ 0x53, 0x41, 0x54, 0x41, 0x55 });             // push rbx; push r12; push r13
+#if defined(_WIN32)
+    as.bytes({ 0x48, 0x83, 0xEC, 0x20 });                   // sub rsp, 32（影子空间）
+    as.bytes({ 0x48, 0x89, 0xCB, 0x49, 0x89, 0xD4 });       // mov rbx, rcx; mov r12, rdx
+#else
+    as.bytes({ 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4 });       // mov rbx, rdi; mov r12, rsi
+#endif
+    as.bytes({ 0x4D, 0x8B, 0x2C, 0x24 });                   // mov r13, [r12]
+
+    auto branch = [&]() {
+        as.bytes({ 0x49, 0xFF, 0xCD });                     // dec r13
+        as.jcc(CC_S, limitLabel);
+    };
+    // 调用回退函数 fn(ctx, arg)，结果在 eax
+    auto callOut = [&](int (*fn)(JitContext*, int), int arg) {
+#if defined(_WIN32)
+        as.bytes({ 0x4C, 0x89, 0xE1 });                     // mov rcx, r12
+        as.u8(0xBA);                                        // mov edx, imm32
+#else
+        as.bytes({ 0x4C, 0x89, 0xE7 });                     // mov rdi, r12
+        as.u8(0xBE);                                        // mov esi, imm32
+#endif
+        as.u32((uint32_t)arg);
+        as.bytes({ 0x48, 0xB8 });                           // mov rax, imm64
+        as.u64((uint64_t)(uintptr_t)fn);
+        as.bytes({ 0xFF, 0xD0, 0x85, 0xC0 });               // call rax; test eax, eax
+    };
+    // 浮点结果为 inf/NaN（指数位全 1）时报错
+    auto checkFinite = [&](int pc) {
+        as.bytes({ 0x66, 0x0F, 0x7E, 0xC0 });               // movd eax, xmm0
+        as.u8(0x25); as.u32(0x7F800000);                    // and eax, 0x7F800000
+        as.u8(0x3D); as.u32(0x7F800000);                    // cmp eax, 0x7F800000
+        as.jcc(CC_E, errorAt(pc));
+    };
+    // 比较 xmm0 与 0.0，ZF/PF 给出结果
+    auto compareZeroF = [&](int k) {
+        as.loadXmm0(k);
+        as.bytes({ 0x0F, 0x57, 0xC9, 0x0F, 0x2E, 0xC1 });   // xorps xmm1, xmm1; ucomiss xmm0, xmm1
+    };
+
+    numCallbacks = 0;
+    for (int pc = 0; pc < n; pc++) {
+        const VMInstr& in = code[pc];
+        as.bind(pc);
+        switch (in.op) {
+        case OP_END:
+            as.jmp(doneLabel);
+            break;
+        case OP_MOV:
+            as.loadEax(in.a);
+            as.storeEax(in.d);
+            break;
+        case OP_ITOF:
+            // cvtsi2ss 只写低 32 位，先清零 xmm0 断开对上一条浮点指令的假依赖
+            as.bytes({ 0x0F, 0x57, 0xC0 });                     // xorps xmm0, xmm0
+            as.bytes({ 0xF3, 0x0F, 0x2A }); as.slot(0, in.a);   // cvtsi2ss xmm0, [a]
+            as.storeXmm0(in.d);
+            break;
+        case OP_FTOI:
+            as.bytes({ 0xF3, 0x0F, 0x2C }); as.slot(0, in.a);   // cvttss2si eax, [a]
+            as.storeEax(in.d);
+            break;
+
+        case OP_ADDI: case OP_SUBI:
+            as.loadEax(in.a);
+            as.u8(in.op == OP_ADDI ? 0x03 : 0x2B); as.slot(0, in.b);
+            as.storeEax(in.d);
+            break;
+        case OP_MULI:
+            as.loadEax(in.a);
+            as.bytes({ 0x0F, 0xAF }); as.slot(0, in.b);         // imul eax, [b]
+            as.storeEax(in.d);
+            break;
+        case OP_DIVI: {
+            int ok = as.newLabel();
+            as.loadEax(in.a);
+            as.loadEcx(in.b);
+            as.bytes({ 0x85, 0xC9 });                           // test ecx, ecx
+            as.jcc(CC_E, errorAt(pc));
+            as.bytes({ 0x83, 0xF9, 0xFF });                     // cmp ecx, -1
+            as.jcc(CC_NE, ok);
+            as.u8(0x3D); as.u32(0x80000000u);                   // cmp eax, INT_MIN
+            as.jcc(CC_E, errorAt(pc));
+            as.bind(ok);
+            as.bytes({ 0x99, 0xF7, 0xF9 });                     // cdq; idiv ecx
+            as.storeEax(in.d);
+            break;
+        }
+        case OP_NEGI:
+            as.loadEax(in.a);
+            as.bytes({ 0xF7, 0xD8 });                           // neg eax
+            as.storeEax(in.d);
+            break;
+        case OP_NOTI:
+            as.loadEcx(in.a);
+            as.bytes({ 0x31, 0xC0, 0x85, 0xC9 });               // xor eax, eax; test ecx, ecx
+            as.setcc(CC_E, 0);
+            as.storeEax(in.d);
+            break;
+
+        case OP_ADDF: case OP_SUBF: case OP_MULF: case OP_DIVF: {
+            static const uint8_t sse[] = { 0x58, 0x5C, 0x59, 0x5E };   // addss subss mulss divss
+            as.loadXmm0(in.a);
+            as.bytes({ 0xF3, 0x0F, sse[in.op - OP_ADDF] }); as.slot(0, in.b);
+            checkFinite(pc);
+            as.storeXmm0(in.d);
+            break;
+        }
+        case OP_NEGF:
+            as.loadEax(in.a);
+            as.u8(0x35); as.u32(0x80000000u);                   // xor eax, 符号位
+            as.storeEax(in.d);
+            break;
+        case OP_NOTF:
+            compareZeroF(in.a);
+            as.setcc(CC_E, 0); as.setcc(CC_NP, 1);              // 相等且有序
+            as.bytes({ 0x20, 0xC8 });                           // and al, cl
+            as.storeBool(in.d);
+            break;
+
+        case OP_LTI: case OP_LEI: case OP_GTI: case OP_GEI: case OP_EQI: case OP_NEI:
+            as.loadEax(in.a);
+            as.u8(0x3B); as.slot(0, in.b);                      // cmp eax, [b]
+            as.setcc(intCC[in.op - OP_LTI], 0);
+            as.storeBool(in.d);
+            break;
+        case OP_LTF: case OP_LEF: case OP_GTF: case OP_GEF: case OP_EQF: case OP_NEF: {
+            // ucomiss 无序（NaN）时 ZF=PF=CF=1；a<b 写成 b>a 用 seta/setae，NaN 时为假
+            int rel = in.op - OP_LTF;
+            bool swap = rel <= 1;
+            as.loadXmm0(swap ? in.b : in.a);
+            as.bytes({ 0x0F, 0x2E }); as.slot(0, swap ? in.a : in.b);
+            if (rel == 4) {
+                as.setcc(CC_E, 0); as.setcc(CC_NP, 1);
+                as.bytes({ 0x20, 0xC8 });                       // and al, cl
+            } else if (rel == 5) {
+                as.setcc(CC_NE, 0); as.setcc(CC_P, 1);
+                as.bytes({ 0x08, 0xC8 });                       // or al, cl
+            } else {
+                as.setcc(rel == 0 || rel == 2 ? CC_A : CC_AE, 0);
+            }
+            as.storeBool(in.d);
+            break;
+        }
+        case OP_ANDI: case OP_ORI:
+            as.loadEax(in.a);
+            as.bytes({ 0x85, 0xC0 }); as.setcc(CC_NE, 0);      // test eax, eax; setne al
+            as.loadEcx(in.b);
+            as.bytes({ 0x85, 0xC9 }); as.setcc(CC_NE, 1);      // test ecx, ecx; setne cl
+            as.bytes({ (uint8_t)(in.op == OP_ANDI ? 0x20 : 0x08), 0xC8 });
+            as.storeBool(in.d);
+            break;
+
+        case OP_GOTO:
+            branch();
+            as.jmp(in.x);
+            break;
+        case OP_JZI: case OP_JNZI:
+            branch();
+            as.u8(0x83); as.slot(7, in.a); as.u8(0);            // cmp dword [a], 0
+            as.jcc(in.op == OP_JZI ? CC_E : CC_NE, in.x);
+            break;
+        case OP_JZF: {
+            int skip = as.newLabel();
+            branch();
+            compareZeroF(in.a);
+            as.jcc(CC_P, skip);
+            as.jcc(CC_E, in.x);
+            as.bind(skip);
+            break;
+        }
+        case OP_JNZF:
+            branch();
+            compareZeroF(in.a);
+            as.jcc(CC_P, in.x);
+            as.jcc(CC_NE, in.x);
+            break;
+        case OP_JLTI: case OP_JLEI: case OP_JGTI: case OP_JGEI: case OP_JEQI: case OP_JNEI:
+            branch();
+            as.loadEax(in.a);
+            as.u8(0x3B); as.slot(0, in.b);                      // cmp eax, [b]
+            as.jcc(intCC[in.op - OP_JLTI], in.x);
+            break;
+
+        case OP_GEN:
+            callOut(&TACJit::callGeneric, pc);
+            as.jcc(CC_E, errorAt(pc));
+            numCallbacks++;
+            break;
+        case OP_GJZ: case OP_GJNZ:
+            branch();
+            callOut(&TACJit::callTruth, in.a);
+            as.jcc(in.op == OP_GJZ ? CC_E : CC_NE, in.x);
+            numCallbacks++;
+            break;
+
+        default:
+            failReason = "字节码含无法翻译的指令";
+            return false;
+        }
+    }
+
+    // 出口：eax 为状态码，把剩余预算写回上下文
+    as.bind(doneLabel);
+    as.bytes({ 0x31, 0xC0 });                                   // xor eax, eax
+    as.bind(exitLabel);
+    as.bytes({ 0x4D, 0x89, 0x2C, 0x24 });                       // mov [r12], r13
+#if defined(_WIN32)
+    as.bytes({ 0x48, 0x83, 0xC4, 0x20 });                       // add rsp, 32
+#endif
+    as.bytes({ 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 });           // pop r13; pop r12; pop rbx; ret
+    as.bind(limitLabel);
+    as.u8(0xB8); as.u32(STATUS_LIMIT);                          // mov eax, 2
+    as.jmp(exitLabel);
+    for (int pc = 0; pc < n; pc++) {
+        if (errorStub[pc] < 0) continue;
+        as.bind(errorStub[pc]);
+        as.u8(0xB8); as.u32((uint32_t)pc);                      // mov eax, pc
+        as.jmp(errorLabel);
+    }
+    as.bind(errorLabel);
+    as.bytes({ 0x41, 0x89, 0x44, 0x24, 0x08 });                 // mov [r12 + 8], eax
+    as.u8(0xB8); as.u32(STATUS_ERROR);
+    as.jmp(exitLabel);
+
+    if (!as.resolve()) {
+        failReason = "跳转标号未定义";
+        return false;
+    }
+    return install(as.buf);
+#endif
+}
+
+bool TACJit::install(const vector<uint8_t>& bytes) {
+#ifdef JIT_X86_64
+    size_t page = 4096;
+    memSize = (bytes.size() + page - 1) / page * page;
+#if defined(_WIN32)
+    void* p = VirtualAlloc(nullptr, memSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!p) {
+        failReason = "无法分配可执行内存";
+        return false;
+    }
+    memcpy(p, bytes.data(), bytes.size());
+    DWORD old;
+    if (!VirtualProtect(p, memSize, PAGE_EXECUTE_READ, &old)) {
+        VirtualFree(p, 0, MEM_RELEASE);
+        failReason = "无法把内存设为可执行";
+        return false;
+    }
+#else
+    void* p = mmap(nullptr, memSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        failReason = "无法分配可执行内存";
+        return false;
+    }
+    memcpy(p, bytes.data(), bytes.size());
+    // 先写后改权限，内存不会同时可写又可执行
+    if (mprotect(p, memSize, PROT_READ | PROT_EXEC) != 0) {
+        munmap(p, memSize);
+        failReason = "无法把内存设为可执行";
+        return false;
+    }
+#endif
+    mem = (uint8_t*)p;
+    codeSize = bytes.size();
+    entry = (EntryFn)p;
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+VMResult TACJit::run(long long branchLimit) {
+    if (!entry) return vm.run(branchLimit);
+
+    VMResult res;
+    vector<VMSlot> slotv = vm.initial;
+    vector<uint8_t> tags(slotv.size(), 0);
+    JitContext ctx;
+    ctx.budget = branchLimit;
+    ctx.errorPc = -1;
+    ctx.unused = 0;
+    ctx.frame = slotv.data();
+    ctx.tags = tags.data();
+    ctx.vm = &vm;
+
+    int status = entry(slotv.data(), &ctx);
+    if (status == STATUS_ERROR) {
+        res.ok = false;
+        res.error = vm.errorAt(ctx.errorPc);
+    } else if (status == STATUS_LIMIT) {
+        res.limitHit = true;
+        ctx.budget = 0;
+    }
+    res.branches = branchLimit - max(ctx.budget, 0LL);
+    vm.collectVars(res, slotv.data(), tags.data());
+    return res;
+}
@@ -0,0 +1,55 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "vm.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// === x86-64 本机代码编译器（JIT） ===
+// 以虚拟机降级后的字节码为输入（槽位类型、比较跳转融合都已完成），
+// 逐条翻译为 x86-64 机器码，写入可执行内存后直接调用：
+//   - 槽位数组作为栈帧，rbx 指向它，每个变量/临时变量/常量都是 [rbx + 4*k]；
+//   - int 运算用通用寄存器指令（32 位补码回绕），float 运算用 SSE 标量指令；
+//   - goto/jz/比较跳转翻译成本机 jmp/jcc，r13 保存剩余的跳转次数预算；
+//   - 含 DYN 槽位的通用指令（GEN/GJZ/GJNZ）没有本机翻译，回调虚拟机的求值函数执行。
+// 整数除零、INT_MIN / -1 和非有限浮点结果跳到错误出口，报告的错误与虚拟机相同。
+// 仅支持 x86-64（System V 与 Windows 调用约定），其他平台 run() 直接使用虚拟机执行。
+
+struct JitContext;
+
+class TACJit {
+private:
+    TACVM& vm;
+    uint8_t* mem = nullptr;     // 可执行内存
+    size_t memSize = 0;
+    size_t codeSize = 0;
+    int numCallbacks = 0;       // 回调虚拟机执行的指令条数
+    string failReason;
+
+    typedef int (*EntryFn)(VMSlot* frame, JitContext* ctx);
+    EntryFn entry = nullptr;
+
+    bool compile();
+    bool install(const vector<uint8_t>& bytes);
+
+    // 回退路径：由生成的代码调用
+    static int callGeneric(JitContext* ctx, int pc);    // 成功返回 1
+    static int callTruth(JitContext* ctx, int slot);    // 槽位值非零返回 1
+
+public:
+    explicit TACJit(TACVM& vm);
+    ~TACJit();
+    TACJit(const TACJit&) = delete;
+    TACJit& operator=(const TACJit&) = delete;
+
+    // 执行一次，语义与 TACVM::run 相同；未能生成本机代码时由虚拟机执行
+    VMResult run(long long branchLimit = 100000000);
+
+    bool isCompiled() const { return entry != nullptr; }
+    const string& reason() const { return failReason; }    // 未能生成本机代码的原因
+    size_t codeBytes() const { return codeSize; }
+    int numFallbacks() const { return numCallbacks; }
+};
+
+#endif // JIT_H
@@ -1,6 +1,6 @@
 #include "lexer.h"
-#include <iostream>
 #include <cctype>
+#include <cstdint>
 
 using namespace std;
 
@@ -30,22 +30,45 @@ void Lexer::reportLexicalError(int line, int col, char c, const string& reason)
         else msg += c; // 否则直接拼接
         msg += "')";
     }
-    errorMessages.push_back(msg);
-    cout << "错误: " << msg << endl;
+    diagnostics.push_back({ DiagnosticKind::LEXICAL, true, line, col, msg });
 }
 
 // 返回的token是vector对象本身。vector内部的堆内存：已被转移/直接构造在返回对象中
 vector<Word> Lexer::performLexicalAnalysis(const string& input) {
+    vector<Word> result;
+    scanInBatches(input, SIZE_MAX, false, [&result](vector<Word>& batch) {
+        result = move(batch);   // 不分批时只在结束时调用一次
+        return true;
+    });
+    return result;
+}
+
+bool Lexer::scanInBatches(const string& input, size_t batchSize, bool stopOnError,
+                          const function<bool(vector<Word>&)>& onBatch) {
     hasError = false; // 重置错误标志
-    errorMessages.clear(); // 清空错误信息
+    diagnostics.clear(); // 清空错误信息
     
     vector<Word> tokens;
     int i = 0, len = input.length();
     int line = 1, col = 1;           // 当前行号和列号
     int startLine = 1, startCol = 1; // Token起始位置（用于错误报告）
     
+    // 遇到错误即停止时：丢掉出错位置及之后的 token（如非法字符本身），只交出错误之前的部分
+    auto stopAtError = [&]() {
+        const Diagnostic& first = diagnostics.front();
+        while (!tokens.empty() && (tokens.back().line > first.line ||
+               (tokens.back().line == first.line && tokens.back().col >= first.col))) tokens.pop_back();
+        onBatch(tokens);
+        return false;
+    };
+
     // 主扫描循环：逐个字符处理
     while (i < len) { // 遍历输入字符串中的每个字符
+        if (stopOnError && hasError) return stopAtError();
+        if (tokens.size() >= batchSize) {
+            if (!onBatch(tokens)) return false;
+            tokens.clear();
+        }
         startLine = line;
         startCol = col;
         
@@ -85,14 +108,13 @@ vector<Word> Lexer::performLexicalAnalysis(const string& input) {
             i += 2;  // 跳过 /*
             col += 2;
             bool foundEnd = false;
-            int lastLine = line, lastCol = col;  // 记录最后扫描到的位置
+            int lastLine = line;  // 记录最后扫描到的行
             while (i < len) {
                 if (input[i] == '\n') {
                     line++;
                     col = 1;
                     i++;
                     lastLine = line;
-                    lastCol = col;
                 }
                 else if (input[i] == '*' && i + 1 < len && input[i + 1] == '/') {
                     // 找到注释结束
@@ -105,7 +127,6 @@ vector<Word> Lexer::performLexicalAnalysis(const string& input) {
                     i++;
                     col++;
                     lastLine = line;
-                    lastCol = col;
                 }
             }
             if (!foundEnd) {
@@ -303,6 +324,8 @@ vector<Word> Lexer::performLexicalAnalysis(const string& input) {
             col++;
         }
     }
+    if (stopOnError && hasError) return stopAtError();
     tokens.push_back({ -1, "#", "结束符", line, col });
-    return tokens;
+    onBatch(tokens);
+    return true;
 }
\ No newline at end of file
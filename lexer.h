@@ -2,6 +2,7 @@
 #define LEXER_H
 
 #include "types.h"
+#include <functional>
 #include <vector>
 
 // === 词法分析器 ===
@@ -9,7 +10,7 @@
 class Lexer {
 private:
     bool hasError = false;
-    vector<string> errorMessages;
+    vector<Diagnostic> diagnostics;     // 词法错误，不直接输出，由调用方决定如何显示
 
     // 字符判断函数
     bool isIdStart(char c);
@@ -21,11 +22,17 @@ private:
 public:
     // 执行词法分析
     vector<Word> performLexicalAnalysis(const string& input);
+    // 分批词法分析：每凑满 batchSize 个 token 调用一次 onBatch（可以移走其中的内容），
+    // 结束时再调用一次交出剩余部分（末尾为结束符 #）。onBatch 返回 false 时停止扫描。
+    // stopOnError 为 true 时遇到第一个词法错误即停止，最后一批只含错误位置之前的 token，不含结束符。
+    // 正常扫描到结尾时返回 true
+    bool scanInBatches(const string& input, size_t batchSize, bool stopOnError,
+                       const function<bool(vector<Word>&)>& onBatch);
     
     // 获取错误信息
     bool hasErrors() const { return hasError; }
-    const vector<string>& getErrorMessages() const { return errorMessages; }
-    void clearErrors() { hasError = false; errorMessages.clear(); }
+    const vector<Diagnostic>& getDiagnostics() const { return diagnostics; }
+    void clearErrors() { hasError = false; diagnostics.clear(); }
 };
 
 #endif // LEXER_H
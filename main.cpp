@@ -1,7 +1,11 @@
 #include "compiler.h"
+#include "irformat.h"
+#include "vm.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <cstdlib>
 
 using namespace std;
 
@@ -24,12 +28,97 @@ int main(int argc, char* argv[]) {
     WhileCompiler compiler;
     string code;
     string filename;
+    string emitTarget, emitPath;
+    string irPath;
+    bool showStats = false;
+    string statsPath, tracePath;
+    string cacheDir;
+    unsigned long long cacheLimitMB = 64;
     
-    // 如果提供了命令行参数，使用指定的文件
-    if (argc > 1) {
-        filename = argv[1];
-    } else {
-        filename = "2.txt";  // 默认测试文件名，可以修改为其他文件名
+    // 命令行参数：以 - 开头的是选项，其余的是输入文件名
+    //   -O       运行三地址码优化器
+    //   --count  解释执行三地址码，统计执行指令数
+    //   --profile 剖析执行，报告最热的循环（含每次进入的迭代次数分布）、基本块和源程序行
+    //   --cfg    输出控制流图、支配者、自然循环和数据流分析结果
+    //   --ssa    输出 SSA 形式、SSA 上常量传播/死代码删除的结果及转回的三地址码
+    //   --run    在字节码虚拟机上执行（与 -O 同用时执行优化后的代码），输出结束时的变量值
+    //   --jit    编译为 x86-64 本机代码执行，其他平台退回虚拟机
+    //   --emit=c 输出等价的 C 源码，-o <文件> 写入文件而不是控制台
+    //   --emit=asm 输出 x86-64 汇编（线性扫描寄存器分配），--emit=asm-stack 输出全部用栈槽的朴素汇编
+    //   --emit=ir  输出二进制三地址码（需配合 -o），--read-ir <文件> 校验并以文本形式输出二进制三地址码
+    //   --stats    编译结束后以 JSON 输出各阶段计时与计数，--stats=<文件> 写入文件
+    //   --trace-out <文件>  把各阶段计时区间写成 Chrome / Perfetto trace 事件
+    //   --pipeline 词法、语法分析与代码生成在三个线程中流水线执行（不输出语法分析过程）
+    //   --no-peephole  不运行窥孔优化，输出代码生成器原样生成的三地址码
+    //   --cache <目录>  使用磁盘编译缓存，命中时跳过词法与语法分析（不输出 token 表和分析过程）
+    //   --cache-limit <MB>  编译缓存的总大小上限，默认 64
+    filename = "2.txt";  // 默认测试文件名，可以修改为其他文件名
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-O") {
+            compiler.setOptimize(true);
+        } else if (arg == "--count") {
+            compiler.setCountExecution(true);
+        } else if (arg == "--profile") {
+            compiler.setProfile(true);
+        } else if (arg == "--cfg") {
+            compiler.setShowCFG(true);
+        } else if (arg == "--ssa") {
+            compiler.setShowSSA(true);
+        } else if (arg == "--run") {
+            compiler.setRunVM(true);
+        } else if (arg == "--jit") {
+            compiler.setRunJIT(true);
+        } else if (arg == "--pipeline") {
+            compiler.setPipeline(true);
+        } else if (arg == "--no-peephole") {
+            compiler.setPeephole(false);
+        } else if (arg.compare(0, 7, "--emit=") == 0) {
+            emitTarget = arg.substr(7);
+        } else if (arg == "-o" && i + 1 < argc) {
+            emitPath = argv[++i];
+        } else if (arg == "--read-ir" && i + 1 < argc) {
+            irPath = argv[++i];
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg.compare(0, 8, "--stats=") == 0) {
+            showStats = true;
+            statsPath = arg.substr(8);
+        } else if (arg == "--trace-out" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--cache-limit" && i + 1 < argc) {
+            cacheLimitMB = strtoull(argv[++i], nullptr, 10);
+        } else {
+            filename = arg;
+        }
+    }
+    
+    compiler.setEmit(emitTarget, emitPath);
+    unique_ptr<CompileCache> cache;
+    if (!cacheDir.empty()) {
+        cache.reset(new CompileCache(cacheDir, cacheLimitMB * 1024 * 1024));
+        compiler.setCache(cache.get());
+    }
+
+    // 读取二进制三地址码：不编译源程序，校验后按文本格式输出
+    if (!irPath.empty()) {
+        vector<TAC> tac;
+        map<string, string> varTypes;
+        string error;
+        if (!readIRFile(irPath, tac, varTypes, error)) {
+            cerr << "错误: " << error << endl;
+            return 1;
+        }
+        OutputSink& out = OutputSink::console();
+        out << "从二进制三地址码读取: " << irPath << "\n";
+        for (const auto& kv : varTypes) out << "  " << kv.second << " " << kv.first << "\n";
+        printTACCode(tac, out);
+        // 外部产生的文件可能没有经过类型推断，这里再做一次静态类型检查
+        for (const auto& p : checkTACTypes(tac, varTypes)) out << "类型检查: " << p << "\n";
+        out.flush();
+        return 0;
     }
     
     // 从文件读取代码
@@ -43,5 +132,20 @@ int main(int argc, char* argv[]) {
     cout << "从文件读取: " << filename << endl;
     cout << "输入代码:\n" << code << "\n" << endl;
     compiler.run(code);
+
+    string error;
+    if (showStats && statsPath.empty()) {
+        OutputSink& out = OutputSink::console();
+        out << "\n--- 编译统计 (JSON) ---\n";
+        compiler.getStats().writeJSON(out);
+        out.flush();
+    } else if (showStats && !compiler.getStats().writeJSON(statsPath, error)) {
+        cerr << "错误: " << error << endl;
+        return 1;
+    }
+    if (!tracePath.empty() && !compiler.getStats().writeTrace(tracePath, error)) {
+        cerr << "错误: " << error << endl;
+        return 1;
+    }
     return 0;
 }
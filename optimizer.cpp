@@ -0,0 +1,1037 @@
+#include "optimizer.h"
+#include "tacutil.h"
+#include "dataflow.h"
+#include "ssa.h"
+#include "vm.h"
+#include "peephole.h"
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+TACOptimizer::TACOptimizer(const map<string, string>& varTypes) : varTypes(varTypes) {
+}
+
+bool TACOptimizer::isFloatVar(const string& name) const {
+    auto it = varTypes.find(name);
+    return it != varTypes.end() && it->second == "float";
+}
+
+// 基本块内的传播与折叠
+// 块内维护两张表：consts（名称 -> 已知常量）与 copies（名称 -> 复写来源）
+// 某个名称被重新定值时，删除它自身的记录以及所有以它为来源的复写
+int TACOptimizer::propagateAndFold(vector<TAC>& code) {
+    int changes = 0;
+    vector<bool> removed(code.size(), false);
+    vector<int> leaders = findLeaders(code);
+
+    for (size_t b = 0; b + 1 < leaders.size(); b++) {
+        map<string, ConstVal> consts;
+        map<string, string> copies;
+
+        // 用已知的常量或复写来源替换操作数
+        auto substitute = [&](string& operand) {
+            if (operand.empty() || isConstName(operand)) return;
+            auto cp = copies.find(operand);
+            if (cp != copies.end()) {
+                operand = cp->second;
+                passStats["复写传播"]++;
+                changes++;
+            }
+            auto cv = consts.find(operand);
+            if (cv != consts.end()) {
+                operand = formatConst(cv->second);
+                passStats["常量传播"]++;
+                changes++;
+            }
+        };
+
+        for (int i = leaders[b]; i < leaders[b + 1]; i++) {
+            TAC& t = code[i];
+            if (t.op == "goto") continue;
+            substitute(t.arg1);
+            if (!isCondJumpOp(t.op)) substitute(t.arg2);
+
+            // 条件跳转：条件已知时改为无条件跳转或直接删除
+            if (isCondJumpOp(t.op)) {
+                ConstVal c;
+                if (parseConst(t.arg1, c)) {
+                    bool taken = (t.op == "jz") == c.isZero();
+                    if (taken) { t.op = "goto"; t.arg1 = ""; }
+                    else removed[i] = true;
+                    passStats["条件跳转折叠"]++;
+                    changes++;
+                }
+                continue;
+            }
+
+            // 常量折叠与代数恒等式
+            ConstVal a, c, r;
+            bool aConst = parseConst(t.arg1, a);
+            bool cConst = !t.arg2.empty() && parseConst(t.arg2, c);
+            if (t.op != ":=" && t.arg2.empty() && aConst && foldUnary(t.op, a, r)) {
+                t.op = ":="; t.arg1 = formatConst(r);
+                passStats["常量折叠"]++;
+                changes++;
+            } else if (!t.arg2.empty() && aConst && cConst && foldBinary(t.op, a, c, r)) {
+                t.op = ":="; t.arg1 = formatConst(r); t.arg2 = "";
+                passStats["常量折叠"]++;
+                changes++;
+            } else if (!t.arg2.empty()) {
+                // 只使用整数常量 0/1，保证结果类型与另一操作数一致
+                string keep;
+                if (cConst && !c.isFloat && c.i == 0 && (t.op == "+" || t.op == "-")) keep = t.arg1;
+                else if (cConst && !c.isFloat && c.i == 1 && (t.op == "*" || t.op == "/")) keep = t.arg1;
+                else if (aConst && !a.isFloat && a.i == 0 && t.op == "+") keep = t.arg2;
+                else if (aConst && !a.isFloat && a.i == 1 && t.op == "*") keep = t.arg2;
+                if (!keep.empty()) {
+                    t.op = ":="; t.arg1 = keep; t.arg2 = "";
+                    passStats["代数化简"]++;
+                    changes++;
+                }
+            }
+
+            // 自身复写 x := x 没有效果
+            if (t.op == ":=" && t.arg1 == t.result) {
+                removed[i] = true;
+                passStats["删除自身复写"]++;
+                changes++;
+                continue;
+            }
+
+            // 更新块内信息：先使被重新定值的名称失效
+            string d = defOf(t);
+            if (d.empty()) continue;
+            consts.erase(d);
+            copies.erase(d);
+            for (auto it = copies.begin(); it != copies.end();) {
+                if (it->second == d) it = copies.erase(it);
+                else ++it;
+            }
+            if (t.op != ":=" || t.arg1 == d) continue;
+
+            ConstVal v;
+            if (parseConst(t.arg1, v)) {
+                // 赋给声明过类型的变量时按变量类型转换（int x = 2.5 存入 2）
+                if (isDeclared(d) && v.isFloat != isFloatVar(d)) {
+                    v = convertConst(v, isFloatVar(d));
+                    t.arg1 = formatConst(v);
+                    passStats["常量折叠"]++;
+                    changes++;
+                }
+                consts[d] = v;
+            } else if (isTempName(d) ||
+                       (isDeclared(d) && isDeclared(t.arg1) && isFloatVar(d) == isFloatVar(t.arg1))) {
+                // 临时变量原样保存来源的值；变量之间只有类型相同时才是等值复写
+                copies[d] = t.arg1;
+            }
+        }
+    }
+
+    compactTAC(code, removed);
+    return changes;
+}
+
+// 局部值编号 (LVN)
+// 每个名称/常量对应一个值编号，表达式以 "运算符,编号1,编号2" 为键查哈希表；
+// 可交换运算（+ * && || == != 及对应的 float 运算）的两个编号按大小排序，使 a*b 与 b*a 得到同一个键。
+// 名称被重新定值（:= 或 ++/-- 展开后的赋值）时获得新编号，旧表达式自然失效。
+int TACOptimizer::valueNumbering(vector<TAC>& code) {
+    static const set<string> commutative = { "+", "*", "&&", "||", "==", "!=", "+.", "*.", "==.", "!=." };
+    int rewrites = 0;
+    vector<int> leaders = findLeaders(code);
+
+    for (size_t b = 0; b + 1 < leaders.size(); b++) {
+        unordered_map<string, int> nameVN;   // 名称或常量 -> 当前值编号
+        unordered_map<string, int> exprVN;   // 表达式键 -> 值编号
+        unordered_map<int, string> holder;   // 值编号 -> 最先持有它的名称
+        int nextVN = 0;
+
+        auto vnOf = [&](const string& name) {
+            auto it = nameVN.find(name);
+            if (it != nameVN.end()) return it->second;
+            return nameVN[name] = nextVN++;
+        };
+        // 持有者被重新定值后不再持有该编号
+        auto holderOf = [&](int vn) {
+            auto it = holder.find(vn);
+            if (it == holder.end() || nameVN[it->second] != vn) return string();
+            return it->second;
+        };
+
+        for (int i = leaders[b]; i < leaders[b + 1]; i++) {
+            TAC& t = code[i];
+            string d = defOf(t);
+            if (d.empty()) continue;
+
+            int vn;
+            if (t.op == ":=") {
+                // 类型化的三地址码中 := 两侧类型相同（转换都是显式的 itof / ftoi），复写保持同一编号
+                vn = vnOf(t.arg1);
+            } else {
+                int v1 = vnOf(t.arg1);
+                string key = t.op + "," + to_string(v1);
+                if (!t.arg2.empty()) {
+                    int v2 = vnOf(t.arg2);
+                    if (commutative.count(t.op) && v2 < v1) swap(v1, v2);
+                    key = t.op + "," + to_string(v1) + "," + to_string(v2);
+                }
+                auto it = exprVN.find(key);
+                string h = (it != exprVN.end()) ? holderOf(it->second) : string();
+                if (!h.empty()) {
+                    // 重复计算：改写为复写，留给复写传播和死代码删除清理
+                    t.op = ":="; t.arg1 = h; t.arg2 = "";
+                    vn = it->second;
+                    passStats["局部值编号"]++;
+                    rewrites++;
+                } else {
+                    vn = nextVN++;
+                    exprVN[key] = vn;
+                }
+            }
+            nameVN[d] = vn;
+            if (holderOf(vn).empty()) holder[vn] = d;
+        }
+    }
+    return rewrites;
+}
+
+// 后缀自增/自减（产生式 31、33）生成的 T := v; T' := v ± 1; v := T' 中保存原值的复写
+static bool isPostfixCopy(const vector<TAC>& code, size_t i) {
+    if (i + 2 >= code.size() || code[i].op != ":=" || isConstName(code[i].arg1)) return false;
+    const string& v = code[i].arg1;
+    const TAC& step = code[i + 1];
+    const TAC& assign = code[i + 2];
+    string op = scalarOp(step.op);
+    return (op == "+" || op == "-") && step.arg1 == v && (step.arg2 == "1" || step.arg2 == "1.0") &&
+           assign.op == ":=" && assign.arg1 == step.result && assign.result == v;
+}
+
+// newTemp() 生成的临时变量只被定值一次，全程序没有引用的临时变量定值即为死代码；
+// 表达式语句 i++ 的值不被使用，保存原值的复写在这里删除
+int TACOptimizer::removeUnusedTemps(vector<TAC>& code) {
+    int total = 0;
+    while (true) {
+        set<string> used;
+        for (const auto& t : code) {
+            for (const auto& u : usesOf(t)) used.insert(u);
+        }
+        vector<bool> removed(code.size(), false);
+        int count = 0;
+        for (size_t i = 0; i < code.size(); i++) {
+            string d = defOf(code[i]);
+            if (isTempName(d) && isPureOp(code[i].op) && !used.count(d)) {
+                if (isPostfixCopy(code, i)) passStats["删除后缀自增的复写"]++;
+                removed[i] = true;
+                count++;
+            }
+        }
+        if (count == 0) break;
+        compactTAC(code, removed);
+        total += count;
+    }
+    passStats["删除无用临时变量"] += total;
+    return total;
+}
+
+int TACOptimizer::eliminateDeadCode(vector<TAC>& code) {
+    int total = 0;
+    while (true) {
+        CFG cfg(code);
+        LivenessAnalysis liveness(cfg);
+        vector<BitVector> liveOut = liveness.liveOutPerInstruction();
+        vector<bool> removed(code.size(), false);
+        int count = 0;
+        for (size_t i = 0; i < code.size(); i++) {
+            string d = defOf(code[i]);
+            if (!d.empty() && isPureOp(code[i].op) && !liveOut[i].test(liveness.bitOf(d))) {
+                removed[i] = true;
+                count++;
+            }
+        }
+        if (count == 0) break;
+        compactTAC(code, removed);
+        total += count;
+    }
+    passStats["删除死代码"] += total;
+    return total;
+}
+
+int TACOptimizer::threadJumps(vector<TAC>& code) {
+    int n = (int)code.size();
+    int count = 0;
+    for (auto& t : code) {
+        if (!isJumpOp(t.op)) continue;
+        int target = labelAddr(t.result);
+        // 沿 goto 链前进，步数上限防止 goto 自环
+        int final = target, hops = 0;
+        while (final >= 0 && final < n && code[final].op == "goto" && hops++ < n) {
+            final = labelAddr(code[final].result);
+        }
+        if (final != target && final >= 0) {
+            t.result = makeLabel(final);
+            count++;
+        }
+    }
+    passStats["跳转穿透"] += count;
+    return count;
+}
+
+int TACOptimizer::removeUnreachable(vector<TAC>& code) {
+    vector<int> leaders = findLeaders(code);
+    vector<vector<int>> succ = blockSuccessors(code, leaders);
+    int nb = (int)leaders.size() - 1;
+    if (nb <= 0) return 0;
+
+    vector<bool> reached(nb + 1, false);
+    vector<int> work(1, 0);
+    reached[0] = true;
+    while (!work.empty()) {
+        int b = work.back();
+        work.pop_back();
+        if (b >= nb) continue;
+        for (int s : succ[b]) {
+            if (!reached[s]) { reached[s] = true; work.push_back(s); }
+        }
+    }
+
+    vector<bool> removed(code.size(), false);
+    int count = 0;
+    for (int b = 0; b < nb; b++) {
+        if (reached[b]) continue;
+        for (int i = leaders[b]; i < leaders[b + 1]; i++) { removed[i] = true; count++; }
+    }
+    if (count > 0) compactTAC(code, removed);
+    passStats["删除不可达代码"] += count;
+    return count;
+}
+
+// 循环变换对代码的改动，由 applyLoopEdits 一次完成并重新编号跳转
+// 原地址 i 处的新布局：preheader[i]、before[i]、指令 i（未删除时）、after[i]
+struct LoopEdits {
+    vector<bool> removed;                   // 删除的指令
+    map<int, vector<TAC>> before;           // 插在指令 i 之前，跳到 i 的跳转先执行它们
+    map<int, vector<TAC>> after;            // 插在指令 i 之后，跳到 i+1 的跳转越过它们
+    map<int, vector<TAC>> preheader;        // 插在循环头 h 之前，只在从循环外进入时执行
+    map<int, vector<bool>> loopBlocks;      // 循环头 h -> 循环包含的块，其中跳到 h 的是回边或 continue
+};
+
+static void applyLoopEdits(vector<TAC>& code, const CFG& cfg, const LoopEdits& edits) {
+    int n = (int)code.size();
+    vector<int> preStart(n, -1), bodyStart(n, -1), origin;
+    vector<TAC> out;
+    out.reserve(n);
+    auto append = [&](map<int, vector<TAC>>::const_iterator it, const map<int, vector<TAC>>& m) {
+        if (it == m.end()) return;
+        for (const auto& t : it->second) { out.push_back(t); origin.push_back(-1); }
+    };
+    for (int i = 0; i < n; i++) {
+        auto ph = edits.preheader.find(i);
+        if (ph != edits.preheader.end()) preStart[i] = (int)out.size();
+        append(ph, edits.preheader);
+        int mark = (int)out.size();
+        append(edits.before.find(i), edits.before);
+        if (!edits.removed[i]) { out.push_back(code[i]); origin.push_back(i); }
+        append(edits.after.find(i), edits.after);
+        if ((int)out.size() > mark) bodyStart[i] = mark;
+    }
+    // inner[i]：从循环内跳到 i 的新地址；entry[i]：从循环外跳到 i 的新地址（有前置块时进入前置块）
+    // 地址 i 处什么都不剩时（指令被删除）改为跳到其后的位置
+    vector<int> entry(n + 1), inner(n + 1);
+    entry[n] = inner[n] = (int)out.size();
+    for (int i = n - 1; i >= 0; i--) {
+        inner[i] = bodyStart[i] >= 0 ? bodyStart[i] : entry[i + 1];
+        entry[i] = preStart[i] >= 0 ? preStart[i] : inner[i];
+    }
+    for (int k = 0; k < (int)out.size(); k++) {
+        TAC& t = out[k];
+        t.addr = k;
+        int target = labelAddr(t.result);
+        if (origin[k] < 0 || !isJumpOp(t.op) || target < 0) continue;
+        if (target >= n) { t.result = makeLabel((int)out.size()); continue; }
+        auto lb = edits.loopBlocks.find(target);
+        bool fromInside = lb != edits.loopBlocks.end() && lb->second[cfg.blockOf(origin[k])];
+        t.result = makeLabel(fromInside ? inner[target] : entry[target]);
+    }
+    code.swap(out);
+}
+
+// 按嵌套深度从内到外排列循环下标
+static vector<int> innermostFirst(const vector<NaturalLoop>& loops) {
+    vector<int> order;
+    for (int k = 0; k < (int)loops.size(); k++) order.push_back(k);
+    stable_sort(order.begin(), order.end(),
+                [&](int a, int b) { return loops[a].depth > loops[b].depth; });
+    return order;
+}
+
+// 循环头之前的指令顺序落入头部且属于循环时，前置块无处可插
+static bool canInsertPreheader(const vector<TAC>& code, const CFG& cfg, int h, const vector<bool>& inLoop) {
+    return h == 0 || code[h - 1].op == "goto" || !inLoop[cfg.blockOf(h - 1)];
+}
+
+// 循环不变量外提 (LICM)
+// 对每个自然循环 L，指令 d := x op y 可以外提的条件：
+//   - 无副作用（isPureOp），d 在 L 内只有这一处定值；
+//   - 操作数是常量、在 L 内没有定值的名称，或本轮已决定外提、地址更靠前的定值；
+//   - d 在循环头入口和 L 的各出口处都不活跃：循环内对 d 的引用只看到这次定值，
+//     提前计算不影响 break 或循环条件不成立时离开循环后看到的值；
+//   - 前置块在循环条件判断之前执行，即使循环一次都不执行也会计算，所以可能失败的运算
+//     （除法、float 的 + - * 可能溢出）只有所在块必然执行（支配所有出口和回边）时才外提。
+// 前置块插在循环头之前：循环外跳到头部的跳转（以及顺序落入）进入前置块，
+// 循环内跳回头部的回边和 continue 仍到循环头。每轮先处理内层循环，外提到内层前置块的
+// 指令位于外层循环体内，下一轮再判断能否继续外提到外层。
+int TACOptimizer::hoistLoopInvariants(vector<TAC>& code) {
+    int total = 0;
+    for (int round = 0; round < 64; round++) {
+        CFG cfg(code);
+        const vector<NaturalLoop>& loops = cfg.getLoops();
+        if (loops.empty()) break;
+        LivenessAnalysis liveness(cfg);
+        map<string, SlotType> types = inferNameTypes(code, varTypes);
+        auto isIntOperand = [&](const string& name) {
+            ConstVal c;
+            if (parseConst(name, c)) return !c.isFloat;
+            auto it = types.find(name);
+            return it != types.end() && it->second == SlotType::INT;
+        };
+        // 执行时不会出错的运算：比较、逻辑运算和类型转换总能求值，int 加减乘按补码回绕，
+        // int 除法要求除数是不为 0 和 -1 的常量；float 算术可能得到非有限结果
+        auto cannotFail = [&](const TAC& t) {
+            if (isFloatOp(t.op)) {
+                string op = scalarOp(t.op);
+                return op != "+" && op != "-" && op != "*" && op != "/";
+            }
+            if (t.op == "+" || t.op == "-" || t.op == "*") return isIntOperand(t.arg1) && isIntOperand(t.arg2);
+            if (t.op == "/") {
+                ConstVal c;
+                return isIntOperand(t.arg1) && parseConst(t.arg2, c) && !c.isFloat && c.i != 0 && c.i != -1;
+            }
+            return true;
+        };
+
+        // 内层循环先处理；本轮处理过的循环的外层要等下一轮看到新的前置块
+        vector<int> order = innermostFirst(loops);
+        vector<bool> blocked(loops.size(), false);
+        LoopEdits edits;
+        edits.removed.assign(code.size(), false);
+        vector<bool>& moved = edits.removed;
+
+        for (int k : order) {
+            if (blocked[k]) continue;
+            const NaturalLoop& loop = loops[k];
+            const vector<BasicBlock>& blocks = cfg.getBlocks();
+            int h = blocks[loop.header].start;
+            vector<bool> inLoop(cfg.size(), false);
+            for (int b : loop.blocks) inLoop[b] = true;
+            if (!canInsertPreheader(code, cfg, h, inLoop)) continue;
+
+            map<string, int> defCount;
+            vector<int> exitTargets, mustPass;    // 出口后继块；离开循环或回到头部前必经的块
+            for (int b : loop.blocks) {
+                for (int i = blocks[b].start; i < blocks[b].end; i++) {
+                    string d = defOf(code[i]);
+                    if (!d.empty()) defCount[d]++;
+                }
+                bool exiting = false;
+                for (int s : blocks[b].succ) {
+                    if (!inLoop[s]) { exitTargets.push_back(s); exiting = true; }
+                }
+                if (exiting) mustPass.push_back(b);
+            }
+            for (int b : loop.latches) mustPass.push_back(b);
+            auto alwaysRuns = [&](int b) {
+                for (int m : mustPass) if (!cfg.dominates(b, m)) return false;
+                return true;
+            };
+
+            map<string, int> hoistedAt;           // 决定外提的定值名 -> 地址
+            bool grew = true;
+            while (grew) {
+                grew = false;
+                for (int b : loop.blocks) {
+                    for (int i = blocks[b].start; i < blocks[b].end; i++) {
+                        const TAC& t = code[i];
+                        string d = defOf(t);
+                        if (moved[i] || d.empty() || !isPureOp(t.op) || defCount[d] != 1) continue;
+                        bool invariant = true;
+                        for (const auto& u : usesOf(t)) {
+                            auto hi = hoistedAt.find(u);
+                            if (defCount.count(u) && (hi == hoistedAt.end() || hi->second >= i)) invariant = false;
+                        }
+                        if (!invariant || liveness.liveAtBlockEntry(loop.header, d)) continue;
+                        bool liveAtExit = false;
+                        for (int s : exitTargets) if (liveness.liveAtBlockEntry(s, d)) liveAtExit = true;
+                        if (liveAtExit || (!cannotFail(t) && !alwaysRuns(b))) continue;
+                        moved[i] = true;
+                        hoistedAt[d] = i;
+                        grew = true;
+                    }
+                }
+            }
+            if (hoistedAt.empty()) continue;
+
+            vector<int> list;
+            for (const auto& kv : hoistedAt) list.push_back(kv.second);
+            sort(list.begin(), list.end());
+            for (int i : list) edits.preheader[h].push_back(code[i]);
+            edits.loopBlocks[h] = inLoop;
+            total += (int)list.size();
+            for (int p = loop.parent; p >= 0; p = loops[p].parent) blocked[p] = true;
+        }
+        if (edits.preheader.empty()) break;
+        applyLoopEdits(code, cfg, edits);
+    }
+    passStats["循环不变量外提"] += total;
+    return total;
+}
+
+// 循环内的定值统计与出口，供归纳变量分析使用
+struct LoopScan {
+    int header = 0;                 // 循环头地址
+    vector<bool> inLoop;            // 块是否属于循环
+    map<string, int> defCount;      // 名称 -> 循环内的定值次数
+    vector<int> exitTargets;        // 循环外的后继块
+};
+
+static LoopScan scanLoop(const vector<TAC>& code, const CFG& cfg, const NaturalLoop& loop) {
+    LoopScan scan;
+    const vector<BasicBlock>& blocks = cfg.getBlocks();
+    scan.header = blocks[loop.header].start;
+    scan.inLoop.assign(cfg.size(), false);
+    for (int b : loop.blocks) scan.inLoop[b] = true;
+    for (int b : loop.blocks) {
+        for (int i = blocks[b].start; i < blocks[b].end; i++) {
+            string d = defOf(code[i]);
+            if (!d.empty()) scan.defCount[d]++;
+        }
+        for (int s : blocks[b].succ) if (!scan.inLoop[s]) scan.exitTargets.push_back(s);
+    }
+    return scan;
+}
+
+static bool isIntName(const map<string, SlotType>& types, const string& name) {
+    ConstVal c;
+    if (parseConst(name, c)) return !c.isFloat;
+    auto it = types.find(name);
+    return it != types.end() && it->second == SlotType::INT;
+}
+
+static int maxTempIndex(const vector<TAC>& code) {
+    int top = 0;
+    for (const auto& t : code) {
+        for (const string* name : { &t.arg1, &t.arg2, &t.result }) {
+            if (isTempName(*name)) top = max(top, atoi(name->c_str() + 1));
+        }
+    }
+    return top;
+}
+
+// 加上补码回绕后的常量 delta：负数写成减法
+static TAC addConstant(const string& name, int delta) {
+    if (delta < 0 && delta != INT_MIN) return { "-", name, to_string(-delta), name, 0 };
+    return { "+", name, to_string(delta), name, 0 };
+}
+
+// 基本归纳变量 v 的一次更新：v := T（T := v ± c 在同一块内之前）或 v := v ± c
+struct IVUpdate {
+    int addr;       // 给 v 赋值的指令
+    int tempDef;    // T := v ± c 的地址，直接形式为 -1
+    int step;       // 每次更新加上的值（补码回绕）
+};
+
+// 基本归纳变量：int 变量在循环内的每个定值都是加减 int 常量
+static map<string, vector<IVUpdate>> findBasicIVs(const vector<TAC>& code, const CFG& cfg,
+                                                 const NaturalLoop& loop, const LoopScan& scan,
+                                                 const map<string, SlotType>& types) {
+    // t 是否为 v ± c，是则给出步长
+    auto stepOf = [&](const TAC& t, const string& v, int& step) {
+        ConstVal c;
+        if (t.op == "+" && t.arg1 == v && parseConst(t.arg2, c) && !c.isFloat) { step = c.i; return true; }
+        if (t.op == "+" && t.arg2 == v && parseConst(t.arg1, c) && !c.isFloat) { step = c.i; return true; }
+        if (t.op == "-" && t.arg1 == v && parseConst(t.arg2, c) && !c.isFloat) {
+            step = (int)(0u - (unsigned)c.i);
+            return true;
+        }
+        return false;
+    };
+    const vector<BasicBlock>& blocks = cfg.getBlocks();
+    map<string, vector<IVUpdate>> ivs;
+    set<string> rejected;
+    for (int b : loop.blocks) {
+        for (int i = blocks[b].start; i < blocks[b].end; i++) {
+            const TAC& t = code[i];
+            string v = defOf(t);
+            if (v.empty() || rejected.count(v)) continue;
+            IVUpdate u = { i, -1, 0 };
+            bool ok = isIntName(types, v) && stepOf(t, v, u.step);
+            if (!ok && t.op == ":=" && isTempName(t.arg1) && isIntName(types, v)) {
+                // T 可能被值编号与表达式中的 v ± c 共用，不一定紧挨着；其间 v 不能被重新定值
+                for (int j = i - 1; j >= blocks[b].start && defOf(code[j]) != v; j--) {
+                    if (code[j].result != t.arg1) continue;
+                    if (scan.defCount.at(t.arg1) != 1) break;
+                    u.tempDef = j;
+                    ok = stepOf(code[j], v, u.step);
+                    break;
+                }
+            }
+            if (ok) ivs[v].push_back(u);
+            else { rejected.insert(v); ivs.erase(v); }
+        }
+    }
+    return ivs;
+}
+
+// 导出归纳变量：值为 iv * mul + (循环不变量)，chain 是从 iv 算出它的指令（地址升序，最后一条是它自己）
+struct DerivedIV {
+    string iv;
+    int mul;
+    bool hasMul;
+    vector<int> chain;
+};
+
+// 强度削弱
+// 循环 L 内由基本归纳变量 i 经 + - * neg 与循环不变的 int 值算出的 d = i * m + a（m 来自乘以常量），
+// 在前置块中用 i 的初值算出 S := i * m + a，d 的计算改为 d := S，i 的每次更新 i := i + c 之后
+// 插入 S := S + c*m。int 运算按补码回绕，S 与 i * m + a 始终相等，与更新发生在循环的哪条路径上无关。
+// 链中每一步与下一步必须在同一基本块内、其间 i 没有更新，保证它们看到的是同一个 i。
+int TACOptimizer::reduceInductionVariables(vector<TAC>& code) {
+    int total = 0;
+    for (int round = 0; round < 64; round++) {
+        CFG cfg(code);
+        const vector<NaturalLoop>& loops = cfg.getLoops();
+        if (loops.empty()) break;
+        map<string, SlotType> types = inferNameTypes(code, varTypes);
+        map<string, int> useCount;
+        for (const auto& t : code) for (const auto& u : usesOf(t)) useCount[u]++;
+        int nextTemp = maxTempIndex(code) + 1;
+
+        vector<bool> blocked(loops.size(), false);
+        LoopEdits edits;
+        edits.removed.assign(code.size(), false);
+        map<int, TAC> replaced;
+        for (int k : innermostFirst(loops)) {
+            if (blocked[k]) continue;
+            const NaturalLoop& loop = loops[k];
+            LoopScan scan = scanLoop(code, cfg, loop);
+            if (!canInsertPreheader(code, cfg, scan.header, scan.inLoop)) continue;
+            map<string, vector<IVUpdate>> ivs = findBasicIVs(code, cfg, loop, scan, types);
+            if (ivs.empty()) continue;
+
+            auto invariant = [&](const string& name) {
+                return isIntName(types, name) && (isConstName(name) || !scan.defCount.count(name));
+            };
+            // 地址 a 之后、b 之前（同一块内）iv 是否被更新
+            auto updatedBetween = [&](const string& iv, int a, int b) {
+                for (const auto& u : ivs[iv]) if (u.addr > a && u.addr < b) return true;
+                return false;
+            };
+            map<string, DerivedIV> derived;
+            map<string, int> derivedUses;           // 被其他导出归纳变量引用的次数
+            const vector<BasicBlock>& blocks = cfg.getBlocks();
+            for (int b : loop.blocks) {
+                for (int i = blocks[b].start; i < blocks[b].end; i++) {
+                    const TAC& t = code[i];
+                    string d = defOf(t);
+                    if (d.empty() || ivs.count(d) || scan.defCount[d] != 1 || !isIntName(types, d)) continue;
+                    // 操作数作为导出归纳变量的形式
+                    auto formOf = [&](const string& x, DerivedIV& f) {
+                        if (ivs.count(x)) { f = { x, 1, false, {} }; return true; }
+                        auto it = derived.find(x);
+                        if (it == derived.end()) return false;
+                        int at = it->second.chain.back();
+                        if (cfg.blockOf(at) != b || updatedBetween(it->second.iv, at, i)) return false;
+                        f = it->second;
+                        return true;
+                    };
+                    DerivedIV f;
+                    ConstVal c;
+                    bool ok = false;
+                    if ((t.op == ":=" || t.op == "neg") && formOf(t.arg1, f)) {
+                        if (t.op == "neg") f.mul = (int)(0u - (unsigned)f.mul);
+                        ok = true;
+                    } else if (t.op == "+" || t.op == "-") {
+                        if (formOf(t.arg1, f) && invariant(t.arg2)) ok = true;
+                        else if (formOf(t.arg2, f) && invariant(t.arg1)) {
+                            if (t.op == "-") f.mul = (int)(0u - (unsigned)f.mul);
+                            ok = true;
+                        }
+                    } else if (t.op == "*") {
+                        if (formOf(t.arg1, f) && parseConst(t.arg2, c) && !c.isFloat) ok = true;
+                        else if (formOf(t.arg2, f) && parseConst(t.arg1, c) && !c.isFloat) ok = true;
+                        if (ok) {
+                            f.mul = (int)((unsigned)f.mul * (unsigned)c.i);
+                            f.hasMul = true;
+                        }
+                    }
+                    if (!ok) continue;
+                    for (const auto& u : usesOf(t)) if (derived.count(u)) derivedUses[u]++;
+                    f.chain.push_back(i);
+                    derived[d] = f;
+                }
+            }
+
+            // 只削弱链的末端：它的值被导出归纳变量以外的指令使用
+            int reducedHere = 0;
+            for (const auto& kv : derived) {
+                const DerivedIV& f = kv.second;
+                if (!f.hasMul || f.mul == 0 || useCount[kv.first] <= derivedUses[kv.first]) continue;
+                string s = "T" + to_string(nextTemp++);
+                map<string, string> rename;
+                for (int a : f.chain) {
+                    TAC t = code[a];
+                    if (rename.count(t.arg1)) t.arg1 = rename[t.arg1];
+                    if (rename.count(t.arg2)) t.arg2 = rename[t.arg2];
+                    string fresh = a == f.chain.back() ? s : "T" + to_string(nextTemp++);
+                    rename[t.result] = fresh;
+                    t.result = fresh;
+                    edits.preheader[scan.header].push_back(t);
+                }
+                int at = f.chain.back();
+                replaced[at] = { ":=", s, "", kv.first, at };
+                for (const auto& u : ivs[f.iv]) {
+                    edits.after[u.addr].push_back(addConstant(s, (int)((unsigned)u.step * (unsigned)f.mul)));
+                }
+                reducedHere++;
+            }
+            if (reducedHere == 0) continue;
+            edits.loopBlocks[scan.header] = scan.inLoop;
+            total += reducedHere;
+            for (int p = loop.parent; p >= 0; p = loops[p].parent) blocked[p] = true;
+        }
+        if (replaced.empty()) break;
+        for (const auto& kv : replaced) code[kv.first] = kv.second;
+        applyLoopEdits(code, cfg, edits);
+    }
+    passStats["归纳变量强度削弱"] += total;
+    return total;
+}
+
+// 归纳变量消去
+// 基本归纳变量 v 离开循环后不再活跃，循环内除自身更新外只出现在与循环不变量的比较中；
+// 若另有基本归纳变量 w 与它步长相同、在同一基本块内各更新一次，则 v - w 在循环内不变：
+// 前置块计算 D := v - w，比较中的 v 改为 w + D（补码回绕下与 v 完全相等），删除 v 的更新。
+// 比较若位于两次更新之间（只有一个已更新）则不能改写。
+int TACOptimizer::eliminateInductionVariables(vector<TAC>& code) {
+    int total = 0;
+    for (int round = 0; round < 64; round++) {
+        CFG cfg(code);
+        const vector<NaturalLoop>& loops = cfg.getLoops();
+        if (loops.empty()) break;
+        LivenessAnalysis liveness(cfg);
+        map<string, SlotType> types = inferNameTypes(code, varTypes);
+        map<string, int> useCount;
+        for (const auto& t : code) for (const auto& u : usesOf(t)) useCount[u]++;
+        int nextTemp = maxTempIndex(code) + 1;
+
+        vector<bool> blocked(loops.size(), false);
+        LoopEdits edits;
+        edits.removed.assign(code.size(), false);
+        map<int, TAC> replaced;
+        for (int k : innermostFirst(loops)) {
+            if (blocked[k]) continue;
+            const NaturalLoop& loop = loops[k];
+            LoopScan scan = scanLoop(code, cfg, loop);
+            if (!canInsertPreheader(code, cfg, scan.header, scan.inLoop)) continue;
+            map<string, vector<IVUpdate>> ivs = findBasicIVs(code, cfg, loop, scan, types);
+            const vector<BasicBlock>& blocks = cfg.getBlocks();
+
+            set<string> kept, gone;             // 作为替代者的归纳变量不能再被消去，已消去的不能作替代者
+            int eliminatedHere = 0;
+            for (const auto& kv : ivs) {
+                const string& v = kv.first;
+                if (kv.second.size() != 1 || kept.count(v)) continue;
+                const IVUpdate& uv = kv.second[0];
+                bool live = false;
+                for (int s : scan.exitTargets) if (liveness.liveAtBlockEntry(s, v)) live = true;
+                if (live) continue;
+                if (uv.tempDef >= 0 && useCount[code[uv.tempDef].result] != 1) continue;
+
+                // 循环内对 v 的其他引用只能是与循环不变量的比较
+                vector<int> compares;
+                bool onlyCompares = true;
+                for (int b : loop.blocks) {
+                    for (int i = blocks[b].start; i < blocks[b].end && onlyCompares; i++) {
+                        const TAC& t = code[i];
+                        if (i == uv.addr || i == uv.tempDef) continue;
+                        vector<string> uses = usesOf(t);
+                        if (find(uses.begin(), uses.end(), v) == uses.end()) continue;
+                        static const set<string> relops = { "<", "<=", ">", ">=", "==", "!=" };
+                        const string& other = t.arg1 == v ? t.arg2 : t.arg1;
+                        if (!relops.count(t.op) || other == v || !isIntName(types, other) ||
+                            (!isConstName(other) && scan.defCount.count(other))) {
+                            onlyCompares = false;
+                        } else {
+                            compares.push_back(i);
+                        }
+                    }
+                }
+                if (!onlyCompares || compares.empty()) continue;
+
+                // 同步变化的替代者
+                string w;
+                for (const auto& cand : ivs) {
+                    if (cand.first == v || gone.count(cand.first) || cand.second.size() != 1) continue;
+                    const IVUpdate& uw = cand.second[0];
+                    if (uw.step != uv.step || cfg.blockOf(uw.addr) != cfg.blockOf(uv.addr)) continue;
+                    bool inPhase = true;
+                    for (int q : compares) {
+                        if (cfg.blockOf(q) == cfg.blockOf(uv.addr) && (q > uv.addr) != (q > uw.addr)) inPhase = false;
+                    }
+                    if (inPhase) { w = cand.first; break; }
+                }
+                if (w.empty()) continue;
+
+                string diff = "T" + to_string(nextTemp++);
+                edits.preheader[scan.header].push_back({ "-", v, w, diff, 0 });
+                for (int q : compares) {
+                    string value = "T" + to_string(nextTemp++);
+                    edits.before[q].push_back({ "+", w, diff, value, 0 });
+                    TAC t = code[q];
+                    if (t.arg1 == v) t.arg1 = value;
+                    if (t.arg2 == v) t.arg2 = value;
+                    replaced[q] = t;
+                }
+                edits.removed[uv.addr] = true;
+                if (uv.tempDef >= 0) edits.removed[uv.tempDef] = true;
+                kept.insert(w);
+                gone.insert(v);
+                eliminatedHere++;
+            }
+            if (eliminatedHere == 0) continue;
+            edits.loopBlocks[scan.header] = scan.inLoop;
+            total += eliminatedHere;
+            for (int p = loop.parent; p >= 0; p = loops[p].parent) blocked[p] = true;
+        }
+        if (replaced.empty()) break;
+        for (const auto& kv : replaced) code[kv.first] = kv.second;
+        applyLoopEdits(code, cfg, edits);
+    }
+    passStats["归纳变量消去"] += total;
+    return total;
+}
+
+// 识别 CodeGenerator::exitLoop 生成的循环形状：
+//   H:  条件计算（无跳转）             H:  条件计算
+//       jz T Lexit                        jz T Lexit        ; 守卫，只执行一次
+//       循环体                    =>  B:  循环体
+//       goto H                        H': 条件计算（复制）  ; continue 改跳到这里
+//   exit:                                 jnz T B           ; 唯一的回边
+//                                     exit:
+// 每次迭代从 jz + goto 两次跳转减少为一次 jnz。
+int TACOptimizer::rotateLoops(vector<TAC>& code) {
+    int rotated = 0;
+    bool found = true;
+    while (found) {
+        found = false;
+        int n = (int)code.size();
+        vector<int> targetCount(n + 1, 0);
+        for (const auto& t : code) {
+            int target = labelAddr(t.result);
+            if (isJumpOp(t.op) && target >= 0 && target <= n) targetCount[target]++;
+        }
+
+        for (int e = 0; e < n && !found; e++) {
+            if (code[e].op != "goto") continue;
+            int h = labelAddr(code[e].result);
+            if (h < 0 || h >= e) continue;
+            // 找到头部的条件跳转，条件计算部分不能含跳转或被跳入
+            int c = h;
+            while (c < e && !isJumpOp(code[c].op)) c++;
+            if (c >= e || code[c].op != "jz" || labelAddr(code[c].result) != e + 1) continue;
+            bool clean = true;
+            for (int k = h + 1; k <= c; k++) if (targetCount[k] > 0) clean = false;
+            if (!clean) continue;
+
+            // 新序列：[0, e) + 条件复制 + jnz + (e, n)，原地址 e 及之后整体后移 k 位
+            int k = c - h;  // 复制的条件计算指令数
+            auto remap = [&](int addr, int from) {
+                if (addr <= e) {
+                    // 循环内部跳回头部的（continue）改到底部的条件计算
+                    if (addr == h && from > h && from <= e) return e;
+                    return addr;
+                }
+                return addr + k;
+            };
+            vector<TAC> out;
+            out.reserve(n + k);
+            for (int i = 0; i < n; i++) {
+                if (i == e) {
+                    for (int j = h; j < c; j++) out.push_back(code[j]);
+                    out.push_back({ "jnz", code[c].arg1, "", makeLabel(c + 1), 0 });
+                    continue;
+                }
+                TAC t = code[i];
+                int target = labelAddr(t.result);
+                if (isJumpOp(t.op) && target >= 0) t.result = makeLabel(remap(target, i));
+                out.push_back(t);
+            }
+            for (int i = 0; i < (int)out.size(); i++) out[i].addr = i;
+            code.swap(out);
+            rotated++;
+            found = true;
+        }
+    }
+    passStats["循环旋转"] += rotated;
+    return rotated;
+}
+
+int TACOptimizer::countTemps(const vector<TAC>& code) {
+    set<string> temps;
+    for (const auto& t : code) {
+        string d = defOf(t);
+        if (isTempName(d)) temps.insert(d);
+        for (const auto& u : usesOf(t)) if (isTempName(u)) temps.insert(u);
+    }
+    return (int)temps.size();
+}
+
+// 临时变量的活跃区间取它定值或活跃的所有位置的最小覆盖区间（保守），
+// 按起点排序线性扫描：区间已结束的槽位可以分配给后面的临时变量。
+// 任意一处同时活跃的两个临时变量区间必然重叠，因此合并后语义不变。
+int TACOptimizer::reuseTemps(vector<TAC>& code) {
+    CFG cfg(code);
+    LivenessAnalysis liveness(cfg);
+    vector<BitVector> liveOut = liveness.liveOutPerInstruction();
+    map<string, pair<int, int>> range;
+    auto extend = [&](const string& name, int pos) {
+        if (!isTempName(name)) return;
+        auto it = range.find(name);
+        if (it == range.end()) range[name] = make_pair(pos, pos);
+        else {
+            it->second.first = min(it->second.first, pos);
+            it->second.second = max(it->second.second, pos);
+        }
+    };
+    for (int i = 0; i < (int)code.size(); i++) {
+        extend(defOf(code[i]), i);
+        for (const auto& u : usesOf(code[i])) extend(u, i);
+        for (int bit = liveOut[i].findNext(0); bit >= 0; bit = liveOut[i].findNext(bit + 1)) {
+            extend(liveness.nameOf(bit), i);
+        }
+    }
+
+    vector<pair<pair<int, int>, string>> intervals;
+    for (const auto& kv : range) intervals.push_back(make_pair(kv.second, kv.first));
+    sort(intervals.begin(), intervals.end());
+
+    map<string, string> rename;
+    vector<int> slotEnd;  // 每个槽位当前占用区间的终点
+    for (const auto& iv : intervals) {
+        int slot = -1;
+        for (int k = 0; k < (int)slotEnd.size(); k++) {
+            if (slotEnd[k] < iv.first.first) { slot = k; break; }
+        }
+        if (slot < 0) { slot = (int)slotEnd.size(); slotEnd.push_back(0); }
+        slotEnd[slot] = iv.first.second;
+        rename[iv.second] = "T" + to_string(slot + 1);
+    }
+
+    for (auto& t : code) {
+        if (rename.count(t.arg1)) t.arg1 = rename[t.arg1];
+        if (rename.count(t.arg2)) t.arg2 = rename[t.arg2];
+        if (!isJumpOp(t.op) && rename.count(t.result)) t.result = rename[t.result];
+    }
+    return (int)slotEnd.size();
+}
+
+int TACOptimizer::countLoopInstructions(const vector<TAC>& code) {
+    vector<bool> inLoop(code.size(), false);
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!isJumpOp(code[i].op)) continue;
+        int target = labelAddr(code[i].result);
+        if (target < 0 || target > (int)i) continue;  // 只有回边界定循环
+        for (size_t k = target; k <= i; k++) inLoop[k] = true;
+    }
+    int n = 0;
+    for (bool b : inLoop) if (b) n++;
+    return n;
+}
+
+void TACOptimizer::runScalarPasses(vector<TAC>& code) {
+    // 各遍相互提供机会（折叠产生新的常量，删除改变基本块），迭代到不动点
+    for (int round = 0; round < 16; round++) {
+        int changes = valueNumbering(code);
+        changes += propagateAndFold(code);
+        changes += removeUnusedTemps(code);
+        changes += eliminateDeadCode(code);
+        if (changes == 0) break;
+    }
+}
+
+int TACOptimizer::runSSAPasses(vector<TAC>& code) {
+    SSAForm ssa(code, varTypes);
+    if (!ssa.isValid()) return 0;
+    int changes = ssa.propagateConstants();
+    changes += ssa.eliminateDeadCode();
+    if (changes == 0) return 0;
+    vector<TAC> out;
+    bool ok = ssa.destruct(out);
+    for (const auto& kv : ssa.getStats()) passStats[kv.first] += kv.second;
+    if (!ok) return 0;
+    code = out;
+    return changes;
+}
+
+vector<TAC> TACOptimizer::optimize(const vector<TAC>& input) {
+    vector<TAC> code = input;
+    passStats.clear();
+    beforeCount = (int)code.size();
+    loopBefore = countLoopInstructions(code);
+    tempsBefore = countTemps(code);
+
+    runScalarPasses(code);
+    // 跨基本块的常量传播与死代码删除（条件为常量的分支整段删除），之后块内各遍再清理一次
+    if (runSSAPasses(code) > 0) runScalarPasses(code);
+    // 循环不变量外提在旋转之前进行，此时循环仍是顶部判断的形状，前置块位于条件判断之前
+    // 强度削弱在外提之后，此时循环不变的子表达式已经是循环内没有定值的名字；
+    // 消去要等块内各遍删掉削弱后不再使用的乘法，归纳变量的引用才只剩比较
+    int loopChanges = hoistLoopInvariants(code);
+    loopChanges += reduceInductionVariables(code);
+    if (loopChanges > 0) runScalarPasses(code);
+    if (eliminateInductionVariables(code) > 0) {
+        loopChanges++;
+        runScalarPasses(code);
+    }
+    // 前置块中的复写跨越基本块，块内各遍处理不到，再交给 SSA 合并
+    if (loopChanges > 0 && runSSAPasses(code) > 0) runScalarPasses(code);
+
+    // 控制流整理：穿透 goto 链、删除不可达代码后旋转循环，再对新形状做一轮块内优化
+    threadJumps(code);
+    removeUnreachable(code);
+    if (rotateLoops(code) > 0) {
+        threadJumps(code);
+        removeUnreachable(code);
+        runScalarPasses(code);
+    }
+
+    // 窥孔优化清理各遍留下的局部形状（跳到下一条的跳转、经临时变量的复写等）；
+    // 它依赖临时变量只定值一次，放在临时变量合并之前
+    PeepholeOptimizer peephole;
+    peephole.run(code);
+    for (const auto& kv : peephole.getFired()) passStats["窥孔 " + kv.first] += kv.second;
+
+    // 临时变量合并会让同一个名字被多次定值，必须放在所有依赖单次定值的遍之后
+    tempsAfter = reuseTemps(code);
+
+    afterCount = (int)code.size();
+    loopAfter = countLoopInstructions(code);
+    return code;
+}
+
+void TACOptimizer::printReport(OutputSink& out) const {
+    out << "\n--- 优化统计 ---\n";
+    int saved = beforeCount - afterCount;
+    double pct = beforeCount > 0 ? 100.0 * saved / beforeCount : 0.0;
+    out << "指令数: " << beforeCount << " -> " << afterCount
+        << " (减少 " << saved << " 条, " << fixedPoint(pct, 1) << "%)\n";
+    out << "循环体内指令数: " << loopBefore << " -> " << loopAfter << '\n';
+    out << "临时变量数: " << tempsBefore << " -> " << tempsAfter << '\n';
+    for (const auto& kv : passStats) {
+        if (kv.second == 0) continue;
+        out << "  " << kv.first << ": " << kv.second << '\n';
+    }
+}
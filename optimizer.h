@@ -0,0 +1,70 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "types.h"
+#include "outsink.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === 三地址码优化器 ===
+// 在 CodeGenerator 生成完整的三地址码之后运行，输入输出都是 vector<TAC>
+
+class TACOptimizer {
+private:
+    map<string, string> varTypes;   // 显式声明的变量类型（变量名 -> "int"/"float"）
+    map<string, int> passStats;     // 各优化动作的触发次数
+    int beforeCount = 0, afterCount = 0;
+    int loopBefore = 0, loopAfter = 0;  // 循环体内的指令数
+    int tempsBefore = 0, tempsAfter = 0;  // 不同临时变量名的个数
+
+    // 变量是否为声明过的 float / int
+    bool isDeclared(const string& name) const { return varTypes.count(name) > 0; }
+    bool isFloatVar(const string& name) const;
+
+    // 基本块内基于哈希的局部值编号：重复计算改写为复写，返回改写条数
+    int valueNumbering(vector<TAC>& code);
+    // 基本块内的常量折叠、常量传播与复写传播，返回改动次数
+    int propagateAndFold(vector<TAC>& code);
+    // 删除从未被引用的临时变量的定值，返回删除条数
+    int removeUnusedTemps(vector<TAC>& code);
+
+    // 跳转穿透：目标是无条件 goto 的跳转直接改到最终目标，返回改动条数
+    int threadJumps(vector<TAC>& code);
+    // 删除从入口不可达的基本块（如 break 之后的语句），返回删除条数
+    int removeUnreachable(vector<TAC>& code);
+    // 循环不变量外提：把循环内不变且无副作用的计算移到循环判断之前新建的前置块，由内向外，返回外提条数
+    int hoistLoopInvariants(vector<TAC>& code);
+    // 归纳变量强度削弱：由基本归纳变量经乘法线性导出的 int 值改为随每次更新做加法，返回削弱个数
+    int reduceInductionVariables(vector<TAC>& code);
+    // 归纳变量消去：只用于循环条件判断、离开循环后不再使用的归纳变量改由同步变化的另一个归纳变量表示，
+    // 删除它的更新，返回消去个数
+    int eliminateInductionVariables(vector<TAC>& code);
+    // 循环旋转：顶部判断 + 底部 goto 的 while 循环改为带守卫的 do-while，返回旋转的循环数
+    int rotateLoops(vector<TAC>& code);
+    // 反复运行基本块内的各遍直到不动点
+    void runScalarPasses(vector<TAC>& code);
+    // 构造 SSA，运行稀疏条件常量传播与 SSA 死代码删除后转回三地址码，返回改动次数
+    int runSSAPasses(vector<TAC>& code);
+
+    // 基于活跃变量分析删除定值后不再活跃的赋值（死代码），返回删除条数
+    int eliminateDeadCode(vector<TAC>& code);
+    // 按活跃区间线性扫描，把互不重叠的临时变量合并到同一个名字
+    int reuseTemps(vector<TAC>& code);
+    static int countTemps(const vector<TAC>& code);
+
+    // 统计位于循环（回边覆盖区间）内的指令数
+    static int countLoopInstructions(const vector<TAC>& code);
+
+public:
+    explicit TACOptimizer(const map<string, string>& varTypes);
+
+    // 运行全部优化遍直到不动点，返回优化后的代码
+    vector<TAC> optimize(const vector<TAC>& code);
+
+    // 输出指令数变化和各优化动作的统计
+    void printReport(OutputSink& out) const;
+    const map<string, int>& getPassStats() const { return passStats; }
+};
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,152 @@
+#include "outsink.h"
+#include <iostream>
+#include <cstring>
+
+using namespace std;
+
+OutputSink::OutputSink() : target(Target::CONSOLE), buffer(BUFFER_SIZE) {}
+
+OutputSink::OutputSink(const string& path) : target(Target::FILE), buffer(BUFFER_SIZE) {
+    file = fopen(path.c_str(), "wb");
+    if (!file) failed = true;
+    else setvbuf(file, nullptr, _IONBF, 0);     // 已经整块写入，不再经过 stdio 的缓冲
+}
+
+OutputSink::OutputSink(string& target) : target(Target::STRING), text(&target), buffer(BUFFER_SIZE) {}
+
+OutputSink::~OutputSink() {
+    flush();
+    if (file) fclose(file);
+}
+
+OutputSink& OutputSink::console() {
+    static OutputSink sink;
+    return sink;
+}
+
+void OutputSink::send(const char* data, size_t n) {
+    switch (target) {
+    case Target::CONSOLE:
+        // 写入 cout 当前的缓冲区：基准程序把 cout 重定向到字符串流来丢弃编译输出
+        if (cout.rdbuf()->sputn(data, (streamsize)n) != (streamsize)n) failed = true;
+        break;
+    case Target::FILE:
+        if (file && fwrite(data, 1, n, file) != n) failed = true;
+        break;
+    case Target::STRING:
+        text->append(data, n);
+        break;
+    }
+}
+
+void OutputSink::flush() {
+    if (used > 0) send(buffer.data(), used);
+    used = 0;
+    if (target == Target::CONSOLE) cout.flush();
+}
+
+OutputSink& OutputSink::write(const char* data, size_t n) {
+    if (used + n > buffer.size()) {
+        if (used > 0) send(buffer.data(), used);
+        used = 0;
+        if (n > buffer.size()) {
+            send(data, n);      // 大块内容（如生成的 C 源码）不经过缓冲区
+            return *this;
+        }
+    }
+    memcpy(buffer.data() + used, data, n);
+    used += n;
+    return *this;
+}
+
+OutputSink& OutputSink::operator<<(const char* s) {
+    return write(s, strlen(s));
+}
+
+OutputSink& OutputSink::operator<<(char c) {
+    if (used == buffer.size()) flush();
+    buffer[used++] = c;
+    return *this;
+}
+
+int OutputSink::formatUnsigned(unsigned long long v, char* end) {
+    char* p = end;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    return (int)(end - p);
+}
+
+int OutputSink::formatInt(long long v, char* end) {
+    // 取绝对值时按无符号计算，LLONG_MIN 也不会溢出
+    unsigned long long magnitude = v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v;
+    int n = formatUnsigned(magnitude, end);
+    if (v < 0) *(end - ++n) = '-';
+    return n;
+}
+
+OutputSink& OutputSink::writeUnsigned(unsigned long long v) {
+    char digits[24];
+    int n = formatUnsigned(v, digits + sizeof digits);
+    return write(digits + sizeof digits - n, n);
+}
+
+OutputSink& OutputSink::writeInt(long long v) {
+    char digits[24];
+    int n = formatInt(v, digits + sizeof digits);
+    return write(digits + sizeof digits - n, n);
+}
+
+OutputSink& OutputSink::spaces(int n) {
+    static const char blanks[] = "                                ";
+    while (n > 0) {
+        int k = n < 32 ? n : 32;
+        write(blanks, k);
+        n -= k;
+    }
+    return *this;
+}
+
+PadField pad(const string& s, int width) {
+    PadField f;
+    f.str = s.data();
+    f.size = s.size();
+    f.width = width;
+    return f;
+}
+
+PadField pad(long long v, int width) {
+    PadField f;
+    f.size = OutputSink::formatInt(v, f.digits + sizeof f.digits);
+    f.width = width;
+    return f;
+}
+
+PadField padRight(long long v, int width) {
+    PadField f = pad(v, width);
+    f.alignRight = true;
+    return f;
+}
+
+OutputSink& OutputSink::operator<<(const PadField& f) {
+    // 整数字段的数字在 digits 末尾（字段按值传递，不能保存指向自身的指针）
+    const char* data = f.str ? f.str : f.digits + sizeof f.digits - f.size;
+    int fill = f.width - (int)f.size;
+    if (f.alignRight) spaces(fill);
+    write(data, f.size);
+    if (!f.alignRight) spaces(fill);
+    return *this;
+}
+
+OutputSink& OutputSink::operator<<(const FixedField& f) {
+    char digits[64];
+    int n = snprintf(digits, sizeof digits, "%.*f", f.precision, f.value);
+    if (n < 0) return *this;
+    if (n >= (int)sizeof digits) {
+        string wide(n + 1, '\0');
+        snprintf(&wide[0], wide.size(), "%.*f", f.precision, f.value);
+        return write(wide.data(), n);
+    }
+    return write(digits, n);
+}
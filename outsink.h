@@ -0,0 +1,92 @@
+#ifndef OUTSINK_H
+#define OUTSINK_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// === 缓冲输出 ===
+// 编译器各阶段的输出（词法表、分析过程、三地址码、诊断信息）统一写入 OutputSink：
+//   - 写入先进 64KB 的缓冲区，满了或 flush() 时才整块交给目标，不按行刷新；
+//   - 定宽补齐和整数格式化手工完成，不经过 iostream 的格式状态和 locale；
+//   - 目标可以是控制台（cout 当前的缓冲区，保留调用方的重定向）、文件或内存中的字符串。
+// out << pad(x, w) / padRight(x, w) 与 cout << left/right << setw(w) << x 相同：按字节数补空格，超长时不截断；
+// out << fixedPoint(v, p) 与 cout << fixed << setprecision(p) << v 相同。
+
+// 定宽字段，字符串引用调用方的内容，整数格式化在字段自己的缓冲区中
+struct PadField {
+    const char* str = nullptr;
+    size_t size = 0;
+    int width = 0;
+    bool alignRight = false;
+    char digits[24];
+};
+
+PadField pad(const string& s, int width);
+PadField pad(long long v, int width);
+PadField padRight(long long v, int width);
+
+struct FixedField {
+    double value;
+    int precision;
+};
+
+inline FixedField fixedPoint(double value, int precision) { return FixedField{ value, precision }; }
+
+class OutputSink {
+public:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    OutputSink();                               // 控制台
+    explicit OutputSink(const string& path);    // 文件（覆盖写入），打开失败时 ok() 为 false
+    explicit OutputSink(string& target);        // 追加到内存中的字符串
+    ~OutputSink();
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // 进程共用的控制台输出
+    static OutputSink& console();
+
+    OutputSink& operator<<(const string& s) { return write(s.data(), s.size()); }
+    OutputSink& operator<<(const char* s);
+    OutputSink& operator<<(char c);
+    OutputSink& operator<<(int v) { return writeInt(v); }
+    OutputSink& operator<<(long v) { return writeInt(v); }
+    OutputSink& operator<<(long long v) { return writeInt(v); }
+    OutputSink& operator<<(unsigned v) { return writeUnsigned(v); }
+    OutputSink& operator<<(unsigned long v) { return writeUnsigned(v); }
+    OutputSink& operator<<(unsigned long long v) { return writeUnsigned(v); }
+
+    OutputSink& operator<<(const PadField& f);
+    OutputSink& operator<<(const FixedField& f);
+
+    OutputSink& write(const char* data, size_t n);
+
+    void flush();
+    bool ok() const { return !failed; }
+
+private:
+    enum class Target { CONSOLE, FILE, STRING };
+    Target target;
+    FILE* file = nullptr;
+    string* text = nullptr;
+    vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+
+    void send(const char* data, size_t n);     // 交给目标，不经过缓冲区
+    OutputSink& writeInt(long long v);
+    OutputSink& writeUnsigned(unsigned long long v);
+    OutputSink& spaces(int n);
+
+    friend PadField pad(long long v, int width);
+    friend PadField padRight(long long v, int width);
+    // 从 end 往前写数字，返回字符数
+    static int formatUnsigned(unsigned long long v, char* end);
+    static int formatInt(long long v, char* end);
+};
+
+#endif // OUTSINK_H
@@ -1,25 +1,30 @@
 #include "parser.h"
+#include "arena.h"
 #include <fstream>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
 using namespace std;
 
 // Parser构造函数，初始化语法分析器
 // 步骤:
-//   1. 定义所有产生式规则（46个产生式）
+//   1. 定义所有产生式规则（47个产生式）
 //   2. 构建非终结符集合 Vn 和终结符集合 Vt
 //   3. 计算所有非终结符的 First 集合
 //   4. 构建 LR(1) 分析表
-Parser::Parser() {
+//   5. 需要时把项目集族和分析表写入 items.txt、table.csv（之后不再保留项目集族）
+Parser::Parser(Stats* stats, bool saveFiles) : stats(stats) {
+    ScopedTimer timer(stats, "parser.build", "parser");
     // 定义所有产生式规则
     // 产生式编号从0开始，0是增广产生式S'->B
     productions = {
         {0, "S'", {"B"}},
         {1, "A", {"while", "(", "L", ")", "M", "{", "B", "}"}}, 
-        {2, "L", {"L", "||", "M1"}}, // L是逻辑或表达式，左递归L||M1实现左结合
+        {2, "L", {"L", "||", "K", "M1"}}, // L是逻辑或表达式，左递归L||M1实现左结合
         {3, "L", {"M1"}}, 
-        {4, "M1", {"M1", "&&", "N"}}, // M1是逻辑与表达式，左递归M1&&N实现左结合
+        {4, "M1", {"M1", "&&", "K", "N"}}, // M1是逻辑与表达式，左递归M1&&N实现左结合
         {5, "M1", {"N"}}, //N是逻辑基本单元
         {6, "N", {"!", "N"}}, //逻辑非
         {7, "N", {"C"}}, //关系运算
@@ -56,7 +61,8 @@ Parser::Parser() {
         {42, "S", {"float", "i", "=", "E"}},
         {43, "G", {"true"}}, //布尔常量
         {44, "G", {"false"}},
-        {45, "N", {"G"}} //基本单元
+        {45, "N", {"G"}}, //基本单元
+        {46, "K", {}} //用于&&/||短路跳转回填，空产生式
     };
 
     // 构建Vn和Vt，同时保持顺序
@@ -80,9 +86,18 @@ Parser::Parser() {
     }
 
     // 计算所有非终结符的First集合
-    computeFirst();
+    {
+        ScopedTimer firstTimer(stats, "parser.first", "parser");
+        computeFirst();
+    }
     // 构建LR(1)分析表
-    buildLR1Table();
+    buildLR1Table(saveFiles);
+    if (saveFiles) {
+        ScopedTimer saveTimer(stats, "parser.save_files", "parser");
+        saveItemsToFile("items.txt");
+        saveTableToCSV("table.csv");
+        vector<vector<LR1Item>>().swap(states);    // 项目集只用于写文件，写完释放
+    }
 }
 
 //计算First集合
@@ -108,98 +123,279 @@ void Parser::computeFirst() {
     }
 }
 
-set<string> Parser::getFirst(const vector<string>& symbols) {
-    set<string> res;
-    for (const auto& s : symbols) {
-        if (Vt.count(s)) { res.insert(s); return res; }
-        bool hasEpsilon = false;
-        if (firstSets.count(s)) {
-            for (const auto& f : firstSets[s]) {
-                if (f == "epsilon") hasEpsilon = true;
-                else res.insert(f);
+// ============================================================================
+// LR(1) 分析表构造
+// ============================================================================
+// 构造期间的项目用紧凑形式：产生式编号、点位置和向前看符号位集（按终结符的字典序编号，
+// 逐位遍历即得到与 set<string> 相同的顺序）。
+// 状态的去重按转移核心进行：goto 得到的核心项目点位置都大于 0，闭包加入的项目点位置都为 0，
+// 两个闭包相同当且仅当核心相同，所以先用核心查散列表，命中时不必再求闭包。
+// 每个状态的所有 goto 核心、闭包和中间位集都分配在临时区，处理完一个转移就整体重置；
+// 新状态在临时区求出闭包后复制进持久区，最后一次性转换成 states。
+
+struct CompactItem {
+    int prodId;
+    int dotPos;
+    uint64_t* lookahead;
+};
+
+struct Parser::TableBuilder {
+    struct State {
+        CompactItem* items;
+        int size;
+        int kernelSize;
+        uint64_t hash;      // 核心的散列值
+    };
+
+    Parser& parser;
+    Arena persistent;       // 保留的项目集、各 LR(0) 项目的 First 位集
+    Arena scratch;          // 转移核心、闭包、临时位集
+    int words = 0;          // 每个位集的 64 位字数
+
+    vector<string> symbolNames;     // 全部文法符号，按字典序编号
+    vector<int> terminalIndex;      // 符号编号 -> 终结符位号，非终结符为 -1
+    vector<string> terminalNames;   // 终结符位号 -> 名字
+    vector<vector<int>> rhs;        // 各产生式右部的符号编号
+    vector<vector<int>> prodsOf;    // 非终结符编号 -> 以它为左部的产生式编号
+    vector<int> itemBase;           // LR(0) 项目 (p, d) 的编号为 itemBase[p] + d
+    int lr0Count = 0;
+    // LR(0) 项目 A -> α . X β 的 First(β) 位集，以及 β 能否推出空串
+    vector<uint64_t*> betaFirst;
+    vector<char> betaNullable;
+
+    vector<State> states;
+    vector<int> slots;              // 开放寻址散列表：核心散列值 -> 状态编号，-1 为空
+
+    explicit TableBuilder(Parser& parser) : parser(parser), persistent(256 * 1024), scratch(64 * 1024) {}
+
+    uint64_t* newBits(Arena& arena) {
+        uint64_t* bits = arena.allocArray<uint64_t>(words);
+        memset(bits, 0, words * sizeof(uint64_t));
+        return bits;
+    }
+
+    void setup() {
+        set<string> all(parser.Vn.begin(), parser.Vn.end());
+        all.insert(parser.Vt.begin(), parser.Vt.end());
+        map<string, int> symbolId;
+        for (const auto& name : all) {
+            symbolId[name] = (int)symbolNames.size();
+            symbolNames.push_back(name);
+            if (parser.Vt.count(name)) {
+                terminalIndex.push_back((int)terminalNames.size());
+                terminalNames.push_back(name);
+            } else {
+                terminalIndex.push_back(-1);
             }
         }
-        if (!hasEpsilon) return res;
-    }
-    return res;
-}
+        words = ((int)terminalNames.size() + 63) / 64;
 
-//计算LR(1)项目集的闭包
-vector<LR1Item> Parser::getClosure(vector<LR1Item> items) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (int i = 0; i < (int)items.size(); i++) {
-            LR1Item cur = items[i]; //当前项目
-            if (cur.dotPos >= (int)productions[cur.prodId].right.size()) continue;
-            string B = productions[cur.prodId].right[cur.dotPos]; 
-            if (Vn.count(B)) {
-                vector<string> beta; //β：当前项目中的非终结符后面的符号串
-                for (int k = cur.dotPos + 1; k < (int)productions[cur.prodId].right.size(); k++)
-                    beta.push_back(productions[cur.prodId].right[k]);
-                set<string> nextLookahead; //当前项目中的展望符集合
-                // 计算新的展望符
-                for (auto& la : cur.lookahead) {
-                    vector<string> betaLa = beta; betaLa.push_back(la);
-                    set<string> f = getFirst(betaLa);
-                    for (auto& s : f) nextLookahead.insert(s);
+        prodsOf.resize(symbolNames.size());
+        for (const auto& p : parser.productions) {
+            vector<int> r;
+            for (const auto& s : p.right) r.push_back(symbolId.at(s));
+            rhs.push_back(r);
+            prodsOf[symbolId.at(p.left)].push_back(p.id);
+            itemBase.push_back(lr0Count);
+            lr0Count += (int)p.right.size() + 1;
+        }
+
+        // 非终结符的 First 位集，含 epsilon 的记为可空
+        vector<uint64_t*> first(symbolNames.size(), nullptr);
+        vector<char> nullable(symbolNames.size(), 0);
+        for (size_t x = 0; x < symbolNames.size(); x++) {
+            if (terminalIndex[x] >= 0) continue;
+            first[x] = newBits(persistent);
+            auto it = parser.firstSets.find(symbolNames[x]);
+            if (it == parser.firstSets.end()) continue;
+            for (const auto& s : it->second) {
+                if (s == "epsilon") nullable[x] = 1;
+                else {
+                    int t = terminalIndex[symbolId.at(s)];
+                    first[x][t / 64] |= 1ULL << (t % 64);
+                }
+            }
+        }
+        betaFirst.assign(lr0Count, nullptr);
+        betaNullable.assign(lr0Count, 0);
+        for (size_t p = 0; p < rhs.size(); p++) {
+            for (size_t d = 0; d < rhs[p].size(); d++) {
+                uint64_t* bits = newBits(persistent);
+                bool empty = true;
+                for (size_t k = d + 1; k < rhs[p].size(); k++) {
+                    int x = rhs[p][k];
+                    if (terminalIndex[x] >= 0) {
+                        bits[terminalIndex[x] / 64] |= 1ULL << (terminalIndex[x] % 64);
+                        empty = false;
+                        break;
+                    }
+                    for (int w = 0; w < words; w++) bits[w] |= first[x][w];
+                    if (!nullable[x]) { empty = false; break; }
                 }
-                // 展开B的所有产生式
-                for (int j = 0; j < (int)productions.size(); j++) {
-                    if (productions[j].left == B) {
-                        LR1Item newItem = { j, 0, nextLookahead }; // 圆点在最前面的新项目
-                        // 合并与去重
-                        auto it = find_if(items.begin(), items.end(), [&](const LR1Item& x) {
-                            return x.prodId == newItem.prodId && x.dotPos == newItem.dotPos;
-                            });
-                        if (it == items.end()) { items.push_back(newItem); changed = true; }
-                        else {
-                            // 检查此时展望符还一不一样
-                            size_t oldSize = it->lookahead.size();
-                            for (auto& s : nextLookahead) it->lookahead.insert(s); // 合并展望符
-                            if (it->lookahead.size() > oldSize) changed = true;
+                betaFirst[itemBase[p] + d] = bits;
+                betaNullable[itemBase[p] + d] = empty;
+            }
+        }
+        slots.assign(256, -1);
+    }
+
+    uint64_t hashKernel(const CompactItem* kernel, int size) const {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ULL; };
+        for (int k = 0; k < size; k++) {
+            mix((uint64_t)kernel[k].prodId << 32 | (uint32_t)kernel[k].dotPos);
+            for (int w = 0; w < words; w++) mix(kernel[k].lookahead[w]);
+        }
+        return h ^ (h >> 29);
+    }
+
+    bool sameKernel(const State& s, const CompactItem* kernel, int size) const {
+        if (s.kernelSize != size) return false;
+        for (int k = 0; k < size; k++) {
+            if (s.items[k].prodId != kernel[k].prodId || s.items[k].dotPos != kernel[k].dotPos) return false;
+            if (memcmp(s.items[k].lookahead, kernel[k].lookahead, words * sizeof(uint64_t)) != 0) return false;
+        }
+        return true;
+    }
+
+    // 在临时区中求核心的闭包。项目顺序与逐项查找、合并的做法一致：先是核心，再按加入的先后
+    CompactItem* closure(const CompactItem* kernel, int kernelSize, int& size) {
+        parser.closureCalls++;
+        CompactItem* items = scratch.allocArray<CompactItem>(lr0Count);
+        int* position = scratch.allocArray<int>(lr0Count);     // LR(0) 项目 -> 在 items 中的下标
+        for (int k = 0; k < lr0Count; k++) position[k] = -1;
+        uint64_t* next = scratch.allocArray<uint64_t>(words);
+        size = 0;
+        for (int k = 0; k < kernelSize; k++) {
+            uint64_t* la = scratch.allocArray<uint64_t>(words);
+            memcpy(la, kernel[k].lookahead, words * sizeof(uint64_t));
+            items[size] = { kernel[k].prodId, kernel[k].dotPos, la };
+            position[itemBase[kernel[k].prodId] + kernel[k].dotPos] = size++;
+        }
+        bool changed = true;
+        while (changed) {
+            parser.closureIterations++;
+            changed = false;
+            for (int i = 0; i < size; i++) {
+                const CompactItem& cur = items[i];
+                const vector<int>& r = rhs[cur.prodId];
+                if (cur.dotPos >= (int)r.size() || terminalIndex[r[cur.dotPos]] >= 0) continue;
+                // 新项目的展望符：First(β)，β 可空时再并上当前项目的展望符
+                int lr0 = itemBase[cur.prodId] + cur.dotPos;
+                memcpy(next, betaFirst[lr0], words * sizeof(uint64_t));
+                if (betaNullable[lr0]) for (int w = 0; w < words; w++) next[w] |= cur.lookahead[w];
+                for (int j : prodsOf[r[cur.dotPos]]) {
+                    int& pos = position[itemBase[j]];
+                    if (pos < 0) {
+                        uint64_t* la = scratch.allocArray<uint64_t>(words);
+                        memcpy(la, next, words * sizeof(uint64_t));
+                        items[size] = { j, 0, la };
+                        pos = size++;
+                        changed = true;
+                    } else {
+                        uint64_t* la = items[pos].lookahead;
+                        for (int w = 0; w < words; w++) {
+                            if (next[w] & ~la[w]) { la[w] |= next[w]; changed = true; }
                         }
                     }
                 }
             }
         }
+        return items;
     }
-    return items;
-}
 
-//构建LR(1)分析表
-void Parser::buildLR1Table() {
-    vector<LR1Item> i0 = getClosure({ {0, 0, {"#"}} });
-    states.push_back(i0); //每个states[i]是一个LR1Item集合
-    for (int i = 0; i < (int)states.size(); i++) {
-        set<string> symbols;
-        for (auto& it : states[i]) { //找到所有可能的移进符号
-            if (it.dotPos < (int)productions[it.prodId].right.size())
-                symbols.insert(productions[it.prodId].right[it.dotPos]);
+    // 把临时区中的闭包复制进持久区，登记为新状态
+    int addState(const CompactItem* items, int size, int kernelSize, uint64_t hash) {
+        CompactItem* kept = persistent.allocArray<CompactItem>(size);
+        uint64_t* bits = persistent.allocArray<uint64_t>((size_t)size * words);
+        for (int k = 0; k < size; k++) {
+            kept[k] = { items[k].prodId, items[k].dotPos, bits + (size_t)k * words };
+            memcpy(kept[k].lookahead, items[k].lookahead, words * sizeof(uint64_t));
+        }
+        int id = (int)states.size();
+        states.push_back({ kept, size, kernelSize, hash });
+        if (states.size() * 2 > slots.size()) {
+            slots.assign(slots.size() * 2, -1);
+            for (int s = 0; s < (int)states.size(); s++) insertSlot(s);
+        } else {
+            insertSlot(id);
+        }
+        return id;
+    }
+
+    void insertSlot(int id) {
+        size_t mask = slots.size() - 1;
+        size_t s = states[id].hash & mask;
+        while (slots[s] >= 0) s = (s + 1) & mask;
+        slots[s] = id;
+    }
+
+    int findOrAdd(const CompactItem* kernel, int kernelSize) {
+        uint64_t hash = hashKernel(kernel, kernelSize);
+        size_t mask = slots.size() - 1;
+        for (size_t s = hash & mask; slots[s] >= 0; s = (s + 1) & mask) {
+            const State& candidate = states[slots[s]];
+            if (candidate.hash != hash) continue;
+            parser.stateComparisons++;
+            if (sameKernel(candidate, kernel, kernelSize)) return slots[s];
         }
-        for (auto& sym : symbols) { //对于每个可能的移进符号，构建新的项目集
-            vector<LR1Item> next;
-            for (auto& it : states[i]) {
-                if (it.dotPos < (int)productions[it.prodId].right.size() && productions[it.prodId].right[it.dotPos] == sym)
-                    next.push_back({ it.prodId, it.dotPos + 1, it.lookahead }); //移进
+        int size = 0;
+        CompactItem* items = closure(kernel, kernelSize, size);
+        return addState(items, size, kernelSize, hash);
+    }
+
+    void run() {
+        // 状态 0：增广项目 S' -> . B, # 的闭包
+        {
+            Arena::Mark start = scratch.mark();
+            uint64_t* la = newBits(scratch);
+            int end = terminalIndex[find(symbolNames.begin(), symbolNames.end(), "#") - symbolNames.begin()];
+            la[end / 64] |= 1ULL << (end % 64);
+            CompactItem augmented = { 0, 0, la };
+            findOrAdd(&augmented, 1);
+            scratch.reset(start);
+        }
+        vector<char> present(symbolNames.size());
+        vector<uint64_t> expected(words);
+        for (int i = 0; i < (int)states.size(); i++) {
+            const State st = states[i];     // states 会增长，先复制描述
+            fill(present.begin(), present.end(), 0);
+            fill(expected.begin(), expected.end(), 0);
+            for (int k = 0; k < st.size; k++) {
+                const vector<int>& r = rhs[st.items[k].prodId];
+                if (st.items[k].dotPos < (int)r.size()) present[r[st.items[k].dotPos]] = 1;
             }
-            next = getClosure(next);
-            int nextId = -1;
-            for (int k = 0; k < (int)states.size(); k++) if (states[k] == next) { nextId = k; break; }
-            if (nextId == -1) { states.push_back(next); nextId = (int)states.size() - 1; }
-            //更新ACTION、GOTO表
-            if (Vt.count(sym)) {
-                Action act; //临时对象
-                act.type = ActionType::SHIFT;
-                act.target = nextId;
-                actionTable[i][sym] = act; //行：状态编号i；列：移进的sym；值：Action
+            // 对每个可移进的符号（字典序）构造转移核心
+            for (int sym = 0; sym < (int)symbolNames.size(); sym++) {
+                if (!present[sym]) continue;
+                Arena::Mark start = scratch.mark();
+                CompactItem* kernel = scratch.allocArray<CompactItem>(st.size);
+                int kernelSize = 0;
+                for (int k = 0; k < st.size; k++) {
+                    const CompactItem& it = st.items[k];
+                    const vector<int>& r = rhs[it.prodId];
+                    if (it.dotPos < (int)r.size() && r[it.dotPos] == sym)
+                        kernel[kernelSize++] = { it.prodId, it.dotPos + 1, it.lookahead };
+                }
+                int nextId = findOrAdd(kernel, kernelSize);
+                scratch.reset(start);
+                //更新ACTION、GOTO表
+                if (terminalIndex[sym] >= 0) {
+                    expected[terminalIndex[sym] / 64] |= 1ULL << (terminalIndex[sym] % 64);
+                    Action act;
+                    act.type = ActionType::SHIFT;
+                    act.target = nextId;
+                    parser.actionTable[i][symbolNames[sym]] = act;
+                }
+                else parser.gotoTable[i][symbolNames[sym]] = nextId;
             }
-            else gotoTable[i][sym] = nextId;
-        }
-        // 处理归约或接受操作
-        for (auto& it : states[i]) {
-            if (it.dotPos == (int)productions[it.prodId].right.size() || productions[it.prodId].right.empty()) {
-                for (auto& la : it.lookahead) {
+            // 处理归约或接受操作
+            for (int k = 0; k < st.size; k++) {
+                const CompactItem& it = st.items[k];
+                if (it.dotPos != (int)rhs[it.prodId].size()) continue;
+                for (int w = 0; w < words; w++) expected[w] |= it.lookahead[w];
+                for (int t = 0; t < (int)terminalNames.size(); t++) {
+                    if (!(it.lookahead[t / 64] >> (t % 64) & 1)) continue;
                     Action act;
                     if (it.prodId == 0) {
                         act.type = ActionType::ACCEPT;
@@ -208,13 +404,63 @@ void Parser::buildLR1Table() {
                         act.type = ActionType::REDUCE;
                         act.target = it.prodId;
                     }
-                    actionTable[i][la] = act;
+                    parser.actionTable[i][terminalNames[t]] = act;
+                }
+            }
+            parser.expectedBits.insert(parser.expectedBits.end(), expected.begin(), expected.end());
+        }
+        parser.numStates = (int)states.size();
+        parser.expectedNames = terminalNames;
+        parser.expectedWords = words;
+    }
+
+    // 保留下来的项目集转换成对外的 LR1Item 形式
+    void materialize() {
+        parser.states.assign(states.size(), vector<LR1Item>());
+        for (size_t i = 0; i < states.size(); i++) {
+            vector<LR1Item>& out = parser.states[i];
+            out.resize(states[i].size);
+            for (int k = 0; k < states[i].size; k++) {
+                const CompactItem& it = states[i].items[k];
+                out[k].prodId = it.prodId;
+                out[k].dotPos = it.dotPos;
+                for (int t = 0; t < (int)terminalNames.size(); t++) {
+                    if (it.lookahead[t / 64] >> (t % 64) & 1) out[k].lookahead.insert(out[k].lookahead.end(), terminalNames[t]);
                 }
             }
         }
     }
-    saveItemsToFile("items.txt");
-    saveTableToCSV("table.csv");
+};
+
+//构建LR(1)分析表
+void Parser::buildLR1Table(bool keepItems) {
+    ScopedTimer tableTimer(stats, "parser.lr1_table", "parser");
+    TableBuilder builder(*this);
+    builder.setup();
+    builder.run();
+    if (keepItems) builder.materialize();
+    if (stats) {
+        size_t items = 0;
+        for (const auto& st : builder.states) items += st.size;
+        stats->add("parser.states", (long long)numStates);
+        stats->add("parser.items", (long long)items);
+        stats->add("parser.closure_calls", closureCalls);
+        stats->add("parser.closure_iterations", closureIterations);
+        stats->add("parser.state_comparisons", stateComparisons);
+        stats->add("parser.arena_chunks", builder.persistent.getChunkAllocations() + builder.scratch.getChunkAllocations());
+        stats->add("parser.arena_requests", builder.persistent.getRequests() + builder.scratch.getRequests());
+        stats->add("parser.arena_reserved_bytes", (long long)(builder.persistent.reservedBytes() + builder.scratch.reservedBytes()));
+        stats->add("parser.scratch_resets", builder.scratch.getResets());
+    }
+}
+
+set<string> Parser::getExpected(int state) const {
+    set<string> expected;
+    const uint64_t* bits = &expectedBits[(size_t)state * expectedWords];
+    for (int t = 0; t < (int)expectedNames.size(); t++) {
+        if (bits[t / 64] >> (t % 64) & 1) expected.insert(expected.end(), expectedNames[t]);
+    }
+    return expected;
 }
 
 void Parser::saveItemsToFile(const string& filename) {
@@ -270,7 +516,7 @@ void Parser::saveTableToCSV(const string& filename) {
     for (auto& t : VtOrder) out << t << ",";
     for (auto& n : VnOrder) if (n != "S'") out << n << ",";
     out << endl;
-    for (int i = 0; i < (int)states.size(); i++) {
+    for (int i = 0; i < numStates; i++) {
         out << i << ",";
         for (auto& t : VtOrder) {
             if (actionTable[i].count(t)) {
@@ -2,6 +2,8 @@
 #define PARSER_H
 
 #include "types.h"
+#include "stats.h"
+#include <cstdint>
 #include <vector>
 #include <set>
 #include <map>
@@ -14,32 +16,46 @@ private:
     set<string> Vn, Vt;  // 非终结符和终结符集合
     vector<string> VnOrder, VtOrder;  // 保持符号的原始顺序
     map<string, set<string>> firstSets;
+    // 项目集族只在写出 items.txt 时临时转换出来，写完即释放；分析和报错只用下面的表
     vector<vector<LR1Item>> states;
+    int numStates = 0;
     map<int, map<string, Action>> actionTable;
     map<int, map<string, int>> gotoTable;
 
+    // 计时与计数（可为空）；计数在构造过程中累加，构造结束时记入 stats
+    Stats* stats = nullptr;
+    long long closureCalls = 0;         // 闭包计算次数
+    long long closureIterations = 0;    // 闭包外层不动点循环的轮数
+    long long stateComparisons = 0;     // 转移核心与已有状态核心的比较次数
+
+    // 每个状态期望的终结符（移进的终结符与归约项目的向前看符号）：每状态 expectedWords 个字的位集，
+    // 位号按 expectedNames（终结符的字典序）编号。语法报错时据此列出期望的符号，不需要项目集
+    vector<string> expectedNames;
+    int expectedWords = 0;
+    vector<uint64_t> expectedBits;
     // 计算 First 集
     void computeFirst();
-    set<string> getFirst(const vector<string>& symbols);
-    
-    // LR(1) 项目集闭包
-    vector<LR1Item> getClosure(vector<LR1Item> items);
-    
-    // 构建 LR(1) 分析表
-    void buildLR1Table();
+
+    // 构建 LR(1) 分析表：构造期间的数据在 parser.cpp 的 TableBuilder 中，
+    // 用紧凑的项目和位集表示，分配在区域分配器里；keepItems 时把保留的项目集转换成 states
+    struct TableBuilder;
+    void buildLR1Table(bool keepItems);
     
     // 保存分析表到文件
     void saveItemsToFile(const string& filename);
     void saveTableToCSV(const string& filename);
 
 public:
-    Parser();
+    // saveFiles 为 false 时不写出 items.txt 和 table.csv（嵌入使用时不做文件输出）
+    explicit Parser(Stats* stats = nullptr, bool saveFiles = true);
     
     // 获取分析表
     const map<int, map<string, Action>>& getActionTable() const { return actionTable; }
     const map<int, map<string, int>>& getGotoTable() const { return gotoTable; }
     const vector<Production>& getProductions() const { return productions; }
-    const vector<vector<LR1Item>>& getStates() const { return states; }
+    int getNumStates() const { return numStates; }
+    // 状态 state 下期望的终结符，按字典序
+    set<string> getExpected(int state) const;
     const set<string>& getVt() const { return Vt; }
     const set<string>& getVn() const { return Vn; }
 };
@@ -0,0 +1,386 @@
+#include "peephole.h"
+#include "tacutil.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+
+using namespace std;
+
+// ============================================================================
+// 内置规则
+// ============================================================================
+
+const vector<PeepholeRule>& defaultPeepholeRules() {
+    static const vector<PeepholeRule> rules = {
+        // 跳到紧接着的下一条指令的跳转什么也不做（条件跳转的条件是变量，求值没有副作用）
+        { "goto-next", "(goto, _, _, ?L)", "next(?L)", "" },
+        { "branch-next", "(jz, *, _, ?L)", "next(?L)", "" },
+        { "branch-next", "(jnz, *, _, ?L)", "next(?L)", "" },
+
+        // 与 0 比较后测试：x == 0 为假即 x 为真，x != 0 为假即 x 为假（不带后缀的比较只用于 int）。
+        // 三地址码没有比较跳转指令，其他关系运算与测试的融合由虚拟机和汇编后端完成
+        { "compare-zero-test", "(==, ?a, 0, ?t) (jz, ?t, _, ?L)", "var(?a), once(?t)", "(jnz, ?a, _, ?L)" },
+        { "compare-zero-test", "(==, ?a, 0, ?t) (jnz, ?t, _, ?L)", "var(?a), once(?t)", "(jz, ?a, _, ?L)" },
+        { "compare-zero-test", "(!=, ?a, 0, ?t) (jz, ?t, _, ?L)", "var(?a), once(?t)", "(jz, ?a, _, ?L)" },
+        { "compare-zero-test", "(!=, ?a, 0, ?t) (jnz, ?t, _, ?L)", "var(?a), once(?t)", "(jnz, ?a, _, ?L)" },
+        { "compare-zero-test", "(==, 0, ?a, ?t) (jz, ?t, _, ?L)", "var(?a), once(?t)", "(jnz, ?a, _, ?L)" },
+        { "compare-zero-test", "(==, 0, ?a, ?t) (jnz, ?t, _, ?L)", "var(?a), once(?t)", "(jz, ?a, _, ?L)" },
+        { "compare-zero-test", "(!=, 0, ?a, ?t) (jz, ?t, _, ?L)", "var(?a), once(?t)", "(jz, ?a, _, ?L)" },
+        { "compare-zero-test", "(!=, 0, ?a, ?t) (jnz, ?t, _, ?L)", "var(?a), once(?t)", "(jnz, ?a, _, ?L)" },
+        // 复写到临时变量后测试，直接测试原变量
+        { "copy-test", "(:=, ?a, _, ?t) (jz, ?t, _, ?L)", "var(?a), once(?t)", "(jz, ?a, _, ?L)" },
+        { "copy-test", "(:=, ?a, _, ?t) (jnz, ?t, _, ?L)", "var(?a), once(?t)", "(jnz, ?a, _, ?L)" },
+
+        // 计算到临时变量再复写给变量（赋值语句 S->i=E 的形状），直接写入变量
+        { "copy-through-temp", "(?op, ?a, ?b, ?t) (:=, ?t, _, ?x)", "pure(?op), once(?t)", "(?op, ?a, ?b, ?x)" },
+
+        // 两次取负得到原值（int 按补码回绕，INT_MIN 取负两次仍是自身）
+        { "neg-neg", "(neg, ?x, _, ?t) (neg, ?t, _, ?u)", "once(?t)", "(:=, ?x, _, ?u)" },
+        { "neg-neg", "(neg., ?x, _, ?t) (neg., ?t, _, ?u)", "once(?t)", "(:=, ?x, _, ?u)" },
+
+        // 结果没有被引用的计算（如后缀自增保存的原值）
+        { "unused-temp", "(?op, *, *, ?t)", "pure(?op), unused(?t)", "" },
+    };
+    return rules;
+}
+
+// ============================================================================
+// 规则解析
+// ============================================================================
+
+static string trim(const string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n"), e = s.find_last_not_of(" \t\r\n");
+    return b == string::npos ? string() : s.substr(b, e - b + 1);
+}
+
+bool PeepholeOptimizer::parseInstrs(const string& text, bool isPattern, map<string, int>& vars,
+                                    vector<InstrPattern>& out, string& error) {
+    size_t pos = 0;
+    while (true) {
+        pos = text.find_first_not_of(" \t\r\n", pos);
+        if (pos == string::npos) return true;
+        size_t close = text.find(')', pos);
+        if (text[pos] != '(' || close == string::npos) {
+            error = "应为 (op, arg1, arg2, result): " + text.substr(pos);
+            return false;
+        }
+        string body = text.substr(pos + 1, close - pos - 1);
+        pos = close + 1;
+
+        vector<string> parts;
+        size_t start = 0;
+        for (size_t comma; (comma = body.find(',', start)) != string::npos; start = comma + 1) {
+            parts.push_back(trim(body.substr(start, comma - start)));
+        }
+        parts.push_back(trim(body.substr(start)));
+        if (parts.size() != 4) {
+            error = "四元式应有 4 个字段: (" + body + ")";
+            return false;
+        }
+
+        InstrPattern ip;
+        for (int k = 0; k < 4; k++) {
+            const string& p = parts[k];
+            Field& f = ip.f[k];
+            if (p.empty()) {
+                error = "字段不能为空，空字段写作 _: (" + body + ")";
+                return false;
+            } else if (p == "_") {
+                f.kind = EMPTY;
+            } else if (p == "*") {
+                if (!isPattern) {
+                    error = "替换中不能使用 *: (" + body + ")";
+                    return false;
+                }
+                f.kind = ANY;
+            } else if (p[0] == '?') {
+                auto it = vars.find(p);
+                if (it == vars.end()) {
+                    if (!isPattern) {
+                        error = "替换中的变量 " + p + " 没有在模式中出现";
+                        return false;
+                    }
+                    it = vars.insert(make_pair(p, (int)vars.size())).first;
+                }
+                f.kind = VAR;
+                f.var = it->second;
+            } else {
+                f.kind = TEXT;
+                f.text = p;
+            }
+        }
+        out.push_back(ip);
+    }
+}
+
+PeepholeOptimizer::PeepholeOptimizer(bool withDefaultRules) {
+    if (!withDefaultRules) return;
+    string error;
+    for (const auto& r : defaultPeepholeRules()) addRule(r, error);
+}
+
+bool PeepholeOptimizer::addRule(const PeepholeRule& rule, string& error) {
+    CompiledRule cr;
+    cr.name = rule.name;
+    map<string, int> vars;
+    if (!parseInstrs(rule.pattern, true, vars, cr.pattern, error) ||
+        !parseInstrs(rule.rewrite, false, vars, cr.rewrite, error)) {
+        error = "规则 " + rule.name + ": " + error;
+        return false;
+    }
+    if (cr.pattern.empty()) {
+        error = "规则 " + rule.name + ": 模式至少要有一条指令";
+        return false;
+    }
+    if (cr.rewrite.size() > cr.pattern.size()) {
+        error = "规则 " + rule.name + ": 替换的指令条数不能多于模式";
+        return false;
+    }
+
+    static const map<string, PredKind> predNames = {
+        { "temp", P_TEMP }, { "var", P_VAR }, { "once", P_ONCE },
+        { "unused", P_UNUSED }, { "pure", P_PURE }, { "next", P_NEXT },
+    };
+    size_t start = 0;
+    while (start < rule.where.size()) {
+        size_t comma = rule.where.find(',', start);
+        if (comma == string::npos) comma = rule.where.size();
+        string p = trim(rule.where.substr(start, comma - start));
+        start = comma + 1;
+        if (p.empty()) continue;
+        size_t open = p.find('('), close = p.find(')');
+        auto kind = predNames.find(trim(p.substr(0, open)));
+        auto var = open == string::npos || close != p.size() - 1 ? vars.end()
+                                                                  : vars.find(trim(p.substr(open + 1, close - open - 1)));
+        if (kind == predNames.end() || var == vars.end()) {
+            error = "规则 " + rule.name + ": 无法识别的条件 " + p;
+            return false;
+        }
+        cr.where.push_back({ kind->second, var->second });
+    }
+
+    cr.numVars = (int)vars.size();
+    maxWindow = max(maxWindow, cr.pattern.size());
+    rules.push_back(cr);
+    return true;
+}
+
+// ============================================================================
+// 匹配与改写
+// ============================================================================
+
+static string& fieldOf(TAC& t, int k) {
+    return k == 0 ? t.op : k == 1 ? t.arg1 : k == 2 ? t.arg2 : t.result;
+}
+
+// 变量和临时变量各有一个编号，空字段、常量和标号为 -1。临时变量 T<n> 按编号 n 直接查表，
+// 其余名字查哈希表。fieldIds 记录每条指令 arg1、arg2、result 三个字段的编号，删除指令时随之压缩，
+// 各遍只在改写时为新指令重新求编号
+struct PeepholeOptimizer::NameTable {
+    unordered_map<string, int> ids;
+    vector<int> tempIds;
+    vector<char> isTemp;
+    vector<int> fieldIds;   // fieldIds[3i + k]：第 i 条指令字段 k（arg1、arg2、result）的编号
+
+    int newId(bool temp) {
+        isTemp.push_back(temp ? 1 : 0);
+        return (int)isTemp.size() - 1;
+    }
+    int idOf(const string& s) {
+        if (s.empty()) return -1;
+        if (s.size() > 1 && s.size() < 10 && s[0] == 'T' && (s[1] != '0' || s.size() == 2) &&
+            all_of(s.begin() + 1, s.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            size_t k = (size_t)atoi(s.c_str() + 1);
+            if (k >= tempIds.size()) tempIds.resize(k + 1, -1);
+            if (tempIds[k] < 0) tempIds[k] = newId(true);
+            return tempIds[k];
+        }
+        if (isConstName(s)) return -1;
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        int id = newId(isTempName(s));
+        ids.emplace(s, id);
+        return id;
+    }
+    void set(const vector<TAC>& code, int i) {
+        const TAC& t = code[i];
+        fieldIds[3 * i] = idOf(t.arg1);
+        fieldIds[3 * i + 1] = idOf(t.arg2);
+        fieldIds[3 * i + 2] = isJumpOp(t.op) ? -1 : idOf(t.result);
+    }
+};
+
+int PeepholeOptimizer::runPass(vector<TAC>& code, vector<bool>& dead, NameTable& names) {
+    int n = (int)code.size();
+
+    // 引用与定值次数按编号计数，随改写增减
+    vector<int> uses(names.isTemp.size(), 0), defs(names.isTemp.size(), 0);
+    auto grow = [&]() {
+        uses.resize(names.isTemp.size(), 0);
+        defs.resize(names.isTemp.size(), 0);
+    };
+    const vector<char>& isTemp = names.isTemp;
+    vector<int>& fieldIds = names.fieldIds;
+
+    // targets[i]：跳到 i 的跳转条数（标号指向已删除的指令时算在其后第一条保留的指令上）
+    vector<int> targets(n + 1, 0);
+    auto nextLive = [&](int i) {
+        while (i < n && dead[i]) i++;
+        return i;
+    };
+    auto resolve = [&](const string& label) {
+        int a = labelAddr(label);
+        return a < 0 ? -1 : nextLive(min(a, n));
+    };
+    // 与 usesOf / defOf 的口径相同：goto 不引用操作数，条件跳转只引用 arg1
+    auto account = [&](int i, int delta) {
+        const TAC& t = code[i];
+        const int* f = &fieldIds[3 * i];
+        if (isJumpOp(t.op)) {
+            if (t.op != "goto" && f[0] >= 0) uses[f[0]] += delta;
+            int target = resolve(t.result);
+            if (target >= 0) targets[target] += delta;
+            return;
+        }
+        if (f[0] >= 0) uses[f[0]] += delta;
+        if (f[1] >= 0) uses[f[1]] += delta;
+        if (f[2] >= 0) defs[f[2]] += delta;
+    };
+    for (int i = 0; i < n; i++) account(i, 1);
+
+    int hits = 0;
+    vector<int> window;
+    vector<string> binding;
+    vector<int> bindingId;
+    vector<bool> bound;
+    for (int i = nextLive(0); i < n; ) {
+        window.clear();
+        for (int j = i; j < n && window.size() < maxWindow; j = nextLive(j + 1)) window.push_back(j);
+
+        const CompiledRule* match = nullptr;
+        for (const auto& rule : rules) {
+            size_t m = rule.pattern.size();
+            if (m > window.size()) continue;
+            // 先比较第一条的运算符，绝大多数规则在这里就被排除
+            const Field& op0 = rule.pattern[0].f[0];
+            if (op0.kind == TEXT && op0.text != code[i].op) continue;
+            bool ok = true;
+            for (size_t k = 1; k < m && ok; k++) ok = targets[window[k]] == 0;
+
+            bound.assign(rule.numVars, false);
+            binding.resize(rule.numVars);
+            bindingId.resize(rule.numVars);
+            for (size_t k = 0; k < m && ok; k++) {
+                TAC& t = code[window[k]];
+                for (int f = 0; f < 4 && ok; f++) {
+                    const Field& pf = rule.pattern[k].f[f];
+                    const string& value = fieldOf(t, f);
+                    switch (pf.kind) {
+                    case EMPTY: ok = value.empty(); break;
+                    case ANY: break;
+                    case TEXT: ok = value == pf.text; break;
+                    case VAR:
+                        if (bound[pf.var]) {
+                            ok = binding[pf.var] == value;
+                        } else {
+                            binding[pf.var] = value;
+                            bindingId[pf.var] = f == 0 ? -1 : fieldIds[3 * window[k] + f - 1];
+                            bound[pf.var] = true;
+                        }
+                        break;
+                    }
+                }
+            }
+
+            int after = m < window.size() ? window[m] : nextLive(window[m - 1] + 1);
+            for (size_t k = 0; k < rule.where.size() && ok; k++) {
+                const string& x = binding[rule.where[k].var];
+                int id = bindingId[rule.where[k].var];
+                switch (rule.where[k].kind) {
+                case P_TEMP: ok = id >= 0 && isTemp[id]; break;
+                case P_VAR: ok = id >= 0; break;
+                case P_ONCE: ok = id >= 0 && isTemp[id] && defs[id] == 1 && uses[id] == 1; break;
+                case P_UNUSED: ok = id >= 0 && isTemp[id] && uses[id] == 0; break;
+                case P_PURE: ok = isPureOp(x); break;
+                case P_NEXT: ok = resolve(x) == after; break;
+                }
+            }
+            if (ok) {
+                match = &rule;
+                break;
+            }
+        }
+        if (!match) {
+            i = nextLive(i + 1);
+            continue;
+        }
+
+        // 换下窗口中的指令：替换的指令依次放在窗口前几条的位置，其余位置删除
+        size_t m = match->pattern.size(), r = match->rewrite.size();
+        for (size_t k = 0; k < m; k++) account(window[k], -1);
+        for (size_t k = r; k < m; k++) dead[window[k]] = true;
+        if (r == 0) {
+            // 跳到窗口的跳转改为跳到窗口之后
+            int after = nextLive(window[m - 1] + 1);
+            targets[after] += targets[window[0]];
+            targets[window[0]] = 0;
+        }
+        for (size_t k = 0; k < r; k++) {
+            TAC& t = code[window[k]];
+            for (int f = 0; f < 4; f++) {
+                const Field& rf = match->rewrite[k].f[f];
+                fieldOf(t, f) = rf.kind == VAR ? binding[rf.var] : rf.kind == TEXT ? rf.text : string();
+            }
+            names.set(code, window[k]);
+            grow();
+            account(window[k], 1);
+        }
+        fired[match->name]++;
+        hits++;
+        i = nextLive(window[0] + 1);
+    }
+    return hits;
+}
+
+int PeepholeOptimizer::run(vector<TAC>& code, vector<LoopRecord>* loops) {
+    fired.clear();
+    removed = 0;
+    passes = 0;
+    if (rules.empty()) return 0;
+
+    // addrMap[a]：原地址 a 在当前代码中的地址
+    vector<int> addrMap(code.size() + 1);
+    for (size_t a = 0; a < addrMap.size(); a++) addrMap[a] = (int)a;
+    NameTable names;
+    names.fieldIds.resize(3 * code.size());
+    for (int i = 0; i < (int)code.size(); i++) names.set(code, i);
+
+    while (passes < MAX_PASSES) {
+        int n = (int)code.size();
+        vector<bool> dead(n, false);
+        int hits = runPass(code, dead, names);
+        passes++;
+        if (hits == 0) break;
+
+        vector<int> keptBefore(n + 1, 0);
+        for (int i = 0; i < n; i++) keptBefore[i + 1] = keptBefore[i] + (dead[i] ? 0 : 1);
+        for (int& a : addrMap) a = keptBefore[a];
+        removed += n - keptBefore[n];
+        compactTAC(code, dead);
+        for (int i = 0; i < n; i++) {
+            if (dead[i]) continue;
+            for (int k = 0; k < 3; k++) names.fieldIds[3 * keptBefore[i] + k] = names.fieldIds[3 * i + k];
+        }
+        names.fieldIds.resize(3 * code.size());
+    }
+
+    if (loops) {
+        int last = (int)addrMap.size() - 1;
+        for (auto& l : *loops) {
+            l.testStart = addrMap[min(l.testStart, last)];
+            l.backEdge = addrMap[min(l.backEdge, last)];
+            l.exitAddr = addrMap[min(l.exitAddr, last)];
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,102 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "types.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// === 窥孔优化 ===
+// 用若干条连续指令组成的窗口在三地址码上滑动，窗口与某条规则的模式匹配时换成规则给出的指令。
+// 规则是一张表，每条规则用四元式的写法描述，新增规则不需要改动匹配引擎：
+//
+//   模式    一条或多条 (op, arg1, arg2, result)，依次匹配相邻的指令
+//   条件    逗号分隔的谓词，可为空
+//   替换    零条或多条 (op, arg1, arg2, result)，空串表示删除整个窗口
+//
+// 每个字段可以写成：
+//   _       空（该字段没有内容）
+//   *       任意内容（只能用在模式中）
+//   ?名字   变量：第一次出现时绑定该字段的内容，之后出现必须相同；替换中取绑定的内容
+//   其他    原样比较的文本，如运算符 neg、常量 0
+//
+// 谓词（参数都是变量）：
+//   temp(?x)    是临时变量
+//   var(?x)     是变量名而不是常量
+//   once(?x)    是临时变量，整个程序中只定值一次、只被引用一次（就是窗口中的这一次）
+//   unused(?x)  是临时变量，没有任何引用
+//   pure(?op)   是无副作用的计算（不是跳转）
+//   next(?L)    标号 ?L 指向窗口之后的第一条指令
+//
+// 窗口中除第一条以外的指令都不能是跳转目标，替换的指令放在窗口第一条的位置，
+// 跳到窗口的跳转仍然跳到替换后的第一条（删除整个窗口时跳到其后的指令）。
+// 每一遍从头到尾滑动一次，一遍结束后删除空位并重新编号地址与跳转标号（与回填的标号一致），
+// 直到某一遍没有任何规则触发（最多 MAX_PASSES 遍）。
+
+struct PeepholeRule {
+    string name;
+    string pattern;
+    string where;
+    string rewrite;
+};
+
+// 内置规则：比较后测试、经临时变量的复写、跳到下一条的跳转、两次取负、未使用的临时变量
+const vector<PeepholeRule>& defaultPeepholeRules();
+
+class PeepholeOptimizer {
+private:
+    enum FieldKind { EMPTY, ANY, VAR, TEXT };
+    struct Field {
+        FieldKind kind = EMPTY;
+        int var = -1;           // VAR：变量编号
+        string text;            // TEXT：原样比较的文本
+    };
+    struct InstrPattern {
+        Field f[4];             // op, arg1, arg2, result
+    };
+    enum PredKind { P_TEMP, P_VAR, P_ONCE, P_UNUSED, P_PURE, P_NEXT };
+    struct Predicate {
+        PredKind kind;
+        int var;
+    };
+    struct CompiledRule {
+        string name;
+        vector<InstrPattern> pattern;
+        vector<Predicate> where;
+        vector<InstrPattern> rewrite;
+        int numVars = 0;
+    };
+
+    // 名字编号表（定义见 peephole.cpp），在各遍之间保留
+    struct NameTable;
+
+    vector<CompiledRule> rules;
+    size_t maxWindow = 0;
+    map<string, int> fired;     // 规则名 -> 触发次数
+    int removed = 0;
+    int passes = 0;
+
+    static bool parseInstrs(const string& text, bool isPattern, map<string, int>& vars,
+                            vector<InstrPattern>& out, string& error);
+    // 一遍滑动，返回触发的规则次数
+    int runPass(vector<TAC>& code, vector<bool>& dead, NameTable& names);
+
+public:
+    static const int MAX_PASSES = 64;
+
+    // withDefaultRules 为 false 时规则表为空，之后用 addRule 逐条加入
+    explicit PeepholeOptimizer(bool withDefaultRules = true);
+
+    // 解析一条规则加入规则表（排在已有规则之后，先加入的先尝试），格式错误时返回 false 并说明原因。
+    // 替换的指令条数不能多于模式，保证每一遍都能结束
+    bool addRule(const PeepholeRule& rule, string& error);
+
+    // 反复应用规则直到不动点；loops 不为空时把循环记录中的地址换成删除后的新地址。返回删除的指令数
+    int run(vector<TAC>& code, vector<LoopRecord>* loops = nullptr);
+
+    const map<string, int>& getFired() const { return fired; }
+    int getRemoved() const { return removed; }
+    int getPasses() const { return passes; }
+};
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,230 @@
+#include "profiler.h"
+#include "tacutil.h"
+#include <algorithm>
+
+using namespace std;
+
+int tripBucket(long long trips) {
+    int k = 0;
+    while (trips > 0) {
+        trips >>= 1;
+        k++;
+    }
+    return k;
+}
+
+// 桶的显示：0、1、2–3、4–7 ...
+static string bucketLabel(int k) {
+    if (k <= 1) return to_string(k);
+    return to_string(1LL << (k - 1)) + "–" + to_string((1LL << k) - 1);
+}
+
+// 行号范围的显示，0 表示未知
+static string lineRange(int first, int last) {
+    if (first <= 0) return "源位置未知";
+    if (last <= first) return "第 " + to_string(first) + " 行";
+    return "第 " + to_string(first) + "–" + to_string(last) + " 行";
+}
+
+static double percent(long long part, long long total) {
+    return total > 0 ? 100.0 * part / total : 0.0;
+}
+
+namespace {
+
+// 逐条计数，并按循环记录跟踪每次进入循环的迭代次数
+struct LoopTracker : EvalObserver {
+    vector<long long>& counts;
+    vector<LoopProfile>& loops;
+    const vector<LoopRecord>& records;
+    vector<vector<int>> headerLoops;        // 地址 -> 以它为条件起始地址的循环（外层在前）
+    vector<pair<int, long long>> active;    // 正在执行的循环（内层在后）及本次进入已有的迭代次数
+    int lastPc = -1;
+
+    LoopTracker(int n, vector<long long>& counts, vector<LoopProfile>& loops, const vector<LoopRecord>& records)
+        : counts(counts), loops(loops), records(records), headerLoops(n) {
+        for (int k = 0; k < (int)records.size(); k++) {
+            int h = records[k].testStart;
+            if (h >= 0 && h < n) headerLoops[h].push_back(k);
+        }
+        // while(true) 的条件不生成代码，外层与紧接着的内层循环可能共用条件起始地址；范围大的是外层
+        for (auto& ks : headerLoops) {
+            if (ks.size() > 1) {
+                sort(ks.begin(), ks.end(), [&](int a, int b) { return records[a].exitAddr > records[b].exitAddr; });
+            }
+        }
+    }
+
+    bool isActive(int k) const {
+        for (auto it = active.rbegin(); it != active.rend(); ++it) {
+            if (it->first == k) return true;
+        }
+        return false;
+    }
+
+    // 结束最内层循环的这次进入
+    void finish() {
+        LoopProfile& lp = loops[active.back().first];
+        long long trips = active.back().second;
+        active.pop_back();
+        lp.iterations += trips;
+        lp.maxTrip = max(lp.maxTrip, trips);
+        size_t bucket = (size_t)tripBucket(trips);
+        if (lp.tripHistogram.size() <= bucket) lp.tripHistogram.resize(bucket + 1, 0);
+        lp.tripHistogram[bucket]++;
+    }
+
+    void step(int pc) override {
+        counts[pc]++;
+        lastPc = pc;
+        while (!active.empty()) {
+            const LoopRecord& r = records[active.back().first];
+            if (pc >= r.testStart && pc < r.exitAddr) break;
+            finish();
+        }
+        const vector<int>& ks = headerLoops[pc];
+        if (ks.empty()) return;
+        // 回到条件起始地址：最内层正在执行的循环记一次迭代，不在执行中的循环记一次进入
+        for (auto it = ks.rbegin(); it != ks.rend(); ++it) {
+            if (!isActive(*it)) continue;
+            for (auto& a : active) {
+                if (a.first == *it) a.second++;
+            }
+            break;
+        }
+        for (int k : ks) {
+            if (isActive(k)) continue;
+            loops[k].entries++;
+            active.push_back(make_pair(k, 0LL));
+        }
+    }
+};
+
+} // namespace
+
+TACProfiler::TACProfiler(const map<string, string>& varTypes, long long stepLimit)
+    : evaluator(varTypes, stepLimit) {
+}
+
+ProfileResult TACProfiler::run(const vector<TAC>& code, const vector<LoopRecord>& loops) const {
+    ProfileResult res;
+    int n = (int)code.size();
+    res.instrCounts.assign(n, 0);
+    res.loops.resize(loops.size());
+    for (int k = 0; k < (int)loops.size(); k++) {
+        LoopProfile& lp = res.loops[k];
+        lp.record = k;
+        lp.line = loops[k].line;
+        lp.col = loops[k].col;
+        lp.endLine = loops[k].endLine;
+        lp.depth = loops[k].depth;
+    }
+
+    LoopTracker tracker(n, res.instrCounts, res.loops, loops);
+    res.eval = evaluator.run(code, &tracker);
+    // 运行时错误或达到步数上限时仍在执行的循环，这次进入按已有的迭代次数计
+    while (!tracker.active.empty()) tracker.finish();
+    res.lastPc = tracker.lastPc;
+
+    for (int k = 0; k < (int)loops.size(); k++) {
+        int lo = max(0, loops[k].testStart), hi = min(n, loops[k].exitAddr);
+        for (int i = lo; i < hi; i++) res.loops[k].instructions += res.instrCounts[i];
+    }
+
+    vector<int> leaders = findLeaders(code);
+    for (int b = 0; b + 1 < (int)leaders.size(); b++) {
+        BlockProfile bp;
+        bp.id = b;
+        bp.start = leaders[b];
+        bp.end = leaders[b + 1];
+        bp.count = bp.start < n ? res.instrCounts[bp.start] : 0;
+        for (int i = bp.start; i < bp.end; i++) {
+            bp.instructions += res.instrCounts[i];
+            int line = code[i].line;
+            if (line <= 0) continue;
+            if (bp.firstLine == 0 || line < bp.firstLine) bp.firstLine = line;
+            bp.lastLine = max(bp.lastLine, line);
+        }
+        res.blocks.push_back(bp);
+    }
+    return res;
+}
+
+void TACProfiler::printReport(const ProfileResult& profile, const vector<TAC>& code, OutputSink& out, int top) {
+    const EvalResult& e = profile.eval;
+    long long total = e.steps;
+    int executedBlocks = 0;
+    for (const auto& bp : profile.blocks) {
+        if (bp.count > 0) executedBlocks++;
+    }
+    out << "\n--- 执行剖析 (参考求值) ---\n";
+    out << "执行指令 " << total << " 条" << (e.limitHit ? "（达到步数上限）" : "") << "，其中跳转 " << e.branches
+        << " 次；基本块 " << profile.blocks.size() << " 个，执行过 " << executedBlocks << " 个\n";
+    if (!e.ok || e.limitHit) {
+        const TAC* at = profile.lastPc >= 0 && profile.lastPc < (int)code.size() ? &code[profile.lastPc] : nullptr;
+        if (!e.ok) out << "运行时错误: " << e.error;
+        else out << "停止";
+        out << "，位于第 " << profile.lastPc << " 条指令";
+        if (at && at->line > 0) out << "（源程序第 " << at->line << " 行第 " << at->col << " 列）";
+        out << '\n';
+    }
+
+    // 循环：按循环内执行的指令数
+    vector<const LoopProfile*> loops;
+    for (const auto& lp : profile.loops) {
+        if (lp.entries > 0) loops.push_back(&lp);
+    }
+    stable_sort(loops.begin(), loops.end(), [](const LoopProfile* a, const LoopProfile* b) {
+        return a->instructions > b->instructions;
+    });
+    if (loops.size() > (size_t)top) loops.resize(top);
+    out << "最热的循环（" << profile.loops.size() << " 个中执行过的前 " << loops.size()
+        << " 个，按循环内执行的指令数，含内层循环）:\n";
+    for (const LoopProfile* lp : loops) {
+        out << "  " << lineRange(lp->line, lp->endLine);
+        if (lp->line > 0) out << " (while 于 " << lp->line << ":" << lp->col << ")";
+        out << "  深度 " << lp->depth << "  进入 " << lp->entries << " 次  迭代 " << lp->iterations
+            << " 次（平均 " << fixedPoint((double)lp->iterations / lp->entries, 1) << "，最多 " << lp->maxTrip
+            << "）  指令 " << lp->instructions << " (" << fixedPoint(percent(lp->instructions, total), 1) << "%)\n";
+        out << "    每次进入的迭代次数:";
+        bool first = true;
+        for (size_t k = 0; k < lp->tripHistogram.size(); k++) {
+            if (lp->tripHistogram[k] == 0) continue;
+            out << (first ? " " : ", ") << bucketLabel((int)k) << " 次 x" << lp->tripHistogram[k];
+            first = false;
+        }
+        out << '\n';
+    }
+
+    // 基本块：按块内执行的指令数
+    vector<const BlockProfile*> blocks;
+    for (const auto& bp : profile.blocks) {
+        if (bp.count > 0) blocks.push_back(&bp);
+    }
+    stable_sort(blocks.begin(), blocks.end(), [](const BlockProfile* a, const BlockProfile* b) {
+        return a->instructions > b->instructions;
+    });
+    if (blocks.size() > (size_t)top) blocks.resize(top);
+    out << "最热的基本块:\n";
+    for (const BlockProfile* bp : blocks) {
+        out << "  B" << bp->id << " [" << bp->start << ", " << bp->end << ")  " << lineRange(bp->firstLine, bp->lastLine)
+            << "  执行 " << bp->count << " 次  指令 " << bp->instructions << " ("
+            << fixedPoint(percent(bp->instructions, total), 1) << "%)\n";
+    }
+
+    // 源程序行：按该行产生的指令的执行次数之和
+    map<int, long long> byLine;
+    for (size_t i = 0; i < code.size() && i < profile.instrCounts.size(); i++) {
+        if (profile.instrCounts[i] > 0) byLine[code[i].line] += profile.instrCounts[i];
+    }
+    vector<pair<int, long long>> lines(byLine.begin(), byLine.end());
+    stable_sort(lines.begin(), lines.end(), [](const pair<int, long long>& a, const pair<int, long long>& b) {
+        return a.second > b.second;
+    });
+    if (lines.size() > (size_t)top) lines.resize(top);
+    out << "最热的源程序行:\n";
+    for (const auto& kv : lines) {
+        out << "  " << lineRange(kv.first, kv.first) << "  指令 " << kv.second << " ("
+            << fixedPoint(percent(kv.second, total), 1) << "%)\n";
+    }
+}
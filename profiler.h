@@ -0,0 +1,63 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "types.h"
+#include "evaluator.h"
+#include "outsink.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === 执行剖析 ===
+// 在参考求值器上执行三地址码，统计每条指令、每个基本块和每个 while 循环的执行次数，
+// 再按指令与循环记录中的源位置把热点对应回源程序。
+// 循环按代码生成的循环记录划分：控制流到达条件判断的起始地址时，从循环外来的算一次进入，
+// 从循环内来的（回边或 continue）算一次迭代；离开 [testStart, exitAddr) 时结束这次进入。
+// 因此迭代次数是完整执行循环体的次数，以 break 离开的那一次不计。
+
+// 每次进入的迭代次数分布的桶：0 号桶为 0 次，k 号桶（k >= 1）为 [2^(k-1), 2^k) 次
+int tripBucket(long long trips);
+
+struct LoopProfile {
+    int record = -1;                // 在循环记录中的下标
+    int line = 0, col = 0;          // while 关键字的位置
+    int endLine = 0;                // 循环体右花括号所在行
+    int depth = 0;                  // 嵌套深度
+    long long entries = 0;          // 从循环外进入的次数
+    long long iterations = 0;       // 各次进入的迭代次数之和
+    long long maxTrip = 0;          // 单次进入的最多迭代次数
+    long long instructions = 0;     // 循环内（含内层循环）执行的指令数
+    vector<long long> tripHistogram;
+};
+
+struct BlockProfile {
+    int id = 0;                     // 块号
+    int start = 0, end = 0;         // 指令区间 [start, end)
+    int firstLine = 0, lastLine = 0;    // 块内指令源位置的行号范围，0 表示未知
+    long long count = 0;            // 执行次数（基本块只从第一条指令进入）
+    long long instructions = 0;     // 块内执行的指令数
+};
+
+struct ProfileResult {
+    EvalResult eval;                // 求值结果（步数、跳转次数、结束时的变量值）
+    int lastPc = -1;                // 最后执行的指令（运行时错误或达到步数上限时所在位置）
+    vector<long long> instrCounts;  // 每条指令的执行次数
+    vector<BlockProfile> blocks;    // 按块号
+    vector<LoopProfile> loops;      // 与循环记录一一对应
+};
+
+class TACProfiler {
+private:
+    TACEvaluator evaluator;
+
+public:
+    TACProfiler(const map<string, string>& varTypes, long long stepLimit = 10000000);
+
+    // 执行 code；loops 是这段代码的循环记录（地址必须与 code 一致），为空时只统计指令与基本块
+    ProfileResult run(const vector<TAC>& code, const vector<LoopRecord>& loops) const;
+
+    // 输出总体情况，以及最热的 top 个循环（按循环内执行的指令数）、基本块和源程序行
+    static void printReport(const ProfileResult& profile, const vector<TAC>& code, OutputSink& out, int top = 10);
+};
+
+#endif // PROFILER_H
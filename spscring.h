@@ -0,0 +1,55 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// === 单生产者/单消费者环形队列 ===
+// 一个线程只调用 tryPush，另一个线程只调用 tryPop，不加锁：
+//   - tail 只由生产者写，head 只由消费者写，各自放在单独的缓存行中；
+//   - 生产者先写入槽位再以 release 发布 tail，消费者以 acquire 读 tail 后才读槽位，反之亦然；
+//   - 容量固定（取 2 的幂），满时 tryPush 返回 false，由调用方等待，形成反压。
+// 元素按移动传递，适合放整批数据（如一批 token 的 vector）。
+template <typename T>
+class SPSCRing {
+private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> head;    // 下一个要读出的位置（消费者）
+    alignas(64) atomic<size_t> tail;    // 下一个要写入的位置（生产者）
+
+public:
+    explicit SPSCRing(size_t capacity) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    // 队列满时返回 false，value 保持不变
+    bool tryPush(T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = move(value);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    // 队列空时返回 false
+    bool tryPop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        value = move(slots[h & mask]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return slots.size(); }
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,649 @@
+#include "ssa.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include "tacutil.h"
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace std;
+
+SSAForm::SSAForm(const vector<TAC>& code, const map<string, string>& varTypes) : varTypes(varTypes) {
+    build(code);
+}
+
+bool SSAForm::isDeclared(const string& name) const {
+    return varTypes.count(baseName(name)) > 0;
+}
+
+bool SSAForm::isFloatVar(const string& name) const {
+    auto it = varTypes.find(baseName(name));
+    return it != varTypes.end() && it->second == "float";
+}
+
+int SSAForm::numPhis() const {
+    int n = 0;
+    for (const auto& bb : blocks) if (bb.live) n += (int)bb.phis.size();
+    return n;
+}
+
+// ============================================================================
+// 构造
+// ============================================================================
+
+void SSAForm::build(const vector<TAC>& input) {
+    // 入口块若是循环头（程序以 while 开始），φ 需要一条来自循环外的边：
+    // 在最前面垫一条 goto L1，使真正的入口块有两个前驱
+    vector<TAC> code = input;
+    bool entryIsTarget = false;
+    for (const auto& t : code) {
+        if (isJumpOp(t.op) && labelAddr(t.result) == 0) entryIsTarget = true;
+    }
+    if (entryIsTarget) {
+        for (auto& t : code) {
+            if (isJumpOp(t.op) && labelAddr(t.result) >= 0) t.result = makeLabel(labelAddr(t.result) + 1);
+        }
+        code.insert(code.begin(), TAC{ "goto", "", "", "L1", 0 });
+        for (int i = 0; i < (int)code.size(); i++) code[i].addr = i;
+    }
+
+    CFG cfg(code);
+    const vector<BasicBlock>& bbs = cfg.getBlocks();
+    int n = (int)code.size();
+    exitBlock = cfg.exit();
+    if (!cfg.reachable(exitBlock)) {
+        // 没有出口的程序（死循环）不存在“结束时的变量状态”，不做 SSA 优化
+        valid = false;
+        return;
+    }
+
+    blocks.assign(cfg.size(), SSABlock());
+    set<string> userVars;
+    for (const auto& bb : bbs) {
+        SSABlock& sb = blocks[bb.id];
+        sb.live = cfg.reachable(bb.id);
+        if (!sb.live) continue;
+        for (int i = bb.start; i < bb.end; i++) {
+            if (isJumpOp(code[i].op)) {
+                sb.jump = code[i];
+                int a = labelAddr(code[i].result);
+                sb.target = (a >= 0 && a < n) ? cfg.blockOf(a) : exitBlock;
+            } else {
+                sb.code.push_back(code[i]);
+            }
+            string d = defOf(code[i]);
+            if (isUserVar(d)) userVars.insert(d);
+            for (const auto& u : usesOf(code[i])) if (isUserVar(u)) userVars.insert(u);
+        }
+        if (bb.id != exitBlock && sb.jump.op != "goto") sb.next = bb.id + 1;
+        sb.succ = bb.succ;
+        for (int p : bb.pred) if (cfg.reachable(p)) sb.pred.push_back(p);
+    }
+
+    // φ 放置：每个名称从定值块出发求迭代支配边界，只在入口处活跃的块放置
+    LivenessAnalysis liveness(cfg);
+    vector<vector<int>> df = cfg.dominanceFrontiers();
+    map<string, set<int>> defBlocks;
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        if (!blocks[b].live) continue;
+        for (const auto& t : blocks[b].code) {
+            string d = defOf(t);
+            if (!d.empty()) defBlocks[d].insert(b);
+        }
+    }
+    for (auto& kv : defBlocks) {
+        const string& var = kv.first;
+        vector<int> work(kv.second.begin(), kv.second.end());
+        set<int> hasPhi;
+        while (!work.empty()) {
+            int x = work.back();
+            work.pop_back();
+            for (int y : df[x]) {
+                if (hasPhi.count(y) || !liveness.liveAtBlockEntry(y, var)) continue;
+                PhiNode phi;
+                phi.var = var;
+                phi.args.assign(blocks[y].pred.size(), var);
+                blocks[y].phis.push_back(phi);
+                hasPhi.insert(y);
+                if (kv.second.insert(y).second) work.push_back(y);
+            }
+        }
+    }
+
+    // 出口块把每个用户变量结束时的版本写回原名（重命名时填入）
+    for (const auto& v : userVars) blocks[exitBlock].code.push_back(TAC{ ":=", v, "", v, 0 });
+
+    map<string, vector<string>> stacks;
+    map<string, int> counter;
+    rename(cfg.entry(), cfg.dominatorTree(), stacks, counter);
+}
+
+// 沿支配树先序遍历：定值压入新版本，引用取栈顶版本，离开块时弹出本块压入的版本
+void SSAForm::rename(int b, const vector<vector<int>>& domChildren,
+                     map<string, vector<string>>& stacks, map<string, int>& counter) {
+    SSABlock& sb = blocks[b];
+    vector<string> pushed;
+    auto top = [&](const string& name) {
+        auto it = stacks.find(name);
+        return (it == stacks.end() || it->second.empty()) ? name : it->second.back();
+    };
+    auto fresh = [&](const string& var) {
+        string v = var + "." + to_string(++counter[var]);
+        stacks[var].push_back(v);
+        pushed.push_back(var);
+        return v;
+    };
+    auto renameUse = [&](string& s) {
+        if (!s.empty() && !isConstName(s)) s = top(s);
+    };
+
+    for (auto& phi : sb.phis) phi.result = fresh(phi.var);
+    for (auto& t : sb.code) {
+        renameUse(t.arg1);
+        renameUse(t.arg2);
+        if (b == exitBlock) continue;   // 出口写回的目标保持原名
+        string d = defOf(t);
+        if (!d.empty()) t.result = fresh(d);
+    }
+    if (isCondJumpOp(sb.jump.op)) renameUse(sb.jump.arg1);
+
+    if (b == exitBlock) {
+        // 结束时仍是初始值的变量不需要写回
+        vector<TAC> kept;
+        for (const auto& t : sb.code) if (t.arg1 != t.result) kept.push_back(t);
+        sb.code = kept;
+    }
+
+    for (int s : sb.succ) {
+        SSABlock& target = blocks[s];
+        int j = (int)(find(target.pred.begin(), target.pred.end(), b) - target.pred.begin());
+        for (auto& phi : target.phis) phi.args[j] = top(phi.var);
+    }
+    for (int c : domChildren[b]) rename(c, domChildren, stacks, counter);
+
+    for (const auto& var : pushed) stacks[var].pop_back();
+}
+
+void SSAForm::removeEdge(int from, int to) {
+    SSABlock& f = blocks[from];
+    SSABlock& t = blocks[to];
+    f.succ.erase(remove(f.succ.begin(), f.succ.end(), to), f.succ.end());
+    if (f.next == to) f.next = -1;
+    if (f.target == to) f.target = -1;
+    auto it = find(t.pred.begin(), t.pred.end(), from);
+    if (it == t.pred.end()) return;
+    int j = (int)(it - t.pred.begin());
+    t.pred.erase(it);
+    for (auto& phi : t.phis) phi.args.erase(phi.args.begin() + j);
+}
+
+// ============================================================================
+// 稀疏条件常量传播
+// ============================================================================
+// 格值：TOP（尚未确定）< CONST（某个常量）< BOTTOM（非常量）。只沿可执行边传播，
+// 条件是常量的跳转只有一条出边可执行，因此能发现普通常量传播看不到的不可达分支。
+// 保留原名的值是程序开始时变量的值（可能由外部给定），视为 BOTTOM。
+
+namespace {
+struct Cell {
+    enum State { TOP, CONST, BOTTOM } state = TOP;
+    ConstVal c;
+};
+
+bool sameConst(const ConstVal& a, const ConstVal& b) {
+    return a.isFloat == b.isFloat && formatConst(a) == formatConst(b);
+}
+}
+
+int SSAForm::propagateConstants() {
+    if (!valid) return 0;
+    int nb = (int)blocks.size();
+
+    // 定值与引用位置：下标 >= 0 是块内指令，-(k+1) 是第 k 个 φ，code.size() 是块末跳转
+    unordered_map<string, vector<pair<int, int>>> uses;
+    for (int b = 0; b < nb; b++) {
+        const SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        for (int k = 0; k < (int)sb.phis.size(); k++) {
+            for (const auto& a : sb.phis[k].args) if (!isConstName(a)) uses[a].push_back(make_pair(b, -(k + 1)));
+        }
+        for (int i = 0; i < (int)sb.code.size(); i++) {
+            for (const auto& u : usesOf(sb.code[i])) uses[u].push_back(make_pair(b, i));
+        }
+        if (isCondJumpOp(sb.jump.op) && !isConstName(sb.jump.arg1)) {
+            uses[sb.jump.arg1].push_back(make_pair(b, (int)sb.code.size()));
+        }
+    }
+
+    unordered_map<string, Cell> lattice;
+    set<pair<int, int>> execEdges;
+    vector<bool> visited(nb, false);
+    vector<pair<int, int>> flowWork, ssaWork;
+
+    auto valueOf = [&](const string& name) {
+        Cell c;
+        if (parseConst(name, c.c)) { c.state = Cell::CONST; return c; }
+        auto it = lattice.find(name);
+        if (it != lattice.end()) return it->second;
+        if (name.find('.') == string::npos) c.state = Cell::BOTTOM;
+        return c;
+    };
+    auto lower = [&](const string& name, const Cell& v) {
+        Cell old = valueOf(name);
+        if (old.state == Cell::BOTTOM || v.state == Cell::TOP) return;
+        Cell nv = v;
+        if (old.state == Cell::CONST && (v.state == Cell::BOTTOM || !sameConst(old.c, v.c))) nv.state = Cell::BOTTOM;
+        if (old.state == nv.state && (nv.state != Cell::CONST || sameConst(old.c, nv.c))) return;
+        lattice[name] = nv;
+        auto it = uses.find(name);
+        if (it != uses.end()) ssaWork.insert(ssaWork.end(), it->second.begin(), it->second.end());
+    };
+    auto markEdge = [&](int from, int to) {
+        if (to >= 0 && !execEdges.count(make_pair(from, to))) flowWork.push_back(make_pair(from, to));
+    };
+
+    auto evalPhi = [&](int b, int k) {
+        const SSABlock& sb = blocks[b];
+        const PhiNode& phi = sb.phis[k];
+        Cell r;
+        for (int j = 0; j < (int)sb.pred.size(); j++) {
+            if (!execEdges.count(make_pair(sb.pred[j], b))) continue;
+            Cell a = valueOf(phi.args[j]);
+            if (a.state == Cell::TOP) continue;
+            if (a.state == Cell::BOTTOM || (r.state == Cell::CONST && !sameConst(r.c, a.c))) {
+                r.state = Cell::BOTTOM;
+                break;
+            }
+            r = a;
+        }
+        lower(phi.result, r);
+    };
+    auto evalInstr = [&](int b, int i) {
+        const TAC& t = blocks[b].code[i];
+        string d = defOf(t);
+        if (d.empty()) return;
+        Cell r;
+        Cell a = valueOf(t.arg1);
+        Cell c2;
+        if (!t.arg2.empty()) c2 = valueOf(t.arg2);
+        else c2.state = Cell::CONST;
+        if (!isPureOp(t.op) || a.state == Cell::BOTTOM || c2.state == Cell::BOTTOM) {
+            r.state = Cell::BOTTOM;
+        } else if (a.state == Cell::TOP || c2.state == Cell::TOP) {
+            return;
+        } else {
+            bool ok = t.arg2.empty() ? foldUnary(t.op, a.c, r.c) : foldBinary(t.op, a.c, c2.c, r.c);
+            r.state = ok ? Cell::CONST : Cell::BOTTOM;
+            if (ok && isDeclared(d)) r.c = convertConst(r.c, isFloatVar(d));
+        }
+        lower(d, r);
+    };
+    auto evalJump = [&](int b) {
+        const SSABlock& sb = blocks[b];
+        if (sb.jump.op.empty()) { markEdge(b, sb.next); return; }
+        if (sb.jump.op == "goto") { markEdge(b, sb.target); return; }
+        Cell c = valueOf(sb.jump.arg1);
+        if (c.state == Cell::TOP) return;
+        if (c.state == Cell::BOTTOM) { markEdge(b, sb.target); markEdge(b, sb.next); return; }
+        bool taken = (sb.jump.op == "jz") == c.c.isZero();
+        markEdge(b, taken ? sb.target : sb.next);
+    };
+
+    flowWork.push_back(make_pair(-1, 0));
+    while (!flowWork.empty() || !ssaWork.empty()) {
+        if (!flowWork.empty()) {
+            pair<int, int> e = flowWork.back();
+            flowWork.pop_back();
+            int b = e.second;
+            if (e.first >= 0 && !execEdges.insert(e).second) continue;
+            for (int k = 0; k < (int)blocks[b].phis.size(); k++) evalPhi(b, k);
+            if (!visited[b]) {
+                visited[b] = true;
+                for (int i = 0; i < (int)blocks[b].code.size(); i++) evalInstr(b, i);
+                evalJump(b);
+            }
+        } else {
+            pair<int, int> u = ssaWork.back();
+            ssaWork.pop_back();
+            int b = u.first, i = u.second;
+            if (!visited[b]) continue;
+            if (i < 0) evalPhi(b, -i - 1);
+            else if (i == (int)blocks[b].code.size()) evalJump(b);
+            else evalInstr(b, i);
+        }
+    }
+
+    // 改写：删除不可执行的边和块，折叠常量条件跳转，常量替换引用
+    int changes = 0;
+    for (int b = 0; b < nb; b++) {
+        SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        if (!visited[b]) {
+            vector<int> succ = sb.succ;
+            for (int s : succ) removeEdge(b, s);
+            sb.live = false;
+            stats["SSA 删除不可达块"]++;
+            changes++;
+            continue;
+        }
+        vector<int> succ = sb.succ;
+        for (int s : succ) {
+            if (!execEdges.count(make_pair(b, s))) removeEdge(b, s);
+        }
+        if (isCondJumpOp(sb.jump.op) && valueOf(sb.jump.arg1).state == Cell::CONST) {
+            if (sb.target >= 0) {
+                sb.jump.op = "goto";
+                sb.jump.arg1 = "";
+                sb.next = -1;
+            } else {
+                sb.jump = TAC();
+            }
+            stats["SSA 条件跳转折叠"]++;
+            changes++;
+        }
+    }
+    auto replace = [&](string& s) {
+        if (s.empty() || isConstName(s)) return;
+        Cell c = valueOf(s);
+        if (c.state != Cell::CONST) return;
+        s = formatConst(c.c);
+        stats["SSA 常量传播"]++;
+        changes++;
+    };
+    for (auto& sb : blocks) {
+        if (!sb.live) continue;
+        for (auto& phi : sb.phis) for (auto& a : phi.args) replace(a);
+        for (auto& t : sb.code) {
+            replace(t.arg1);
+            replace(t.arg2);
+        }
+    }
+    return changes;
+}
+
+// ============================================================================
+// SSA 死代码删除
+// ============================================================================
+
+int SSAForm::eliminateDeadCode() {
+    if (!valid) return 0;
+    // 每个版本名恰有一个定值点：(块, 下标)，下标含义同常量传播
+    unordered_map<string, pair<int, int>> defSite;
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        const SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        for (int k = 0; k < (int)sb.phis.size(); k++) defSite[sb.phis[k].result] = make_pair(b, -(k + 1));
+        if (b == exitBlock) continue;
+        for (int i = 0; i < (int)sb.code.size(); i++) {
+            string d = defOf(sb.code[i]);
+            if (!d.empty()) defSite[d] = make_pair(b, i);
+        }
+    }
+
+    set<string> useful;
+    vector<string> work;
+    auto mark = [&](const string& name) {
+        if (name.empty() || isConstName(name) || !useful.insert(name).second) return;
+        work.push_back(name);
+    };
+    // 根：跳转条件与出口写回
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        const SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        if (isCondJumpOp(sb.jump.op)) mark(sb.jump.arg1);
+        if (b == exitBlock) for (const auto& t : sb.code) mark(t.arg1);
+    }
+    while (!work.empty()) {
+        string name = work.back();
+        work.pop_back();
+        auto it = defSite.find(name);
+        if (it == defSite.end()) continue;  // 程序开始时的值
+        const SSABlock& sb = blocks[it->second.first];
+        int i = it->second.second;
+        if (i < 0) {
+            for (const auto& a : sb.phis[-i - 1].args) mark(a);
+        } else {
+            for (const auto& u : usesOf(sb.code[i])) mark(u);
+        }
+    }
+
+    int removed = 0;
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        vector<PhiNode> phis;
+        for (const auto& phi : sb.phis) {
+            if (useful.count(phi.result)) phis.push_back(phi);
+            else removed++;
+        }
+        sb.phis = phis;
+        if (b == exitBlock) continue;
+        vector<TAC> code;
+        for (const auto& t : sb.code) {
+            string d = defOf(t);
+            if (d.empty() || !isPureOp(t.op) || useful.count(d)) code.push_back(t);
+            else removed++;
+        }
+        sb.code = code;
+    }
+    stats["SSA 删除死代码"] += removed;
+    return removed;
+}
+
+// ============================================================================
+// 销毁
+// ============================================================================
+
+// 按块号排列（拆分关键边新建的块排在原出口块之前），出口块放在最后，
+// 这样执行到出口块末尾即程序结束；顺序后继不是下一个块时补 goto
+vector<TAC> SSAForm::flatten() const {
+    vector<int> order;
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        if (blocks[b].live && b != exitBlock) order.push_back(b);
+    }
+    order.push_back(exitBlock);
+
+    vector<int> start(blocks.size(), 0);
+    vector<vector<TAC>> emitted(order.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        const SSABlock& sb = blocks[order[k]];
+        int after = (k + 1 < order.size()) ? order[k + 1] : -1;
+        vector<TAC>& out = emitted[k];
+        out = sb.code;
+        if (!sb.jump.op.empty() && !(sb.jump.op == "goto" && sb.target == after)) {
+            TAC j = sb.jump;
+            j.result = "B" + to_string(sb.target);
+            out.push_back(j);
+        }
+        if (sb.next >= 0 && sb.next != after) out.push_back(TAC{ "goto", "", "", "B" + to_string(sb.next), 0 });
+    }
+    int pos = 0;
+    for (size_t k = 0; k < order.size(); k++) {
+        start[order[k]] = pos;
+        pos += (int)emitted[k].size();
+    }
+
+    vector<TAC> code;
+    for (auto& block : emitted) {
+        for (auto& t : block) {
+            if (isJumpOp(t.op)) t.result = makeLabel(start[stoi(t.result.substr(1))]);
+            t.addr = (int)code.size();
+            code.push_back(t);
+        }
+    }
+    return code;
+}
+
+bool SSAForm::destruct(vector<TAC>& out) {
+    if (!valid) return false;
+
+    // 拆分关键边：前驱有多个后继时，复写不能放在前驱末尾
+    int original = (int)blocks.size();
+    for (int s = 0; s < original; s++) {
+        if (!blocks[s].live || blocks[s].phis.empty() || blocks[s].pred.size() < 2) continue;
+        for (int j = 0; j < (int)blocks[s].pred.size(); j++) {
+            int p = blocks[s].pred[j];
+            if (blocks[p].succ.size() < 2) continue;
+            SSABlock split;
+            split.jump = TAC{ "goto", "", "", "", 0 };
+            split.target = s;
+            split.pred.push_back(p);
+            split.succ.push_back(s);
+            int id = (int)blocks.size();
+            blocks.push_back(split);
+            SSABlock& pb = blocks[p];
+            replace(pb.succ.begin(), pb.succ.end(), s, id);
+            if (pb.target == s) pb.target = id;
+            if (pb.next == s) pb.next = id;
+            blocks[s].pred[j] = id;
+            stats["SSA 拆分关键边"]++;
+        }
+    }
+
+    // φ 展开为前驱末尾的复写。同一块的 φ 各自属于不同的原变量，实参也只会是
+    // 同一原变量的版本或常量，所以顺序执行这些复写不会互相覆盖
+    for (int s = 0; s < (int)blocks.size(); s++) {
+        SSABlock& sb = blocks[s];
+        if (!sb.live) continue;
+        vector<TAC> head;   // 只有一个前驱（其余边已被删除）时复写直接放在本块开头
+        for (const auto& phi : sb.phis) {
+            for (int j = 0; j < (int)sb.pred.size(); j++) {
+                const string& a = phi.args[j];
+                if (!isConstName(a) && baseName(a) != phi.var) return false;
+                if (a == phi.result) continue;
+                TAC copy{ ":=", a, "", phi.result, 0 };
+                if (sb.pred.size() == 1) head.push_back(copy);
+                else blocks[sb.pred[j]].code.push_back(copy);
+            }
+        }
+        sb.code.insert(sb.code.begin(), head.begin(), head.end());
+        sb.phis.clear();
+    }
+
+    vector<TAC> code = flatten();
+
+    // 干涉图：只记录同一原变量的版本之间的干涉。复写 a := b 不使 a 与 b 干涉
+    CFG cfg(code);
+    LivenessAnalysis liveness(cfg);
+    vector<BitVector> liveOut = liveness.liveOutPerInstruction();
+    map<string, set<string>> interfere;
+    for (int i = 0; i < (int)code.size(); i++) {
+        string d = defOf(code[i]);
+        if (d.empty()) continue;
+        string base = baseName(d);
+        for (int bit = liveOut[i].findNext(0); bit >= 0; bit = liveOut[i].findNext(bit + 1)) {
+            const string& l = liveness.nameOf(bit);
+            if (l == d || baseName(l) != base) continue;
+            if (code[i].op == ":=" && code[i].arg1 == l) continue;
+            interfere[d].insert(l);
+            interfere[l].insert(d);
+        }
+    }
+
+    // 合并：先合并复写两端，再把同一原变量余下的类两两尝试合并
+    map<string, string> parent;
+    map<string, set<string>> members, classInterfere;
+    auto addName = [&](const string& name) {
+        if (name.empty() || isConstName(name) || parent.count(name)) return;
+        parent[name] = name;
+        members[name].insert(name);
+        classInterfere[name] = interfere[name];
+    };
+    for (const auto& t : code) {
+        addName(defOf(t));
+        for (const auto& u : usesOf(t)) addName(u);
+    }
+    auto find = [&](string x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    auto unite = [&](const string& x, const string& y) {
+        string a = find(x), b = find(y);
+        if (a == b) return true;
+        for (const auto& m : members[b]) if (classInterfere[a].count(m)) return false;
+        parent[b] = a;
+        members[a].insert(members[b].begin(), members[b].end());
+        classInterfere[a].insert(classInterfere[b].begin(), classInterfere[b].end());
+        members.erase(b);
+        classInterfere.erase(b);
+        return true;
+    };
+    int coalesced = 0;
+    for (const auto& t : code) {
+        if (t.op != ":=" || isConstName(t.arg1) || baseName(t.arg1) != baseName(t.result)) continue;
+        if (find(t.arg1) != find(t.result) && unite(t.result, t.arg1)) coalesced++;
+    }
+    map<string, vector<string>> classesOfBase;
+    for (const auto& kv : members) classesOfBase[baseName(kv.first)].push_back(kv.first);
+    for (auto& kv : classesOfBase) {
+        vector<string> rest;
+        for (size_t k = 1; k < kv.second.size(); k++) {
+            if (!unite(kv.second[0], kv.second[k])) rest.push_back(kv.second[k]);
+        }
+        kv.second.resize(1);
+        kv.second.insert(kv.second.end(), rest.begin(), rest.end());
+    }
+
+    // 命名：每个原变量的第一个类取回原名；用户变量必须全部合并回原名，
+    // 否则结束时的变量状态会落在别的名字上，放弃本次 SSA 优化
+    int maxTemp = 0;
+    for (const auto& kv : parent) {
+        if (isTempName(kv.first)) maxTemp = max(maxTemp, stoi(baseName(kv.first).substr(1)));
+    }
+    map<string, string> nameOfClass;
+    for (const auto& kv : classesOfBase) {
+        if (kv.second.size() > 1 && !isTempName(kv.first)) {
+            stats["SSA 合并失败"]++;
+            return false;
+        }
+        nameOfClass[find(kv.second[0])] = kv.first;
+        for (size_t k = 1; k < kv.second.size(); k++) nameOfClass[find(kv.second[k])] = "T" + to_string(++maxTemp);
+    }
+
+    vector<bool> removed(code.size(), false);
+    for (int i = 0; i < (int)code.size(); i++) {
+        TAC& t = code[i];
+        if (!t.arg1.empty() && parent.count(t.arg1)) t.arg1 = nameOfClass[find(t.arg1)];
+        if (!t.arg2.empty() && parent.count(t.arg2)) t.arg2 = nameOfClass[find(t.arg2)];
+        if (!isJumpOp(t.op)) t.result = nameOfClass[find(t.result)];
+        if (t.op == ":=" && t.arg1 == t.result) removed[i] = true;
+    }
+    compactTAC(code, removed);
+    stats["SSA 复写合并"] += coalesced;
+    out = code;
+    return true;
+}
+
+// ============================================================================
+// 输出
+// ============================================================================
+
+void SSAForm::print(OutputSink& out) const {
+    if (!valid) {
+        out << "(程序没有可达的出口，未构造 SSA)\n";
+        return;
+    }
+    auto printInstr = [&out](const TAC& t) {
+        out << "    " << pad(t.result, 12) << " := ";
+        if (t.op == ":=") out << t.arg1;
+        else if (t.arg2.empty()) out << t.op << " " << t.arg1;
+        else out << pad(t.arg1, 10) << " " << pad(t.op, 4) << " " << t.arg2;
+        out << '\n';
+    };
+    for (int b = 0; b < (int)blocks.size(); b++) {
+        const SSABlock& sb = blocks[b];
+        if (!sb.live) continue;
+        out << "B" << b << (b == exitBlock ? " (出口)" : "") << ":  前驱:";
+        for (int p : sb.pred) out << " B" << p;
+        out << '\n';
+        for (const auto& phi : sb.phis) {
+            out << "    " << pad(phi.result, 12) << " := φ(";
+            for (size_t j = 0; j < phi.args.size(); j++) out << (j ? ", " : "") << phi.args[j];
+            out << ")\n";
+        }
+        for (const auto& t : sb.code) printInstr(t);
+        if (sb.jump.op == "goto") out << "    goto B" << sb.target << '\n';
+        else if (sb.jump.op == "jz") out << "    if " << sb.jump.arg1 << " == 0 goto B" << sb.target << '\n';
+        else if (sb.jump.op == "jnz") out << "    if " << sb.jump.arg1 << " != 0 goto B" << sb.target << '\n';
+    }
+}
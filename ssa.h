@@ -0,0 +1,75 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "types.h"
+#include "outsink.h"
+#include <vector>
+#include <map>
+#include <string>
+
+// === 静态单赋值形式 (SSA) ===
+// 构造：Cytron 算法，在定值块的迭代支配边界放置 φ 函数（只放在变量入口活跃的块，即剪枝 SSA），
+// 再沿支配树把每个定值重命名为版本名 x.1, x.2, ...；未经定值就被引用的值保留原名，
+// 表示程序开始时变量的值。出口块为每个用户变量追加 x := x.k，把结束时的版本写回原名。
+// 销毁：把 φ 展开为前驱末尾的复写（必要时拆分关键边），再按干涉关系把同一变量的
+// 各版本合并回原名，合并后两端同名的复写随之消失。
+
+// ----------------------------------------------------------------------------
+// φ 函数 (PhiNode)
+// ----------------------------------------------------------------------------
+struct PhiNode {
+    string var;             // 原变量名
+    string result;          // 定值的版本名
+    vector<string> args;    // 与所在块的 pred 一一对应，可以是常量
+};
+
+// ----------------------------------------------------------------------------
+// SSA 基本块 (SSABlock)
+// ----------------------------------------------------------------------------
+struct SSABlock {
+    vector<PhiNode> phis;
+    vector<TAC> code;       // 块内指令，不含块末跳转
+    TAC jump;               // 块末跳转，op 为空表示没有
+    int target = -1;        // 跳转目标块
+    int next = -1;          // 顺序执行到达的块，-1 表示没有（块末为 goto 或出口块）
+    vector<int> succ, pred;
+    bool live = true;       // 不可达块构造时即标记为 false，不参与任何计算
+};
+
+class SSAForm {
+private:
+    vector<SSABlock> blocks;
+    int exitBlock = 0;
+    bool valid = true;              // 出口不可达等情况下放弃 SSA 优化
+    map<string, string> varTypes;   // 显式声明的变量类型，版本名按原名查
+    map<string, int> stats;         // 各动作的触发次数
+
+    bool isDeclared(const string& name) const;
+    bool isFloatVar(const string& name) const;
+
+    void build(const vector<TAC>& code);
+    void rename(int b, const vector<vector<int>>& domChildren,
+                map<string, vector<string>>& stacks, map<string, int>& counter);
+    void removeEdge(int from, int to);
+    vector<TAC> flatten() const;
+
+public:
+    SSAForm(const vector<TAC>& code, const map<string, string>& varTypes);
+
+    bool isValid() const { return valid; }
+    int numPhis() const;
+
+    // 稀疏条件常量传播（Wegman-Zadeck）：常量替换引用，常量条件跳转折叠，
+    // 删除永不执行的边和块，返回改动次数
+    int propagateConstants();
+    // 基于 SSA 的死代码删除：从跳转和出口写回出发标记有用的定值，删除其余定值与 φ，返回删除条数
+    int eliminateDeadCode();
+
+    // 转回普通三地址码；无法把某个用户变量的全部版本合并回原名时返回 false
+    bool destruct(vector<TAC>& out);
+
+    void print(OutputSink& out) const;
+    const map<string, int>& getStats() const { return stats; }
+};
+
+#endif // SSA_H
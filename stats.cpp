@@ -0,0 +1,150 @@
+#include "stats.h"
+
+Stats::Stats() : origin(chrono::steady_clock::now()) {}
+
+long long Stats::nowNs() const {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+int Stats::beginSpan(const string& name, const string& category) {
+    spans.push_back({ name, category, nowNs(), 0, openSpans++, 1 });
+    return (int)spans.size() - 1;
+}
+
+void Stats::endSpan(int id) {
+    spans[id].durNs = nowNs() - spans[id].startNs;
+    openSpans--;
+}
+
+void Stats::addSpan(const string& name, const string& category, long long startNs, long long endNs, int tid) {
+    spans.push_back({ name, category, startNs, endNs - startNs, openSpans, tid });
+}
+
+void Stats::setMax(const string& counter, long long value) {
+    auto it = counters.find(counter);
+    if (it == counters.end()) counters[counter] = value;
+    else if (value > it->second) it->second = value;
+}
+
+void Stats::addTo(const string& group, const string& key, long long n) {
+    auto it = groups.find(group);
+    if (it == groups.end()) {
+        groupOrder.push_back(group);
+        it = groups.insert({ group, Group() }).first;
+    }
+    auto value = it->second.values.find(key);
+    if (value == it->second.values.end()) {
+        it->second.keys.push_back(key);
+        it->second.values[key] = n;
+    } else {
+        value->second += n;
+    }
+}
+
+long long Stats::counter(const string& name) const {
+    auto it = counters.find(name);
+    return it == counters.end() ? 0 : it->second;
+}
+
+static string jsonString(const string& s) {
+    string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        if ((unsigned char)c < 0x20) { r += ' '; continue; }
+        r += c;
+    }
+    return r + "\"";
+}
+
+// 纳秒按毫秒/微秒输出，保留三位小数
+static FixedField scaled(long long ns, long long unit) {
+    return fixedPoint((double)ns / (double)unit, 3);
+}
+
+void Stats::writeJSON(OutputSink& out) const {
+    // 计时按名字汇总，保持第一次出现的顺序
+    vector<string> order;
+    map<string, pair<long long, long long>> timers;     // 名字 -> (次数, 总纳秒)
+    map<string, int> depthOf;
+    for (const auto& s : spans) {
+        auto it = timers.find(s.name);
+        if (it == timers.end()) {
+            order.push_back(s.name);
+            depthOf[s.name] = s.depth;
+            it = timers.insert({ s.name, { 0, 0 } }).first;
+        }
+        it->second.first++;
+        it->second.second += s.durNs;
+    }
+
+    out << "{\n  \"timers\": [";
+    for (size_t i = 0; i < order.size(); i++) {
+        const auto& t = timers.at(order[i]);
+        out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(order[i]) << ", \"depth\": " << depthOf.at(order[i])
+            << ", \"calls\": " << t.first << ", \"total_ms\": " << scaled(t.second, 1000000) << "}";
+    }
+    out << "\n  ],\n  \"counters\": {";
+    bool first = true;
+    for (const auto& kv : counters) {
+        out << (first ? "\n" : ",\n") << "    " << jsonString(kv.first) << ": " << kv.second;
+        first = false;
+    }
+    out << "\n  }";
+    for (const auto& name : groupOrder) {
+        out << ",\n  " << jsonString(name) << ": {";
+        first = true;
+        const Group& g = groups.at(name);
+        for (const auto& key : g.keys) {
+            out << (first ? "\n" : ",\n") << "    " << jsonString(key) << ": " << g.values.at(key);
+            first = false;
+        }
+        out << "\n  }";
+    }
+    out << "\n}\n";
+}
+
+bool Stats::writeJSON(const string& path, string& error) const {
+    OutputSink out(path);
+    if (!out.ok()) {
+        error = "无法写入 '" + path + "'";
+        return false;
+    }
+    writeJSON(out);
+    return true;
+}
+
+bool Stats::writeTrace(const string& path, string& error) const {
+    OutputSink out(path);
+    if (!out.ok()) {
+        error = "无法写入 '" + path + "'";
+        return false;
+    }
+    out << "{\"traceEvents\": [\n";
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"while-compiler\"}}";
+    for (const auto& kv : threadNames) {
+        out << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << kv.first
+            << ", \"args\": {\"name\": " << jsonString(kv.second) << "}}";
+    }
+    for (const auto& s : spans) {
+        out << ",\n  {\"name\": " << jsonString(s.name) << ", \"cat\": " << jsonString(s.category)
+            << ", \"ph\": \"X\", \"ts\": " << scaled(s.startNs, 1000) << ", \"dur\": " << scaled(s.durNs, 1000)
+            << ", \"pid\": 1, \"tid\": " << s.tid << "}";
+    }
+    out << "\n],\n\"displayTimeUnit\": \"ms\",\n\"otherData\": {";
+    bool first = true;
+    for (const auto& kv : counters) {
+        out << (first ? "\n  " : ",\n  ") << jsonString(kv.first) << ": " << kv.second;
+        first = false;
+    }
+    out << "\n}}\n";
+    out.flush();
+    return true;
+}
+
+ScopedTimer::ScopedTimer(Stats* stats, const char* name, const char* category) : stats(stats) {
+    if (stats) id = stats->beginSpan(name, category);
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (stats) stats->endSpan(id);
+}
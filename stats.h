@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "outsink.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+// === 编译过程的计时与计数 ===
+// 计时区间和计数器始终开启：区间只在阶段边界各取一次时钟，热循环里的计数先累加在局部整数中，
+// 阶段结束时再一次性记入。--stats 以 JSON 输出汇总，--trace-out 把计时区间写成
+// Chrome / Perfetto 可以打开的 trace 事件文件。同一个对象上多次编译的结果累加。
+class Stats {
+public:
+    struct Span {
+        string name;
+        string category;
+        long long startNs;      // 相对于对象创建时刻
+        long long durNs;
+        int depth;              // 嵌套层数，0 为最外层
+        int tid;                // trace 中的线程编号，编译线程为 1
+    };
+
+private:
+    chrono::steady_clock::time_point origin;
+    vector<Span> spans;
+    int openSpans = 0;
+    map<string, long long> counters;
+    // 分组计数，如各产生式的归约次数；组和组内的键都按第一次记入的顺序输出
+    struct Group {
+        vector<string> keys;
+        map<string, long long> values;
+    };
+    map<string, Group> groups;
+    vector<string> groupOrder;
+    map<int, string> threadNames;   // trace 中线程编号 -> 名字
+
+public:
+    Stats();
+
+    long long nowNs() const;
+    // 计时区间：begin 返回区间编号，end 填入时长（由 ScopedTimer 成对调用）
+    int beginSpan(const string& name, const string& category);
+    void endSpan(int id);
+    // 其他线程测得的区间（起止时刻由 nowNs() 取得）：Stats 不是线程安全的，
+    // 由编译线程在工作线程结束后补记
+    void addSpan(const string& name, const string& category, long long startNs, long long endNs, int tid);
+    void setThreadName(int tid, const string& name) { threadNames[tid] = name; }
+
+    void add(const string& counter, long long n = 1) { counters[counter] += n; }
+    void setMax(const string& counter, long long value);
+    void addTo(const string& group, const string& key, long long n = 1);
+
+    const vector<Span>& getSpans() const { return spans; }
+    long long counter(const string& name) const;
+
+    // 按名字汇总的计时（调用次数、总时长）、计数器和各分组，整体为一个 JSON 对象
+    void writeJSON(OutputSink& out) const;
+    bool writeJSON(const string& path, string& error) const;
+    // Chrome trace 事件格式（"X" 完整事件，时间单位微秒），计数器附在 otherData 中
+    bool writeTrace(const string& path, string& error) const;
+};
+
+// 作用域计时：构造时开始，析构时结束；stats 为空时不做任何事
+class ScopedTimer {
+private:
+    Stats* stats;
+    int id = -1;
+
+public:
+    ScopedTimer(Stats* stats, const char* name, const char* category = "compiler");
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#endif // STATS_H
@@ -0,0 +1,248 @@
+#include "tacutil.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+bool isJumpOp(const string& op) {
+    return op == "goto" || op == "jz" || op == "jnz";
+}
+
+bool isCondJumpOp(const string& op) {
+    return op == "jz" || op == "jnz";
+}
+
+// 解析 "L<n>" 形式的标号；PENDING_EXIT 等占位符返回 -1
+int labelAddr(const string& label) {
+    if (label.length() < 2 || label[0] != 'L') return -1;
+    int v = 0;
+    for (size_t k = 1; k < label.length(); k++) {
+        if (!isdigit((unsigned char)label[k])) return -1;
+        v = v * 10 + (label[k] - '0');
+    }
+    return v;
+}
+
+string makeLabel(int addr) {
+    return "L" + to_string(addr);
+}
+
+string baseName(const string& name) {
+    if (isConstName(name)) return name;
+    size_t dot = name.find('.');
+    return dot == string::npos ? name : name.substr(0, dot);
+}
+
+// newTemp() 生成的临时变量形如 T1, T2, ...
+bool isTempName(const string& name) {
+    string base = baseName(name);
+    if (base.length() < 2 || base[0] != 'T') return false;
+    for (size_t k = 1; k < base.length(); k++) {
+        if (!isdigit((unsigned char)base[k])) return false;
+    }
+    return true;
+}
+
+bool isUserVar(const string& name) {
+    return !name.empty() && !isConstName(name) && name.find('.') == string::npos && !isTempName(name);
+}
+
+bool isConstName(const string& name) {
+    if (name.empty()) return false;
+    if (name == "true" || name == "false") return true;
+    size_t k = (name[0] == '-') ? 1 : 0;
+    return k < name.length() && (isdigit((unsigned char)name[k]) || name[k] == '.');
+}
+
+bool parseConst(const string& name, ConstVal& out) {
+    if (name == "true") { out = ConstVal(); out.i = 1; return true; }
+    if (name == "false") { out = ConstVal(); return true; }
+    if (!isConstName(name)) return false;
+
+    bool isFloat = name.find_first_of(".eE") != string::npos;
+    char* end = nullptr;
+    out = ConstVal();
+    if (isFloat) {
+        out.isFloat = true;
+        out.f = strtof(name.c_str(), &end);
+    } else {
+        long long v = strtoll(name.c_str(), &end, 10);
+        if (v < INT_MIN || v > INT_MAX) return false;  // 超出int范围的字面量不参与折叠
+        out.i = (int)v;
+    }
+    return end && *end == '\0';
+}
+
+// 浮点常量始终带小数点或指数，保证重新解析后仍为浮点
+string formatConst(const ConstVal& v) {
+    if (!v.isFloat) return to_string(v.i);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", (double)v.f);
+    string s = buf;
+    if (s.find_first_of(".eE") == string::npos) s += ".0";
+    return s;
+}
+
+ConstVal convertConst(const ConstVal& v, bool toFloat) {
+    ConstVal r;
+    r.isFloat = toFloat;
+    if (toFloat) r.f = v.isFloat ? v.f : (float)v.i;
+    else r.i = v.isFloat ? (int)v.f : v.i;  // 浮点转整数向零截断
+    return r;
+}
+
+static ConstVal makeInt(int x) {
+    ConstVal r;
+    r.i = x;
+    return r;
+}
+
+bool isFloatOp(const string& op) {
+    return op.length() > 1 && op.back() == '.';
+}
+
+bool isConversionOp(const string& op) {
+    return op == "itof" || op == "ftoi";
+}
+
+string scalarOp(const string& op) {
+    return isFloatOp(op) ? op.substr(0, op.length() - 1) : op;
+}
+
+string floatOp(const string& op) {
+    return op + ".";
+}
+
+bool foldBinary(const string& op, const ConstVal& a, const ConstVal& b, ConstVal& out) {
+    if (isFloatOp(op)) return foldBinary(scalarOp(op), convertConst(a, true), convertConst(b, true), out);
+    // 逻辑运算只看真假，结果总是整数 0/1
+    if (op == "&&") { out = makeInt(!a.isZero() && !b.isZero()); return true; }
+    if (op == "||") { out = makeInt(!a.isZero() || !b.isZero()); return true; }
+
+    bool useFloat = a.isFloat || b.isFloat;  // 混合运算按C语言规则提升为float
+    if (op == ">" || op == "<" || op == "==" || op == ">=" || op == "<=" || op == "!=") {
+        bool r;
+        if (useFloat) {
+            float x = convertConst(a, true).f, y = convertConst(b, true).f;
+            r = op == ">" ? x > y : op == "<" ? x < y : op == "==" ? x == y
+              : op == ">=" ? x >= y : op == "<=" ? x <= y : x != y;
+        } else {
+            int x = a.i, y = b.i;
+            r = op == ">" ? x > y : op == "<" ? x < y : op == "==" ? x == y
+              : op == ">=" ? x >= y : op == "<=" ? x <= y : x != y;
+        }
+        out = makeInt(r);
+        return true;
+    }
+
+    if (op != "+" && op != "-" && op != "*" && op != "/") return false;
+    if (useFloat) {
+        float x = convertConst(a, true).f, y = convertConst(b, true).f;
+        float r = op == "+" ? x + y : op == "-" ? x - y : op == "*" ? x * y : x / y;
+        if (!std::isfinite(r)) return false;
+        out = ConstVal();
+        out.isFloat = true;
+        out.f = r;
+        return true;
+    }
+    unsigned x = (unsigned)a.i, y = (unsigned)b.i;
+    if (op == "+") out = makeInt((int)(x + y));
+    else if (op == "-") out = makeInt((int)(x - y));
+    else if (op == "*") out = makeInt((int)(x * y));
+    else {
+        if (b.i == 0 || (a.i == INT_MIN && b.i == -1)) return false;  // 运行时错误保留给执行期
+        out = makeInt(a.i / b.i);
+    }
+    return true;
+}
+
+bool foldUnary(const string& op, const ConstVal& a, ConstVal& out) {
+    if (op == "!") { out = makeInt(a.isZero()); return true; }
+    if (op == "neg") {
+        out = a;
+        if (a.isFloat) out.f = -a.f;
+        else out.i = (int)(0u - (unsigned)a.i);
+        return true;
+    }
+    if (op == ":=") { out = a; return true; }
+    if (op == "neg.") return foldUnary("neg", convertConst(a, true), out);
+    if (isConversionOp(op)) { out = convertConst(a, op == "itof"); return true; }
+    return false;
+}
+
+string defOf(const TAC& t) {
+    if (isJumpOp(t.op)) return "";
+    return t.result;
+}
+
+vector<string> usesOf(const TAC& t) {
+    vector<string> u;
+    if (t.op == "goto") return u;
+    if (!t.arg1.empty() && !isConstName(t.arg1)) u.push_back(t.arg1);
+    if (!isCondJumpOp(t.op) && !t.arg2.empty() && !isConstName(t.arg2)) u.push_back(t.arg2);
+    return u;
+}
+
+bool isPureOp(const string& op) {
+    return !isJumpOp(op) && op != "decl";
+}
+
+vector<int> findLeaders(const vector<TAC>& code) {
+    int n = (int)code.size();
+    vector<bool> leader(n + 1, false);
+    if (n > 0) leader[0] = true;
+    for (int i = 0; i < n; i++) {
+        if (!isJumpOp(code[i].op)) continue;
+        int target = labelAddr(code[i].result);
+        if (target >= 0 && target < n) leader[target] = true;
+        leader[i + 1] = true;
+    }
+    vector<int> leaders;
+    for (int i = 0; i < n; i++) if (leader[i]) leaders.push_back(i);
+    leaders.push_back(n);
+    return leaders;
+}
+
+vector<vector<int>> blockSuccessors(const vector<TAC>& code, const vector<int>& leaders) {
+    int n = (int)code.size();
+    int nb = (int)leaders.size() - 1;
+    vector<int> blockOf(n + 1, nb);  // 地址 -> 所在基本块，n（程序出口）对应虚拟块 nb
+    for (int b = 0; b < nb; b++) {
+        for (int i = leaders[b]; i < leaders[b + 1]; i++) blockOf[i] = b;
+    }
+    vector<vector<int>> succ(nb);
+    for (int b = 0; b < nb; b++) {
+        const TAC& last = code[leaders[b + 1] - 1];
+        if (isJumpOp(last.op)) {
+            int target = labelAddr(last.result);
+            succ[b].push_back(blockOf[max(0, min(target, n))]);
+        }
+        if (last.op != "goto") succ[b].push_back(b + 1);
+    }
+    return succ;
+}
+
+void compactTAC(vector<TAC>& code, const vector<bool>& removed) {
+    int n = (int)code.size();
+    // keptBefore[i]：下标 i 之前保留的指令数，即原地址 i 在新序列中的地址
+    vector<int> keptBefore(n + 1, 0);
+    for (int i = 0; i < n; i++) keptBefore[i + 1] = keptBefore[i] + (removed[i] ? 0 : 1);
+
+    vector<TAC> out;
+    out.reserve(keptBefore[n]);
+    for (int i = 0; i < n; i++) {
+        if (removed[i]) continue;
+        TAC t = move(code[i]);
+        if (isJumpOp(t.op)) {
+            int target = labelAddr(t.result);
+            if (target >= 0) t.result = makeLabel(keptBefore[min(target, n)]);
+        }
+        t.addr = (int)out.size();
+        out.push_back(t);
+    }
+    code.swap(out);
+}
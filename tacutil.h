@@ -0,0 +1,71 @@
+#ifndef TACUTIL_H
+#define TACUTIL_H
+
+#include "types.h"
+#include <vector>
+#include <string>
+
+// === 三地址码公共工具 ===
+// 各优化遍共用的辅助函数：跳转/标号解析、常量求值、定值/引用提取、基本块划分、指令压缩
+
+// ----------------------------------------------------------------------------
+// 常量值 (ConstVal)
+// ----------------------------------------------------------------------------
+// 编译期已知的常量，整数按C语言int语义（32位补码回绕），浮点按C语言float语义
+struct ConstVal {
+    bool isFloat = false;  // 是否为浮点常量
+    int i = 0;             // 整数值
+    float f = 0.0f;        // 浮点值
+
+    double asDouble() const { return isFloat ? (double)f : (double)i; }
+    bool isZero() const { return isFloat ? f == 0.0f : i == 0; }
+};
+
+// 跳转类指令判断
+bool isJumpOp(const string& op);       // goto / jz / jnz
+bool isCondJumpOp(const string& op);   // jz / jnz
+
+// 标号 "L<n>" 与地址互转，非标号返回 -1
+int labelAddr(const string& label);
+string makeLabel(int addr);
+
+// 名称分类
+// SSA 形式中的版本名形如 x.3（'.' 不会出现在标识符中），baseName 去掉版本后缀
+string baseName(const string& name);
+bool isTempName(const string& name);   // 形如 T<n>（或其版本 T<n>.k）的临时变量
+bool isUserVar(const string& name);    // 源程序中的变量（不含临时变量和版本名）
+bool isConstName(const string& name);  // 数字常量或 true/false
+
+// 常量解析与格式化
+bool parseConst(const string& name, ConstVal& out);
+string formatConst(const ConstVal& v);
+ConstVal convertConst(const ConstVal& v, bool toFloat);
+
+// 类型化运算符：代码生成器为 float 运算生成带 '.' 后缀的运算符（+. -. *. /. <. <=. >. >=. ==. !=. neg.），
+// 不带后缀的算术、关系运算和 neg 只用于 int 操作数；itof / ftoi 是显式的 int -> float / float -> int 转换
+bool isFloatOp(const string& op);
+bool isConversionOp(const string& op);    // itof / ftoi
+string scalarOp(const string& op);         // 去掉 float 运算符的后缀，"+." -> "+"
+string floatOp(const string& op);          // "+" -> "+."
+
+// 常量折叠：成功返回 true，除零、溢出(INT_MIN/-1)及非有限浮点结果不折叠
+// float 运算符先把两个操作数都转为 float；不带后缀的运算符遇到 float 操作数时按C语言规则提升
+bool foldBinary(const string& op, const ConstVal& a, const ConstVal& b, ConstVal& out);
+bool foldUnary(const string& op, const ConstVal& a, ConstVal& out);
+
+// 指令的定值与引用
+string defOf(const TAC& t);               // 被定值的名称，没有则为空串
+vector<string> usesOf(const TAC& t);      // 被引用的非常量名称
+bool isPureOp(const string& op);          // 无副作用、只依赖操作数的计算类指令
+
+// 基本块：返回每个基本块的起始下标（升序），最后附加 code.size() 作为哨兵
+vector<int> findLeaders(const vector<TAC>& code);
+
+// 基本块后继：succ[b] 为块 b 的后继块号，块号 leaders.size()-1 表示程序出口
+vector<vector<int>> blockSuccessors(const vector<TAC>& code, const vector<int>& leaders);
+
+// 删除 removed[i] 为 true 的指令，并重新编号地址与跳转标号
+// 指向被删除指令的跳转重定向到其后第一条保留的指令
+void compactTAC(vector<TAC>& code, const vector<bool>& removed);
+
+#endif // TACUTIL_H
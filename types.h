@@ -104,6 +104,42 @@ struct TAC {
     string arg2;    // 第二个操作数
     string result;  // 结果变量
     int addr;       // 指令地址：用于跳转指令的目标地址
+    int line;       // 源位置：生成该指令的产生式在源程序中的起始行号、列号
+    int col;        // （0 表示未知，如优化器插入的指令；列表初始化时省略即为 0）
+};
+
+// ----------------------------------------------------------------------------
+// 循环记录 (LoopRecord)
+// ----------------------------------------------------------------------------
+// CodeGenerator 在 exitLoop 时记录每个 while 循环的地址范围和嵌套深度
+// 供控制流分析核对识别出的自然循环
+struct LoopRecord {
+    int testStart;  // 条件判断代码的起始地址（loopAddrStack 中记录的地址）
+    int backEdge;   // 回跳 goto 指令的地址
+    int exitAddr;   // 循环结束地址
+    int depth;      // 嵌套深度（最外层为 1）
+    int line;       // 源位置：while 关键字的行号、列号
+    int col;
+    int endLine;    // 循环体右花括号的行号
+};
+
+// ----------------------------------------------------------------------------
+// 诊断信息 (Diagnostic)
+// ----------------------------------------------------------------------------
+// 词法、语法和类型检查发现的问题，带源程序中的位置
+// message 是完整的诊断文本（与命令行输出的相同），调用方可以直接显示
+enum class DiagnosticKind {
+    LEXICAL,    // 词法错误：非法字符、未闭合的注释等
+    SYNTAX,     // 语法错误：分析表中没有对应的动作
+    TYPE        // 类型错误（重复声明为另一种类型）和类型警告（float 赋给 int）
+};
+
+struct Diagnostic {
+    DiagnosticKind kind;
+    bool isError;   // false 表示警告，不影响编译结果
+    int line;       // 行号，从 1 开始
+    int col;        // 列号，从 1 开始；0 表示只能定位到行
+    string message;
 };
 
 // ----------------------------------------------------------------------------
@@ -111,8 +147,19 @@ struct TAC {
 // ----------------------------------------------------------------------------
 // 语义分析栈中的项，存储语法分析过程中需要的语义信息
 // 主要用于代码生成时传递变量名、临时变量等信息
+// 条件表达式按短路跳转翻译：trueList/falseList 是条件为真/假时跳出、尚待回填的跳转指令下标。
+// name 非空时表示条件的最后一个值还没有生成跳转（negated 表示取反）；
+// name 为空时代码顺序执行到末尾即表示条件为 fallTrue
+// line/col 是该项在源程序中的起始位置：移进时取自 Word，归约时取产生式右部第一个有位置的符号
 struct SemItem {
     string name;    // 名称：变量名或临时变量名
+    string type;    // 值的静态类型 "int"/"float"（语句、条件等非值项为空）
+    vector<int> trueList;
+    vector<int> falseList;
+    bool negated;
+    bool fallTrue;
+    int line;
+    int col;
 };
 
 #endif // TYPES_H
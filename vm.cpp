@@ -0,0 +1,650 @@
+#include "vm.h"
+#include "cfg.h"
+#include "dataflow.h"
+#include <set>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+// GCC/Clang 支持标号取地址（labels as values），用计算跳转分派；
+// 编译时定义 WHILE_VM_SWITCH 可强制使用 switch 分派以便对比
+#if defined(__GNUC__) && !defined(WHILE_VM_SWITCH)
+#define VM_THREADED 1
+#endif
+
+namespace {
+
+const char* const opNames[] = {
+    "END", "MOV", "ITOF", "FTOI",
+    "ADDI", "SUBI", "MULI", "DIVI", "NEGI", "NOTI",
+    "ADDF", "SUBF", "MULF", "DIVF", "NEGF", "NOTF",
+    "LTI", "LEI", "GTI", "GEI", "EQI", "NEI",
+    "LTF", "LEF", "GTF", "GEF", "EQF", "NEF",
+    "ANDI", "ORI",
+    "GOTO", "JZI", "JNZI", "JZF", "JNZF",
+    "JLTI", "JLEI", "JGTI", "JGEI", "JEQI", "JNEI",
+    "GEN", "GJZ", "GJNZ",
+};
+
+// 通用指令的运算符编号即在此表中的下标
+const char* const genericOps[] = { "+", "-", "*", "/", "<", "<=", ">", ">=", "==", "!=", "&&", "||", "neg", "!", ":=",
+                                   "+.", "-.", "*.", "/.", "<.", "<=.", ">.", ">=.", "==.", "!=.", "neg.", "itof", "ftoi" };
+const int numGenericOps = sizeof(genericOps) / sizeof(genericOps[0]);
+
+int genericIndex(const string& op) {
+    for (int k = 0; k < numGenericOps; k++) if (op == genericOps[k]) return k;
+    return -1;
+}
+
+bool isArith(const string& op) { return op == "+" || op == "-" || op == "*" || op == "/"; }
+bool isRelop(const string& op) {
+    return op == "<" || op == "<=" || op == ">" || op == ">=" || op == "==" || op == "!=";
+}
+
+int relIndex(const string& op) {
+    static const char* const rel[] = { "<", "<=", ">", ">=", "==", "!=" };
+    for (int k = 0; k < 6; k++) if (op == rel[k]) return k;
+    return -1;
+}
+
+// jz 在条件为假时跳转，融合后取关系的否定：< 与 >=、<= 与 >、== 与 != 互为否定
+const int negatedRel[6] = { 3, 2, 1, 0, 5, 4 };
+
+SlotType join(SlotType a, SlotType b) {
+    if (a == SlotType::UNKNOWN) return b;
+    if (b == SlotType::UNKNOWN || a == b) return a;
+    return SlotType::DYN;
+}
+
+} // namespace
+
+TACVM::TACVM(const vector<TAC>& tac, const map<string, string>& varTypes) {
+    vector<TAC> split = splitTempWebs(tac);
+    inferTypes(split, varTypes);
+    lower(split);
+}
+
+// 优化器的临时变量复用会让 int 和 float 结果共用一个名字，按类型推断会得到 DYN。
+// 同一名字的定值按“到达同一引用”合并成网（web），每个网改名为独立的版本 T<n>.<k>
+vector<TAC> splitTempWebs(const vector<TAC>& tac) {
+    map<string, vector<int>> defs;
+    for (int i = 0; i < (int)tac.size(); i++) {
+        string d = defOf(tac[i]);
+        if (isTempName(d)) defs[d].push_back(i);
+    }
+    bool needed = false;
+    for (const auto& kv : defs) if (kv.second.size() > 1) needed = true;
+    if (!needed) return tac;
+
+    CFG cfg(tac);
+    ReachingDefinitions reaching(cfg);
+    map<int, int> parent;   // 定值地址的并查集
+    function<int(int)> find = [&](int x) { return parent[x] == x ? x : parent[x] = find(parent[x]); };
+    for (const auto& kv : defs) for (int a : kv.second) parent[a] = a;
+
+    vector<TAC> out = tac;
+    vector<pair<int, string*>> useSites;   // (所属网的代表定值, 引用位置)
+    vector<int> useDef;
+    for (int i = 0; i < (int)out.size(); i++) {
+        for (string* name : { &out[i].arg1, &out[i].arg2 }) {
+            if (isJumpOp(out[i].op) && name == &out[i].arg2) continue;
+            auto it = defs.find(*name);
+            if (it == defs.end() || it->second.size() < 2) continue;
+            vector<int> r = reaching.reachingDefs(i, *name);
+            if (r.empty()) continue;
+            for (size_t k = 1; k < r.size(); k++) parent[find(r[k])] = find(r[0]);
+            useSites.push_back(make_pair(r[0], name));
+        }
+    }
+    for (const auto& u : useSites) *u.second = *u.second + "." + to_string(find(u.first));
+    for (const auto& kv : defs) {
+        if (kv.second.size() < 2) continue;
+        for (int a : kv.second) out[a].result = kv.first + "." + to_string(find(a));
+    }
+    return out;
+}
+
+int TACVM::addSlot(const string& name, SlotType type) {
+    VMSlot zero;
+    zero.i = 0;
+    if (type == SlotType::FLOAT) zero.f = 0.0f;
+    initial.push_back(zero);
+    types.push_back(type);
+    slotNames.push_back(name);
+    return (int)initial.size() - 1;
+}
+
+int TACVM::constSlot(const ConstVal& v) {
+    string key = formatConst(v);
+    auto it = constSlots.find(key);
+    if (it != constSlots.end()) return it->second;
+    int s = addSlot(key, v.isFloat ? SlotType::FLOAT : SlotType::INT);
+    if (v.isFloat) initial[s].f = v.f;
+    else initial[s].i = v.i;
+    return constSlots[key] = s;
+}
+
+SlotType TACVM::typeOfOperand(const string& name) const {
+    ConstVal c;
+    if (parseConst(name, c)) return c.isFloat ? SlotType::FLOAT : SlotType::INT;
+    return types[slotOf.at(name)];
+}
+
+int TACVM::numDynamicSlots() const {
+    int n = 0;
+    for (SlotType t : types) if (t == SlotType::DYN) n++;
+    return n;
+}
+
+// ============================================================================
+// 类型推断
+// ============================================================================
+// 声明过的变量类型固定；其余名称的类型是它全部定值结果类型的并（乐观迭代到不动点），
+// 可能未经赋值就被读取的名称（入口处活跃）还要并上初值 int 0。
+
+map<string, SlotType> inferNameTypes(const vector<TAC>& tac, const map<string, string>& varTypes) {
+    CFG cfg(tac);
+    LivenessAnalysis liveness(cfg);
+
+    map<string, SlotType> types;
+    set<string> declared;
+    auto ensure = [&](const string& name) {
+        if (name.empty() || isConstName(name) || types.count(name)) return;
+        auto it = varTypes.find(name);
+        SlotType t = SlotType::UNKNOWN;
+        if (it != varTypes.end()) {
+            t = it->second == "float" ? SlotType::FLOAT : SlotType::INT;
+            declared.insert(name);
+        } else if (liveness.liveAtBlockEntry(cfg.entry(), name)) {
+            t = SlotType::INT;
+        }
+        types[name] = t;
+    };
+    for (const auto& t : tac) {
+        ensure(t.arg1);
+        if (!isCondJumpOp(t.op)) ensure(t.arg2);
+        ensure(defOf(t));
+    }
+    auto typeOf = [&](const string& name) {
+        ConstVal c;
+        if (parseConst(name, c)) return c.isFloat ? SlotType::FLOAT : SlotType::INT;
+        return types.at(name);
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& t : tac) {
+            string d = defOf(t);
+            if (d.empty() || declared.count(d)) continue;
+            SlotType r;
+            string op = scalarOp(t.op);
+            if (isRelop(op) || op == "&&" || op == "||" || op == "!" || op == "ftoi") {
+                r = SlotType::INT;
+            } else if (isFloatOp(t.op) || op == "itof") {
+                r = SlotType::FLOAT;
+            } else if (op == ":=" || op == "neg") {
+                r = typeOf(t.arg1);
+            } else {
+                SlotType a = typeOf(t.arg1), b = typeOf(t.arg2);
+                if (a == SlotType::UNKNOWN || b == SlotType::UNKNOWN) continue;
+                if (a == SlotType::DYN || b == SlotType::DYN) r = SlotType::DYN;
+                else r = (a == SlotType::INT && b == SlotType::INT) ? SlotType::INT : SlotType::FLOAT;
+            }
+            SlotType nt = join(types[d], r);
+            if (nt != types[d]) {
+                types[d] = nt;
+                changed = true;
+            }
+        }
+    }
+    for (auto& kv : types) {
+        if (kv.second == SlotType::UNKNOWN) kv.second = SlotType::INT;
+    }
+    return types;
+}
+
+vector<string> checkTACTypes(const vector<TAC>& code, const map<string, string>& varTypes) {
+    vector<TAC> tac = splitTempWebs(code);
+    map<string, SlotType> types = inferNameTypes(tac, varTypes);
+    vector<string> problems;
+    for (const auto& kv : types) {
+        if (kv.second == SlotType::DYN) problems.push_back("名字 " + kv.first + " 先后具有 int 和 float 两种类型");
+    }
+    auto typeOf = [&](const string& name) {
+        ConstVal c;
+        if (parseConst(name, c)) return c.isFloat ? SlotType::FLOAT : SlotType::INT;
+        return types.at(name);
+    };
+    auto typeName = [](SlotType t) {
+        return t == SlotType::FLOAT ? "float" : t == SlotType::INT ? "int" : "?";
+    };
+    for (int i = 0; i < (int)tac.size(); i++) {
+        const TAC& t = tac[i];
+        if (isJumpOp(t.op) || t.op == "decl") continue;
+        string op = scalarOp(t.op);
+        if (op == "&&" || op == "||" || op == "!") continue;   // 只看真假，操作数类型任意
+        SlotType want, result;
+        if (op == ":=") want = result = typeOf(t.result);
+        else if (op == "itof") { want = SlotType::INT; result = SlotType::FLOAT; }
+        else if (op == "ftoi") { want = SlotType::FLOAT; result = SlotType::INT; }
+        else {
+            want = isFloatOp(t.op) ? SlotType::FLOAT : SlotType::INT;
+            result = isRelop(op) ? SlotType::INT : want;
+        }
+        string where = "第 " + to_string(i) + " 条指令 '" + t.op + "'";
+        for (const string* a : { &t.arg1, &t.arg2 }) {
+            if (!a->empty() && typeOf(*a) != want) {
+                problems.push_back(where + " 的操作数 " + *a + " 为 " + typeName(typeOf(*a)) + "，应为 " + typeName(want));
+            }
+        }
+        if (typeOf(t.result) != result) {
+            problems.push_back(where + " 的结果 " + t.result + " 为 " + typeName(typeOf(t.result)) + "，应为 " + typeName(result));
+        }
+    }
+    return problems;
+}
+
+void TACVM::inferTypes(const vector<TAC>& tac, const map<string, string>& varTypes) {
+    map<string, SlotType> nameTypes = inferNameTypes(tac, varTypes);
+    // 槽位按名字首次出现的顺序分配
+    auto ensure = [&](const string& name) {
+        if (name.empty() || isConstName(name) || slotOf.count(name)) return;
+        slotOf[name] = addSlot(name, nameTypes.at(name));
+        if (!isTempName(name)) userSlots[name] = slotOf[name];
+    };
+    for (const auto& t : tac) {
+        ensure(t.arg1);
+        if (!isCondJumpOp(t.op)) ensure(t.arg2);
+        ensure(defOf(t));
+    }
+}
+
+// ============================================================================
+// 降级
+// ============================================================================
+
+void TACVM::emit(int op, int d, int a, int b, int x) {
+    VMInstr in;
+    in.op = op;
+    in.d = d;
+    in.a = a;
+    in.b = b;
+    in.x = x;
+    code.push_back(in);
+}
+
+// 取操作数的槽位，需要 float 而操作数是 int 时转换到中间槽位（常量直接换成 float 常量）
+int TACVM::operandAs(const string& name, SlotType want, int which) {
+    ConstVal c;
+    if (parseConst(name, c)) return constSlot(want == SlotType::FLOAT ? convertConst(c, true) : c);
+    int s = slotOf.at(name);
+    if (want != SlotType::FLOAT || types[s] == SlotType::FLOAT) return s;
+    if (scratch[which] < 0) scratch[which] = addSlot("$f" + to_string(which), SlotType::FLOAT);
+    emit(OP_ITOF, scratch[which], s, 0);
+    return scratch[which];
+}
+
+void TACVM::lower(const vector<TAC>& tac) {
+    int n = (int)tac.size();
+    vector<bool> isTarget(n + 1, false);
+    map<string, int> useCount, defCount;
+    for (const auto& t : tac) {
+        if (isJumpOp(t.op)) {
+            int a = labelAddr(t.result);
+            if (a >= 0 && a < n) isTarget[a] = true;
+        }
+        for (const auto& u : usesOf(t)) useCount[u]++;
+        string d = defOf(t);
+        if (!d.empty()) defCount[d]++;
+    }
+    // 只定值、只引用各一次且引用紧跟在定值之后（中间不是跳转目标）的临时变量可以融合掉
+    auto fusable = [&](int i) {
+        if (i + 1 >= n || isTarget[i + 1]) return false;
+        const string& d = tac[i].result;
+        if (!isTempName(d) || defCount[d] != 1 || useCount[d] != 1) return false;
+        vector<string> u = usesOf(tac[i + 1]);
+        return find(u.begin(), u.end(), d) != u.end();
+    };
+
+    // 把结果类型为 r 的运算写到 dst：类型一致时直接写，否则经中间槽位转换
+    int intScratch = -1;
+    auto resultSlot = [&](const string& dst, SlotType r) {
+        int s = slotOf.at(dst);
+        if (types[s] == r) return s;
+        if (r == SlotType::INT) {
+            if (intScratch < 0) intScratch = addSlot("$i", SlotType::INT);
+            return intScratch;
+        }
+        if (scratch[0] < 0) scratch[0] = addSlot("$f0", SlotType::FLOAT);
+        return scratch[0];
+    };
+    auto finishResult = [&](const string& dst, int written) {
+        int s = slotOf.at(dst);
+        if (s == written) return;
+        emit(types[s] == SlotType::FLOAT ? OP_ITOF : OP_FTOI, s, written, 0);
+    };
+
+    vector<int> pcOf(n + 1, 0);
+    vector<int> sourceOf;   // 每条字节码对应的 TAC 地址（用于运行时错误信息）
+    for (int i = 0; i < n; i++) {
+        pcOf[i] = (int)code.size();
+        size_t first = code.size();
+        const TAC& t = tac[i];
+
+        // 含 DYN 槽位的指令走通用路径
+        bool dynamic = false;
+        if (!isJumpOp(t.op)) {
+            for (const string* name : { &t.arg1, &t.arg2, &t.result }) {
+                if (!name->empty() && !isConstName(*name) && types[slotOf.at(*name)] == SlotType::DYN) dynamic = true;
+            }
+        } else if (isCondJumpOp(t.op) && !isConstName(t.arg1)) {
+            dynamic = types[slotOf.at(t.arg1)] == SlotType::DYN;
+        }
+
+        auto operandSlot = [&](const string& name) {
+            ConstVal c;
+            return parseConst(name, c) ? constSlot(c) : slotOf.at(name);
+        };
+
+        if (t.op == "goto") {
+            emit(OP_GOTO, 0, 0, 0, labelAddr(t.result));
+        } else if (isCondJumpOp(t.op)) {
+            ConstVal c;
+            bool jz = t.op == "jz";
+            if (parseConst(t.arg1, c)) {
+                if (jz == c.isZero()) emit(OP_GOTO, 0, 0, 0, labelAddr(t.result));
+            } else if (dynamic) {
+                emit(jz ? OP_GJZ : OP_GJNZ, 0, slotOf.at(t.arg1), 0, labelAddr(t.result));
+            } else {
+                bool isFloat = types[slotOf.at(t.arg1)] == SlotType::FLOAT;
+                int op = isFloat ? (jz ? OP_JZF : OP_JNZF) : (jz ? OP_JZI : OP_JNZI);
+                emit(op, 0, slotOf.at(t.arg1), 0, labelAddr(t.result));
+            }
+        } else if (dynamic) {
+            int b = t.arg2.empty() ? -1 : operandSlot(t.arg2);
+            emit(OP_GEN, slotOf.at(t.result), operandSlot(t.arg1), b, genericIndex(t.op));
+        } else if (t.op == ":=" || isConversionOp(t.op)) {
+            // itof / ftoi 的结果槽位类型就是转换的目标类型，与赋值时的转换相同
+            int d = slotOf.at(t.result);
+            ConstVal c;
+            if (parseConst(t.arg1, c)) {
+                emit(OP_MOV, d, constSlot(convertConst(c, types[d] == SlotType::FLOAT)), 0);
+            } else {
+                int s = slotOf.at(t.arg1);
+                int op = types[d] == types[s] ? OP_MOV : types[d] == SlotType::FLOAT ? OP_ITOF : OP_FTOI;
+                emit(op, d, s, 0);
+            }
+        } else if (isRelop(t.op) && fusable(i) && isCondJumpOp(tac[i + 1].op) &&
+                   typeOfOperand(t.arg1) == SlotType::INT && typeOfOperand(t.arg2) == SlotType::INT) {
+            // T := a < b; jz T, L  ==>  JGEI a, b, L
+            int rel = relIndex(t.op);
+            if (tac[i + 1].op == "jz") rel = negatedRel[rel];
+            emit(OP_JLTI + rel, 0, operandSlot(t.arg1), operandSlot(t.arg2), labelAddr(tac[i + 1].result));
+            sourceOf.push_back(i);
+            pcOf[++i] = (int)code.size();
+            continue;
+        } else {
+            // 计算类指令：float 运算符直接选 float 指令，其余按操作数类型确定运算类型和结果类型
+            string sop = scalarOp(t.op);
+            SlotType a = typeOfOperand(t.arg1);
+            SlotType b = t.arg2.empty() ? a : typeOfOperand(t.arg2);
+            SlotType work = (isFloatOp(t.op) || a == SlotType::FLOAT || b == SlotType::FLOAT) ? SlotType::FLOAT : SlotType::INT;
+            SlotType r = (isArith(sop) || sop == "neg") ? work : SlotType::INT;
+            int op;
+            if (isArith(sop)) {
+                static const int iops[] = { OP_ADDI, OP_SUBI, OP_MULI, OP_DIVI };
+                int k = sop == "+" ? 0 : sop == "-" ? 1 : sop == "*" ? 2 : 3;
+                op = iops[k] + (work == SlotType::FLOAT ? OP_ADDF - OP_ADDI : 0);
+            } else if (isRelop(sop)) {
+                op = (work == SlotType::FLOAT ? OP_LTF : OP_LTI) + relIndex(sop);
+            } else if (sop == "neg") {
+                op = work == SlotType::FLOAT ? OP_NEGF : OP_NEGI;
+            } else if (t.op == "!") {
+                op = work == SlotType::FLOAT ? OP_NOTF : OP_NOTI;
+            } else if ((t.op == "&&" || t.op == "||") && work == SlotType::INT) {
+                op = t.op == "&&" ? OP_ANDI : OP_ORI;
+            } else {
+                op = OP_GEN;
+            }
+
+            if (op == OP_GEN) {
+                int b2 = t.arg2.empty() ? -1 : operandSlot(t.arg2);
+                emit(OP_GEN, slotOf.at(t.result), operandSlot(t.arg1), b2, genericIndex(t.op));
+            } else {
+                // 逻辑非按操作数自身的类型判断真假，不需要转换
+                SlotType want = (op == OP_NOTF || op == OP_NOTI) ? a : work;
+                int s1 = operandAs(t.arg1, want, 0);
+                int s2 = t.arg2.empty() ? 0 : operandAs(t.arg2, want, 1);
+                // T := a + b; x := T  ==>  x := a + b（x 与运算结果类型相同时）
+                string dst = t.result;
+                bool fuseCopy = fusable(i) && tac[i + 1].op == ":=" && tac[i + 1].arg1 == dst &&
+                                types[slotOf.at(tac[i + 1].result)] == r;
+                if (fuseCopy) dst = tac[i + 1].result;
+                int d = resultSlot(dst, r);
+                emit(op, d, s1, s2);
+                finishResult(dst, d);
+                if (fuseCopy) {
+                    for (size_t k = first; k < code.size(); k++) sourceOf.push_back(i);
+                    pcOf[++i] = (int)code.size();
+                    continue;
+                }
+            }
+        }
+        for (size_t k = first; k < code.size(); k++) sourceOf.push_back(i);
+    }
+    pcOf[n] = (int)code.size();
+    emit(OP_END, 0, 0, 0);
+    sourceOf.push_back(n);
+
+    // 跳转目标由 TAC 地址换成字节码 PC，超出范围的目标都指向 END
+    for (auto& in : code) {
+        bool jump = in.op == OP_GOTO || (in.op >= OP_JZI && in.op <= OP_JNEI) || in.op == OP_GJZ || in.op == OP_GJNZ;
+        if (jump) in.x = (in.x >= 0 && in.x < n) ? pcOf[in.x] : pcOf[n];
+    }
+    sourceAddr = sourceOf;
+    sourceOps.clear();
+    for (int s : sourceOf) sourceOps.push_back(s < n ? tac[s].op : "");
+}
+
+// ============================================================================
+// 执行
+// ============================================================================
+
+ConstVal TACVM::loadSlot(int k, const VMSlot* s, const uint8_t* tags) const {
+    ConstVal v;
+    v.isFloat = types[k] == SlotType::FLOAT || (types[k] == SlotType::DYN && tags[k]);
+    if (v.isFloat) v.f = s[k].f;
+    else v.i = s[k].i;
+    return v;
+}
+
+bool TACVM::execGeneric(const VMInstr& in, VMSlot* s, uint8_t* tags) const {
+    ConstVal r;
+    const char* op = genericOps[in.x];
+    bool ok = in.b < 0 ? foldUnary(op, loadSlot(in.a, s, tags), r)
+                       : foldBinary(op, loadSlot(in.a, s, tags), loadSlot(in.b, s, tags), r);
+    if (!ok) return false;
+    int k = in.d;
+    if (types[k] == SlotType::DYN) tags[k] = r.isFloat;
+    else r = convertConst(r, types[k] == SlotType::FLOAT);
+    if (r.isFloat) s[k].f = r.f;
+    else s[k].i = r.i;
+    return true;
+}
+
+string TACVM::errorAt(int pc) const {
+    return "第 " + to_string(sourceAddr[pc]) + " 条指令 '" + sourceOps[pc] + "' 无法求值（除零或结果溢出）";
+}
+
+void TACVM::collectVars(VMResult& res, const VMSlot* s, const uint8_t* tags) const {
+    for (const auto& kv : userSlots) res.vars[kv.first] = loadSlot(kv.second, s, tags);
+}
+
+VMResult TACVM::run(long long branchLimit) {
+    VMResult res;
+    vector<VMSlot> slotv = initial;
+    vector<uint8_t> tags(initial.size(), 0);   // DYN 槽位当前是否为 float
+    VMSlot* s = slotv.data();
+    const VMInstr* base = code.data();
+    const VMInstr* ip = base;
+    long long budget = branchLimit;
+
+    uint8_t* tg = tags.data();
+    auto load = [&](int k) { return loadSlot(k, s, tg); };
+    auto generic = [&](const VMInstr& in) { return execGeneric(in, s, tg); };
+
+#ifdef VM_THREADED
+    static const void* const labels[OP_COUNT] = {
+        &&L_OP_END, &&L_OP_MOV, &&L_OP_ITOF, &&L_OP_FTOI,
+        &&L_OP_ADDI, &&L_OP_SUBI, &&L_OP_MULI, &&L_OP_DIVI, &&L_OP_NEGI, &&L_OP_NOTI,
+        &&L_OP_ADDF, &&L_OP_SUBF, &&L_OP_MULF, &&L_OP_DIVF, &&L_OP_NEGF, &&L_OP_NOTF,
+        &&L_OP_LTI, &&L_OP_LEI, &&L_OP_GTI, &&L_OP_GEI, &&L_OP_EQI, &&L_OP_NEI,
+        &&L_OP_LTF, &&L_OP_LEF, &&L_OP_GTF, &&L_OP_GEF, &&L_OP_EQF, &&L_OP_NEF,
+        &&L_OP_ANDI, &&L_OP_ORI,
+        &&L_OP_GOTO, &&L_OP_JZI, &&L_OP_JNZI, &&L_OP_JZF, &&L_OP_JNZF,
+        &&L_OP_JLTI, &&L_OP_JLEI, &&L_OP_JGTI, &&L_OP_JGEI, &&L_OP_JEQI, &&L_OP_JNEI,
+        &&L_OP_GEN, &&L_OP_GJZ, &&L_OP_GJNZ,
+    };
+    if (!threaded) {
+        for (auto& in : code) in.handler = labels[in.op];
+        threaded = true;
+    }
+#define VM_CASE(name) L_##name:
+#define VM_NEXT() do { ++ip; goto *ip->handler; } while (0)
+#define VM_JUMP(pc) do { ip = base + (pc); goto *ip->handler; } while (0)
+    goto *ip->handler;
+#else
+#define VM_CASE(name) case name:
+#define VM_NEXT() do { ++ip; goto dispatch; } while (0)
+#define VM_JUMP(pc) do { ip = base + (pc); goto dispatch; } while (0)
+dispatch:
+    switch (ip->op) {
+#endif
+
+#define VM_BRANCH() do { if (--budget < 0) goto limit; } while (0)
+#define VM_INT_BINARY(name, expr) VM_CASE(name) { uint32_t x = (uint32_t)s[ip->a].i, y = (uint32_t)s[ip->b].i; \
+        s[ip->d].i = (int32_t)(expr); VM_NEXT(); }
+#define VM_FLOAT_BINARY(name, opr) VM_CASE(name) { float r = s[ip->a].f opr s[ip->b].f; \
+        if (!std::isfinite(r)) { goto runtimeError; } s[ip->d].f = r; VM_NEXT(); }
+#define VM_COMPARE(name, field, opr) VM_CASE(name) { s[ip->d].i = s[ip->a].field opr s[ip->b].field; VM_NEXT(); }
+#define VM_COMPARE_JUMP(name, opr) VM_CASE(name) { VM_BRANCH(); \
+        if (s[ip->a].i opr s[ip->b].i) { VM_JUMP(ip->x); } VM_NEXT(); }
+
+    VM_CASE(OP_END) goto done;
+    VM_CASE(OP_MOV) { s[ip->d] = s[ip->a]; VM_NEXT(); }
+    VM_CASE(OP_ITOF) { s[ip->d].f = (float)s[ip->a].i; VM_NEXT(); }
+    VM_CASE(OP_FTOI) { s[ip->d].i = (int32_t)s[ip->a].f; VM_NEXT(); }
+
+    VM_INT_BINARY(OP_ADDI, x + y)
+    VM_INT_BINARY(OP_SUBI, x - y)
+    VM_INT_BINARY(OP_MULI, x * y)
+    VM_CASE(OP_DIVI) {
+        int32_t x = s[ip->a].i, y = s[ip->b].i;
+        if (y == 0 || (x == INT32_MIN && y == -1)) goto runtimeError;
+        s[ip->d].i = x / y;
+        VM_NEXT();
+    }
+    VM_CASE(OP_NEGI) { s[ip->d].i = (int32_t)(0u - (uint32_t)s[ip->a].i); VM_NEXT(); }
+    VM_CASE(OP_NOTI) { s[ip->d].i = s[ip->a].i == 0; VM_NEXT(); }
+
+    VM_FLOAT_BINARY(OP_ADDF, +)
+    VM_FLOAT_BINARY(OP_SUBF, -)
+    VM_FLOAT_BINARY(OP_MULF, *)
+    VM_FLOAT_BINARY(OP_DIVF, /)
+    VM_CASE(OP_NEGF) { s[ip->d].f = -s[ip->a].f; VM_NEXT(); }
+    VM_CASE(OP_NOTF) { s[ip->d].i = s[ip->a].f == 0.0f; VM_NEXT(); }
+
+    VM_COMPARE(OP_LTI, i, <)
+    VM_COMPARE(OP_LEI, i, <=)
+    VM_COMPARE(OP_GTI, i, >)
+    VM_COMPARE(OP_GEI, i, >=)
+    VM_COMPARE(OP_EQI, i, ==)
+    VM_COMPARE(OP_NEI, i, !=)
+    VM_COMPARE(OP_LTF, f, <)
+    VM_COMPARE(OP_LEF, f, <=)
+    VM_COMPARE(OP_GTF, f, >)
+    VM_COMPARE(OP_GEF, f, >=)
+    VM_COMPARE(OP_EQF, f, ==)
+    VM_COMPARE(OP_NEF, f, !=)
+    VM_CASE(OP_ANDI) { s[ip->d].i = s[ip->a].i != 0 && s[ip->b].i != 0; VM_NEXT(); }
+    VM_CASE(OP_ORI) { s[ip->d].i = s[ip->a].i != 0 || s[ip->b].i != 0; VM_NEXT(); }
+
+    VM_CASE(OP_GOTO) { VM_BRANCH(); VM_JUMP(ip->x); }
+    VM_CASE(OP_JZI) { VM_BRANCH(); if (s[ip->a].i == 0) { VM_JUMP(ip->x); } VM_NEXT(); }
+    VM_CASE(OP_JNZI) { VM_BRANCH(); if (s[ip->a].i != 0) { VM_JUMP(ip->x); } VM_NEXT(); }
+    VM_CASE(OP_JZF) { VM_BRANCH(); if (s[ip->a].f == 0.0f) { VM_JUMP(ip->x); } VM_NEXT(); }
+    VM_CASE(OP_JNZF) { VM_BRANCH(); if (s[ip->a].f != 0.0f) { VM_JUMP(ip->x); } VM_NEXT(); }
+    VM_COMPARE_JUMP(OP_JLTI, <)
+    VM_COMPARE_JUMP(OP_JLEI, <=)
+    VM_COMPARE_JUMP(OP_JGTI, >)
+    VM_COMPARE_JUMP(OP_JGEI, >=)
+    VM_COMPARE_JUMP(OP_JEQI, ==)
+    VM_COMPARE_JUMP(OP_JNEI, !=)
+
+    VM_CASE(OP_GEN) { if (!generic(*ip)) goto runtimeError; VM_NEXT(); }
+    VM_CASE(OP_GJZ) { VM_BRANCH(); if (load(ip->a).isZero()) { VM_JUMP(ip->x); } VM_NEXT(); }
+    VM_CASE(OP_GJNZ) { VM_BRANCH(); if (!load(ip->a).isZero()) { VM_JUMP(ip->x); } VM_NEXT(); }
+
+#ifndef VM_THREADED
+    default: goto done;
+    }
+#endif
+
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_JUMP
+#undef VM_BRANCH
+#undef VM_INT_BINARY
+#undef VM_FLOAT_BINARY
+#undef VM_COMPARE
+#undef VM_COMPARE_JUMP
+
+runtimeError: {
+        res.ok = false;
+        res.error = errorAt((int)(ip - base));
+        goto done;
+    }
+limit:
+    res.limitHit = true;
+    budget = 0;
+done:
+    res.branches = branchLimit - max(budget, 0LL);
+    collectVars(res, s, tg);
+    return res;
+}
+
+void TACVM::print(OutputSink& out) const {
+    auto slotName = [&](int k) { return "[" + slotNames[k] + "]"; };
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        const VMInstr& in = code[pc];
+        out << padRight(pc, 4) << "  " << pad(opNames[in.op], 6);
+        switch (in.op) {
+        case OP_END:
+            break;
+        case OP_GOTO:
+            out << "-> " << in.x;
+            break;
+        case OP_JZI: case OP_JNZI: case OP_JZF: case OP_JNZF: case OP_GJZ: case OP_GJNZ:
+            out << slotName(in.a) << " -> " << in.x;
+            break;
+        case OP_JLTI: case OP_JLEI: case OP_JGTI: case OP_JGEI: case OP_JEQI: case OP_JNEI:
+            out << slotName(in.a) << ", " << slotName(in.b) << " -> " << in.x;
+            break;
+        case OP_GEN:
+            out << slotName(in.d) << " = " << genericOps[in.x] << " " << slotName(in.a);
+            if (in.b >= 0) out << ", " << slotName(in.b);
+            break;
+        case OP_MOV: case OP_ITOF: case OP_FTOI: case OP_NEGI: case OP_NEGF: case OP_NOTI: case OP_NOTF:
+            out << slotName(in.d) << " = " << slotName(in.a);
+            break;
+        default:
+            out << slotName(in.d) << " = " << slotName(in.a) << ", " << slotName(in.b);
+            break;
+        }
+        out << '\n';
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef VM_H
+#define VM_H
+
+#include "types.h"
+#include "outsink.h"
+#include "tacutil.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+
+// === 寄存器式字节码虚拟机 ===
+// 把三地址码降为紧凑的字节码：变量、临时变量和常量都放在编号的槽位中，
+// 跳转标号解析为整数 PC。按槽位的静态类型选择 int/float 专用指令，
+// “T := a < b; jz T” 融合为一条比较跳转，“T := a + b; x := T” 直接写入 x。
+// GCC/Clang 下用计算跳转（direct threading）分派，其余编译器退回 switch。
+// 语义与参考求值器（evaluator）一致：int 为 32 位补码回绕，float 为单精度，
+// 声明过类型的变量赋值时转换，未赋值的变量读作 0，整数除零和非有限浮点结果是运行时错误。
+
+// 槽位的静态类型：未声明变量先后被赋予 int 和 float 值时为 DYN，运行时带类型标记
+enum class SlotType : uint8_t { UNKNOWN, INT, FLOAT, DYN };
+
+// 字节码操作码；算术与比较按 int/float 各有一组，J<rel>I 为融合的比较跳转
+enum VMOp : int32_t {
+    OP_END, OP_MOV, OP_ITOF, OP_FTOI,
+    OP_ADDI, OP_SUBI, OP_MULI, OP_DIVI, OP_NEGI, OP_NOTI,
+    OP_ADDF, OP_SUBF, OP_MULF, OP_DIVF, OP_NEGF, OP_NOTF,
+    OP_LTI, OP_LEI, OP_GTI, OP_GEI, OP_EQI, OP_NEI,
+    OP_LTF, OP_LEF, OP_GTF, OP_GEF, OP_EQF, OP_NEF,
+    OP_ANDI, OP_ORI,
+    OP_GOTO, OP_JZI, OP_JNZI, OP_JZF, OP_JNZF,
+    OP_JLTI, OP_JLEI, OP_JGTI, OP_JGEI, OP_JEQI, OP_JNEI,  // 满足关系时跳转
+    OP_GEN, OP_GJZ, OP_GJNZ,                               // 含 DYN 槽位的通用运算与跳转
+    OP_COUNT
+};
+
+// 把复用的临时变量按定值网拆成独立的版本 T<n>.<k>，避免 int/float 结果共用一个名字
+vector<TAC> splitTempWebs(const vector<TAC>& tac);
+
+// 按名字推断静态类型（虚拟机与各后端共用，规则见 vm.cpp 的“类型推断”）
+map<string, SlotType> inferNameTypes(const vector<TAC>& tac, const map<string, string>& varTypes);
+
+// 类型检查：每个名字只有一种类型，算术/关系运算的操作数与运算符的 int/float 类型一致，
+// := 两侧类型相同，itof / ftoi 的操作数与结果类型正确；返回发现的问题（空表示通过）
+vector<string> checkTACTypes(const vector<TAC>& tac, const map<string, string>& varTypes);
+
+union VMSlot {
+    int32_t i;
+    float f;
+};
+
+struct VMInstr {
+    const void* handler = nullptr;  // 计算跳转分派时的处理代码地址（首次运行时填入）
+    int32_t op = 0;
+    int32_t d = 0, a = 0, b = 0;    // 目标槽位与两个操作数槽位
+    int32_t x = 0;                  // 跳转目标 PC，或通用指令的运算符编号
+};
+
+struct VMResult {
+    bool ok = true;
+    bool limitHit = false;          // 跳转次数达到上限（例如 while(true)）
+    string error;
+    long long branches = 0;         // 执行的跳转指令条数（含融合的比较跳转）
+    map<string, ConstVal> vars;     // 结束时的用户变量
+};
+
+class TACVM {
+    friend class TACJit;    // 本机代码编译器直接读取字节码和槽位布局
+
+private:
+    vector<VMInstr> code;
+    vector<VMSlot> initial;         // 槽位初值：变量为 0，常量槽位为常量值
+    vector<SlotType> types;
+    vector<string> slotNames;
+    map<string, int> userSlots;     // 用户变量名 -> 槽位
+    vector<int> sourceAddr;         // 每条字节码对应的 TAC 地址，用于运行时错误信息
+    vector<string> sourceOps;
+    bool threaded = false;          // code[].handler 是否已填好
+
+    // 降级时使用的状态
+    map<string, int> slotOf;
+    map<string, int> constSlots;
+    int scratch[2] = { -1, -1 };    // 混合运算时 int -> float 转换的中间槽位
+
+    int addSlot(const string& name, SlotType type);
+    int constSlot(const ConstVal& v);
+    SlotType typeOfOperand(const string& name) const;
+    void inferTypes(const vector<TAC>& tac, const map<string, string>& varTypes);
+    void lower(const vector<TAC>& tac);
+    int operandAs(const string& name, SlotType want, int which);
+    void emit(int op, int d, int a, int b, int x = 0);
+
+    // 执行期辅助：按槽位类型（DYN 看类型标记）读取，以及通用指令的求值
+    ConstVal loadSlot(int k, const VMSlot* s, const uint8_t* tags) const;
+    bool execGeneric(const VMInstr& in, VMSlot* s, uint8_t* tags) const;
+    string errorAt(int pc) const;
+    void collectVars(VMResult& res, const VMSlot* s, const uint8_t* tags) const;
+
+public:
+    TACVM(const vector<TAC>& tac, const map<string, string>& varTypes);
+
+    // 从槽位初值开始执行一次，branchLimit 为跳转次数上限
+    VMResult run(long long branchLimit = 100000000);
+
+    int numInstructions() const { return (int)code.size(); }
+    int numSlots() const { return (int)initial.size(); }
+    int numDynamicSlots() const;
+    void print(OutputSink& out) const;     // 输出字节码
+};
+
+#endif // VM_H